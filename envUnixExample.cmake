@@ -1,2 +1,2 @@
-# Optional set TINYOBJ_PATH to target specific version, otherwise defaults to external/tinyobjloader
-# set(TINYOBJ_PATH /Users/brendan/dev/tinyobjloader)
\ No newline at end of file
+# Optional set VULKAN_SDK_PATH / GLFW_PATH to target specific versions, otherwise find_package is used
+# set(VULKAN_SDK_PATH /Users/brendan/dev/VulkanSDK/macOS)
\ No newline at end of file
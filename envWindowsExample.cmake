@@ -5,6 +5,3 @@ set(VULKAN_SDK_PATH  X:/VulkanSDK/1.2.182.0)
  
 # Set MINGW_PATH if using mingwBuild.bat and not VisualStudio20XX
 # set(MINGW_PATH "C:/Program Files/mingw-w64/x86_64-8.1.0-posix-seh-rt_v6-rev0/mingw64")
- 
-# Optional set TINYOBJ_PATH to target specific version, otherwise defaults to external/tinyobjloader
-# set(TINYOBJ_PATH X:/dev/Libraries/tinyobjloader)
\ No newline at end of file
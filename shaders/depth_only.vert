@@ -0,0 +1,32 @@
+#version 450
+
+// Depth prepass for Model::Vertex, only the position is fetched
+layout(location = 0) in vec3 position;
+
+// same computation as simple_shader.vert, the main pass tests for EQUAL depth
+invariant gl_Position;
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo{
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor; // w is intensity
+    PointLight pointLights[10];
+    int numLights;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;
+    mat3 normalMatrix;
+    uint materialIndex;
+} push;
+
+void main() {
+    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+}
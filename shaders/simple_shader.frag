@@ -1,8 +1,10 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUv;
 
 layout(location = 0) out vec4 outColor;
 
@@ -21,13 +23,32 @@ layout(set = 0, binding = 0) uniform GlobalUbo{
     int numLights;
 } ubo;
 
+struct Material {
+    vec4 baseColorFactor;
+    uint albedoTexture;
+    float specularStrength;
+    float shininess;
+    float padding;
+};
+
+// bindless: every texture and material, selected per draw by index
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+} materialBuffer;
+
 layout(push_constant) uniform Push {
     mat4 modelMatrix; // projection * view * model
-    mat4 normalMatrix;
+    mat3 normalMatrix; // columns padded to vec4 (std430)
+    uint materialIndex;
 } push;
 
 void main()
 {
+    Material material = materialBuffer.materials[push.materialIndex];
+    vec4 albedo = texture(textures[nonuniformEXT(material.albedoTexture)], fragUv) * material.baseColorFactor;
+    vec3 surfaceColor = fragColor * albedo.rgb;
+
     vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
     vec3 specularLight = vec3(0.0);
     vec3 surfaceNormal = normalize(fragNormalWorld);
@@ -51,13 +72,13 @@ void main()
         vec3 halfAngle = normalize(directionToLight + viewDirection);
         float blinnTerm = dot(surfaceNormal, halfAngle);
         blinnTerm = clamp(blinnTerm, 0, 1);
-        blinnTerm = pow(blinnTerm, 32.0); // higher values -> sharper highlight
-        specularLight += intensity * blinnTerm;
+        blinnTerm = pow(blinnTerm, material.shininess); // higher values -> sharper highlight
+        specularLight += intensity * blinnTerm * material.specularStrength;
     }
     
     //only works correctly if scale is uniform (=1 in all axes)
     //vec3 normalWorldSpace = normalize(mat3(push.modelMatrix) * normal);
     //calculating the inverse in a shader can be expensive and should be avoided
     //mat3 normalMatrix = transpose(inverse(mat3(push.modelMatrix)));
-    outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
+    outColor = vec4(diffuseLight * surfaceColor + specularLight * surfaceColor, albedo.a);
 }
\ No newline at end of file
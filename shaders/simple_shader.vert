@@ -8,6 +8,10 @@ layout(location = 3) in vec2 uv;
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUv;
+
+// the depth prepass (depth_only.vert) must produce the very same depths for the EQUAL test
+invariant gl_Position;
 
 struct PointLight {
     vec4 position; // ignore w
@@ -25,7 +29,8 @@ layout(set = 0, binding = 0) uniform GlobalUbo{
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix; // projection * view * model
-    mat4 normalMatrix;
+    mat3 normalMatrix; // columns padded to vec4 (std430)
+    uint materialIndex;
 } push;
 
 void main() {
@@ -35,8 +40,9 @@ void main() {
     // gl_Position = vec4(push.transform * position + push.offset, 0.0, 1.0);
     gl_Position = ubo.projection * ubo.view * positionWorld; // 1 = homogeneous coordinates
 
-    fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+    fragNormalWorld = normalize(push.normalMatrix * normal);
     fragPosWorld = positionWorld.xyz;
     fragColor = color;
+    fragUv = uv;
 
 }
\ No newline at end of file
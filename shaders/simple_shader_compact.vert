@@ -0,0 +1,53 @@
+#version 450
+
+// Model::CompactVertex, position is in [0, 1] of the mesh bounds, the model matrix maps it back
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 octNormal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUv;
+
+// the depth prepass (depth_only_compact.vert) must produce the very same depths for the EQUAL test
+invariant gl_Position;
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo{
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor; // w is intensity
+    PointLight pointLights[10];
+    int numLights;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix; // model * dequantize
+    mat3 normalMatrix; // columns padded to vec4 (std430)
+    uint materialIndex;
+} push;
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec4 positionWorld = push.modelMatrix * vec4(position.xyz, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+
+    fragNormalWorld = normalize(push.normalMatrix * octahedralDecode(octNormal));
+    fragPosWorld = positionWorld.xyz;
+    fragColor = color.rgb;
+    fragUv = uv;
+}
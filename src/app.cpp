@@ -11,23 +11,51 @@
 #include <iostream>
 #include <chrono>
 #include <numeric>
+#include <filesystem>
 
 #include "buffer.hpp"
+#include "asset_archive.hpp"
+#include "render_thread.hpp"
+#include "render_graph.hpp"
 
 namespace Cosmos {
 
 
 
-    Application::Application()
+    Application::Application() : Application{Settings{}} {}
+
+    Application::Application(const Settings& settings) : settings{settings}
     {
+        const uint32_t framesInFlight = renderer.getFramesInFlight();
+
+        // cooked assets packed with AssetPacker (AssetPacker ../assets.pak ..) replace the loose files
+        if(std::filesystem::exists("../assets.pak")) {
+            AssetArchive::mount("../assets.pak", "..");
+        }
+
         /*
         Method Chaining (Цепочка вызовов) или Fluent Interface (Текучий интерфейс). 
         Чаще всего он используется в паттерне проектирования Builder (Строитель).
         */
-        globalPool = DescriptorPool::Builder(engineDevice)
-            .setMaxSets(EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
+        globalDescriptorAllocator = DescriptorAllocator::Builder(engineDevice)
+            .setInitialSets(framesInFlight)
+            .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f)
             .build();
+
+        frameDescriptorAllocators.resize(framesInFlight);
+        for(auto& allocator : frameDescriptorAllocators)
+        {
+            allocator = DescriptorAllocator::Builder(engineDevice)
+                .setInitialSets(256)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.f)
+                .addPoolSizeRatio(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f)
+                .build();
+        }
+
+        materialSystem = std::make_unique<MaterialSystem>(engineDevice, descriptorLayoutCache, framesInFlight);
+        textureStreamer = std::make_unique<TextureStreamer>(engineDevice, *materialSystem, framesInFlight);
+        assetManager = std::make_unique<AssetManager>(engineDevice);
         
         // firsly load models
         loadGameObjects();
@@ -40,9 +68,10 @@ namespace Cosmos {
 
     void Application::run() 
     {
+        const uint32_t framesInFlight = renderer.getFramesInFlight();
 
         // NonCoherentAtomSize bug fix
-        std::vector<std::unique_ptr<Buffer>> uboBuffers(EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<std::unique_ptr<Buffer>> uboBuffers(framesInFlight);
         for(int i = 0; i < uboBuffers.size(); i++)
         {
             uboBuffers[i] = std::make_unique<Buffer>(
@@ -57,22 +86,25 @@ namespace Cosmos {
 
         auto globalSetLayout = DescriptorSetLayout::Builder(engineDevice)
             .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-            .build();
+            .build(descriptorLayoutCache);
     
 
-        std::vector<VkDescriptorSet> globalDescriptorSets(EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkDescriptorSet> globalDescriptorSets(framesInFlight);
         for(int i = 0; i < globalDescriptorSets.size(); i++) {
             auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            DescriptorWriter(*globalSetLayout, *globalPool)
+            DescriptorWriter(*globalSetLayout, *globalDescriptorAllocator)
                 .writeBuffer(0, &bufferInfo)
                 .build(globalDescriptorSets[i]);
         }
         
         SimpleRenderSystem simpleRenderSystem{engineDevice, 
-            renderer.getSwapChainRenderPass(), 
-            globalSetLayout->getDescriptorSetLayout()};
+            renderer.getSwapChainRenderTarget(), 
+            globalSetLayout->getDescriptorSetLayout(),
+            materialSystem->getDescriptorSetLayout(),
+            settings.depthPrepass};
+        MeshletCullSystem meshletCullSystem{engineDevice, descriptorLayoutCache, framesInFlight};
         PointLightSystem pointLightSystem{engineDevice, 
-            renderer.getSwapChainRenderPass(), 
+            renderer.getSwapChainRenderTarget(), 
             globalSetLayout->getDescriptorSetLayout()};
         
         Camera camera{};
@@ -81,13 +113,94 @@ namespace Cosmos {
         auto viewerObject = GameObject::createGameObject();
         viewerObject.transform.translation.z = -2.5f;
         KeyboardMovementController cameraController{};
+        worldPartition->loadAround(viewerObject.transform.translation);
+
+        // viewer and light movement tick at a fixed rate on their own thread, input is sampled here
+        Simulation simulation{viewerObject.transform, cameraController};
+        simulation.syncLights(gameObjects);
+
+        // waits for the presents of the render thread, reports latency and jitter
+        FramePacer framePacer{[&](const FrameTimestamps& frame) {
+            const uint64_t timeout = 100'000'000; // ns, a frame that takes longer is measured at its present call
+            return renderer.waitForPresent(frame.swapChainGeneration, frame.presentId, timeout);
+        }, settings.framePacing};
+
+        RenderGraph renderGraph{engineDevice, framesInFlight};
+
+        // records frame N while the loop below builds frame N+1, touches no game object
+        RenderThread renderThread{[&](FramePacket& packet)
+        {
+            auto commandBuffer = renderer.beginFrame();
+            if(!commandBuffer) return;
+
+            int frameIndex = renderer.getFrameIndex();
+            // the last submit of this frame slot has completed, its transient sets are free again
+            frameDescriptorAllocators[frameIndex]->resetPools();
+            assetManager->update();
+
+            requestTextureResolutions(packet);
+
+            FrameInfo frameInfo{frameIndex, packet.frameTime, commandBuffer, packet.camera,
+                globalDescriptorSets[frameIndex], packet.objects, *frameDescriptorAllocators[frameIndex],
+                materialSystem->getDescriptorSet(frameIndex), renderer.getSwapChainExtent()};
+
+            uboBuffers[frameIndex]->writeToBuffer(&packet.ubo);
+            uboBuffers[frameIndex]->flush();
+
+            renderGraph.reset();
+            // the acquire semaphore is waited for at color output, the depth image was last written by an earlier frame
+            auto swapChainImage = renderGraph.importImage("swap chain", renderer.getSwapChainImage(),
+                renderer.getSwapChainImageView(), renderer.getSwapChainExtent(), VK_IMAGE_ASPECT_COLOR_BIT,
+                {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+            renderGraph.exportImage(swapChainImage, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+            auto depthImage = renderGraph.importImage("depth", renderer.getDepthImage(),
+                renderer.getDepthImageView(), renderer.getSwapChainExtent(), VK_IMAGE_ASPECT_DEPTH_BIT,
+                {RenderGraph::DEPTH_ATTACHMENT.stages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED});
+            auto meshletDraws = renderGraph.importBuffer("meshlet draws", VK_NULL_HANDLE);
+
+            // synchronizes its own copies, the new views land in this frame's material set
+            renderGraph.addPass("texture streaming",
+                [](RenderGraph::PassBuilder& builder) { builder.setSideEffects(); },
+                [&](VkCommandBuffer commandBuffer, const RenderGraph::PassResources&) {
+                    textureStreamer->update(commandBuffer, frameIndex);
+                    materialSystem->beginFrame(frameIndex);
+                });
+            renderGraph.addPass("meshlet cull",
+                [&](RenderGraph::PassBuilder& builder) { builder.write(meshletDraws, RenderGraph::COMPUTE_BUFFER_WRITE); },
+                [&](VkCommandBuffer, const RenderGraph::PassResources&) { meshletCullSystem.cull(frameInfo); });
+            renderGraph.addPass("forward",
+                [&](RenderGraph::PassBuilder& builder) {
+                    builder.read(meshletDraws, RenderGraph::INDIRECT_DRAW);
+                    builder.write(swapChainImage, RenderGraph::COLOR_ATTACHMENT);
+                    builder.write(depthImage, RenderGraph::DEPTH_ATTACHMENT);
+                },
+                [&](VkCommandBuffer commandBuffer, const RenderGraph::PassResources&) {
+                    renderer.beginSwapChainRenderPass(commandBuffer);
+                    // point lights are blended over the lit scene and tested against its depth
+                    simpleRenderSystem.renderGameObjects(frameInfo, &meshletCullSystem);
+                    pointLightSystem.render(frameInfo);
+                    renderer.endSwapChainRenderPass(commandBuffer);
+                });
+            renderGraph.execute(commandBuffer, frameIndex);
+
+            renderer.endFrame();
+
+            FrameTimestamps timestamps = renderer.getLastFrameTimestamps();
+            timestamps.frameNumber = packet.frameNumber;
+            timestamps.input = packet.inputTime;
+            framePacer.recordFrame(timestamps);
+        }};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+        uint64_t frameNumber = 0;
 
         // Main application loop goes here
         while (!window.shouldClose()) 
         {
+            // the limiter waits before input is polled, the input is as fresh as possible when the frame starts
+            framePacer.waitForNextFrame();
             window.pollEvents();
+            const auto inputTime = FrameTimestamps::Clock::now();
 
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
@@ -95,93 +208,115 @@ namespace Cosmos {
 
             frameTime = glm::min(frameTime, 120.f);
 
-            cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewerObject);
+            simulation.setInput(cameraController.sampleInput(window.getGLFWwindow()));
+            const Simulation::State simulated = simulation.interpolate();
+            viewerObject.transform = simulated.viewer;
+            for(const auto& light : simulated.lights)
+            {
+                auto it = gameObjects.find(light.id);
+                if(it != gameObjects.end()) it->second.transform = light.transform;
+            }
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+            worldPartition->update(viewerObject.transform.translation);
+            // lights of cells the partition just added start moving with the next tick
+            simulation.syncLights(gameObjects);
 
-            float aspect = renderer.getAspectRatio();
-            //camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
-            camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
-
-            if(auto commandBuffer = renderer.beginFrame())
+            // the swap chain belongs to the render thread, the window extent is what it gets recreated with
+            const VkExtent2D extent = window.getExtent();
+            if(extent.width == 0 || extent.height == 0)
             {
-                int frameIndex = renderer.getFrameIndex();
-                FrameInfo frameInfo{frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], gameObjects};
-
-                // update
-                GlobalUbo ubo{};
-                ubo.projection = camera.getProjection();
-                ubo.view = camera.getView();
-                ubo.inverseView = camera.getInverseView();
-                pointLightSystem.update(frameInfo, ubo); 
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
-
-                // render
-                renderer.beginSwapChainRenderPass(commandBuffer);
-                
-                // order here matters
-                simpleRenderSystem.renderGameObjects(frameInfo);
-                pointLightSystem.render(frameInfo);
-                
-                renderer.endSwapChainRenderPass(commandBuffer);
-                renderer.endFrame();
+                // minimized, nothing to render until the next window event
+                window.waitEvents();
+                continue;
             }
+
+            float aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+            const float fovY = glm::radians(50.f);
+            //camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
+            camera.setPerspectiveProjection(fovY, aspect, 0.1f, 100.f);
+
+            FramePacket packet = renderThread.acquirePacket();
+            packet.frameNumber = frameNumber++;
+            packet.inputTime = inputTime;
+            packet.frameTime = frameTime;
+            packet.fovY = fovY;
+            buildFramePacket(camera, packet);
+            renderThread.submit(std::move(packet));
         }
+        renderThread.waitIdle();
         // Fixes validation layer erros after closing app
         vkDeviceWaitIdle(engineDevice.device());
     }
 
-    void Application::loadGameObjects()
-    {   
-        //std::shared_ptr<Model> cube_model = createCubeModel_i(engineDevice, {0.f,0.f,0.f});
-        std::shared_ptr<Model> loaded_model = Model::createModelFromFile(engineDevice, "../models/flat_vase.obj");
-        
-        // TODO: Add here a macros or a separate fucntion
+    // Resolves everything the render thread needs from the game objects, which stay on this thread
+    void Application::buildFramePacket(const Camera& camera, FramePacket& packet)
+    {
+        packet.camera = camera;
+        const Frustum frustum = camera.getFrustum();
+        for(auto& kv : gameObjects)
+        {
+            auto& obj = kv.second;
+            if(obj.model == nullptr && obj.pointLight == nullptr) continue;
+
+            RenderObject object{obj.getId()};
+            object.modelMatrix = obj.transform.mat4();
+            const glm::vec3 scale = glm::abs(obj.transform.scale);
+            object.maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+            if(obj.model != nullptr)
+            {
+                // whole objects outside the view are dropped here, meshlets are culled later on the GPU
+                const glm::vec3 center = glm::vec3(object.modelMatrix * glm::vec4(obj.model->getBoundingCenter(), 1.f));
+                if(!frustum.intersectsSphere(center, obj.model->getBoundingRadius() * object.maxScale)) continue;
+                object.model = obj.model;
+                object.normalMatrix = obj.transform.normalMatrix();
+            }
+            object.position = obj.transform.translation;
+            object.color = obj.color;
+            object.materialIndex = obj.materialIndex;
+            if(obj.pointLight != nullptr)
+            {
+                // lights always go along, they shade the visible objects from outside the view too
+                object.pointLight = true;
+                object.lightIntensity = obj.pointLight->lightIntensity;
+                object.lightRadius = obj.transform.scale.x;
+            }
+            packet.objects.push_back(std::move(object));
+        }
 
-        auto flatVase = GameObject::createGameObject();
-        flatVase.model = loaded_model;
-        flatVase.transform.translation = {-0.5f, 0.5f, 0.f};
-        flatVase.transform.scale = glm::vec3(3.0f);
+        packet.ubo = GlobalUbo{};
+        packet.ubo.projection = camera.getProjection();
+        packet.ubo.view = camera.getView();
+        packet.ubo.inverseView = camera.getInverseView();
+        PointLightSystem::update(packet.objects, packet.ubo);
+    }
 
-        gameObjects.emplace(flatVase.getId(), std::move(flatVase));
-        
-        loaded_model = Model::createModelFromFile(engineDevice, "../models/smooth_vase.obj");
-        auto smoothVase = GameObject::createGameObject();
-        smoothVase.model = loaded_model;
-        smoothVase.transform.translation = {0.5f, 0.5f, 0.f};
-        smoothVase.transform.scale = glm::vec3(3.0f);
-
-        gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-
-        loaded_model = Model::createModelFromFile(engineDevice, "../models/quad.obj");
-        auto floor = GameObject::createGameObject();
-        floor.model = loaded_model;
-        floor.transform.translation = {0.0f, 0.5f, 0.0f};
-        floor.transform.scale = glm::vec3(3.0f);
-        
-        gameObjects.emplace(floor.getId(), std::move(floor));
-
-         std::vector<glm::vec3> lightColors{
-            {1.f, .1f, .1f},
-            {.1f, .1f, 1.f},
-            {.1f, 1.f, .1f},
-            {1.f, 1.f, .1f},
-            {.1f, 1.f, 1.f},
-            {1.f, 1.f, 1.f}  //
-        };
-        for(int i = 0; i < lightColors.size(); i++)
+    // Rough on screen size of every streamed texture: the object's scale is taken as its extent
+    void Application::requestTextureResolutions(const FramePacket& packet)
+    {
+        const float pixelsPerUnit = renderer.getSwapChainExtent().height / (2.f * glm::tan(packet.fovY * .5f));
+        const glm::vec3 cameraPosition = packet.camera.getPosition();
+        for(const auto& obj : packet.objects)
         {
-            auto pointLight = GameObject::makePointLight(0.2f);
-            pointLight.color = lightColors[i];
-            auto rotateLight = glm::rotate(
-                glm::mat4(1.f),
-                (i * glm::two_pi<float>()) / lightColors.size(),
-                {0.f, -1.f, 0.f}
-            );
-            pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -1.f, -1.f, 1.f));
-            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+            if(obj.model == nullptr) continue;
+            uint32_t textureIndex = materialSystem->getMaterial(obj.materialIndex).albedoTexture;
+            if(!textureStreamer->isStreamed(textureIndex)) continue;
+
+            float distance = glm::max(glm::length(obj.position - cameraPosition), 0.1f);
+            textureStreamer->requestResolution(textureIndex, obj.maxScale / distance * pixelsPerUnit);
         }
+    }
 
+    void Application::loadGameObjects()
+    {   
+        // text for authoring, SceneCooker turns it into the binary .cscene which loads the same way.
+        // Small cells so even the default scene streams, the viewer loads it in run()
+        WorldPartition::Settings worldSettings{};
+        worldSettings.cellSize = 4.f;
+        worldSettings.loadRadius = 8.f;
+        worldSettings.unloadRadius = 12.f;
+        worldSettings.materialCount = materialSystem->getMaterialCount();
+        worldPartition = std::make_unique<WorldPartition>("../scenes/default.scene", *assetManager, gameObjects,
+            worldSettings);
     }
 
 
@@ -11,6 +11,13 @@
 #include "camera.hpp"
 #include "keyboard_movement_controller.hpp"
 #include "descriptors.hpp"
+#include "material_system.hpp"
+#include "texture_streamer.hpp"
+#include "asset_manager.hpp"
+#include "world_partition.hpp"
+#include "simulation.hpp"
+#include "frame_info.hpp"
+#include "frame_pacer.hpp"
 
 namespace Cosmos {
 
@@ -20,7 +27,14 @@ namespace Cosmos {
         static constexpr int WIDTH = 1200;
         static constexpr int HEIGHT = 800;
 
+        struct Settings {
+            EngineSwapChain::Settings swapChain{};
+            FramePacer::Settings framePacing{};
+            bool depthPrepass = false; // see SimpleRenderSystem
+        };
+
         Application();
+        explicit Application(const Settings& settings);
         ~Application();
 
         Application(const Application&) = delete;
@@ -30,14 +44,26 @@ namespace Cosmos {
 
     private:
         void loadGameObjects();
+        void buildFramePacket(const Camera& camera, FramePacket& packet);
+        // render thread, the packet's objects instead of the game objects
+        void requestTextureResolutions(const FramePacket& packet);
 
+        const Settings settings;
         Window window{WIDTH, HEIGHT, "Cosmos Engine"};
         EngineDevice engineDevice{window};
-        Renderer renderer{window, engineDevice};
+        Renderer renderer{window, engineDevice, settings.swapChain};
 
         // note: order of declarations matters
-        std::unique_ptr<DescriptorPool> globalPool{};
+        DescriptorSetLayoutCache descriptorLayoutCache{engineDevice};
+        std::unique_ptr<DescriptorAllocator> globalDescriptorAllocator{};
+        // transient sets, reset at the start of every frame that reuses the slot
+        std::vector<std::unique_ptr<DescriptorAllocator>> frameDescriptorAllocators{};
+        std::unique_ptr<MaterialSystem> materialSystem{};
+        std::unique_ptr<TextureStreamer> textureStreamer{};
+        std::unique_ptr<AssetManager> assetManager{};
         GameObject::Map gameObjects;
+        // streams into gameObjects, destroyed first
+        std::unique_ptr<WorldPartition> worldPartition{};
 
     };
 
@@ -0,0 +1,227 @@
+#include "asset_archive.hpp"
+
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    namespace {
+        struct MountPoint {
+            std::string prefix; // normalized mount directory with a trailing '/', empty for "."
+            std::unique_ptr<AssetArchive> archive;
+        };
+
+        std::vector<MountPoint>& getMountPoints()
+        {
+            static std::vector<MountPoint> mountPoints;
+            return mountPoints;
+        }
+
+        std::string normalizePath(const std::string& path)
+        {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+    }
+
+    AssetArchive::AssetArchive(const std::string& archivePath) : archivePath{archivePath}, file{archivePath}
+    {
+        if(file.size() < sizeof(ArchiveHeader)) {
+            throw std::runtime_error("not an asset archive: " + archivePath);
+        }
+        std::memcpy(&header, file.data(), sizeof(ArchiveHeader));
+        if(header.magic != ArchiveHeader::MAGIC) {
+            throw std::runtime_error("not an asset archive: " + archivePath);
+        }
+        if(header.version != ArchiveHeader::VERSION) {
+            throw std::runtime_error("unsupported asset archive version: " + archivePath);
+        }
+        // written to not overflow on corrupt values
+        if(header.entriesOffset % alignof(ArchiveEntry) != 0 ||
+            header.namesOffset > file.size() || header.entriesOffset > header.namesOffset ||
+            sizeof(ArchiveEntry) * static_cast<uint64_t>(header.entryCount) > header.namesOffset - header.entriesOffset) {
+            throw std::runtime_error("corrupt asset archive table: " + archivePath);
+        }
+
+        // the table is used in place, the mapping is page aligned
+        entries = reinterpret_cast<const ArchiveEntry*>(file.data() + header.entriesOffset);
+        names = file.data() + header.namesOffset;
+        for(uint32_t i = 0; i < header.entryCount; i++) {
+            const ArchiveEntry& entry = entries[i];
+            if(entry.offset > header.entriesOffset || entry.storedSize > header.entriesOffset - entry.offset ||
+                static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > file.size() - header.namesOffset) {
+                throw std::runtime_error("corrupt asset archive entry: " + archivePath);
+            }
+            // uncompressed entries are returned as views of exactly their stored bytes
+            if(entry.compression == ArchiveCompression::None && entry.size != entry.storedSize) {
+                throw std::runtime_error("corrupt asset archive entry: " + archivePath);
+            }
+        }
+    }
+
+    const ArchiveEntry* AssetArchive::find(const std::string& name) const
+    {
+        const uint64_t hash = hashName(name);
+        const ArchiveEntry* end = entries + header.entryCount;
+        const ArchiveEntry* it = std::lower_bound(entries, end, hash,
+            [](const ArchiveEntry& entry, uint64_t value) { return entry.nameHash < value; });
+        for(; it != end && it->nameHash == hash; it++) {
+            if(it->nameLength == name.size() && std::memcmp(names + it->nameOffset, name.data(), name.size()) == 0) {
+                return it;
+            }
+        }
+        return nullptr;
+    }
+
+    AssetData AssetArchive::read(const ArchiveEntry& entry) const
+    {
+        AssetData asset{};
+        const char* stored = file.data() + entry.offset;
+        switch(entry.compression) {
+            case ArchiveCompression::None:
+                asset.begin = stored;
+                break;
+            case ArchiveCompression::LZ4:
+                asset.decompressed.resize(entry.size);
+                Lz4::decompress(stored, entry.storedSize, asset.decompressed.data(), entry.size);
+                asset.begin = asset.decompressed.data();
+                break;
+            default:
+                throw std::runtime_error("unknown compression of " + getName(entry) + " in " + archivePath);
+        }
+        asset.length = entry.size;
+        return asset;
+    }
+
+    std::string AssetArchive::getName(const ArchiveEntry& entry) const
+    {
+        return std::string(names + entry.nameOffset, entry.nameLength);
+    }
+
+    void AssetArchive::mount(const std::string& archivePath, const std::string& mountDirectory)
+    {
+        std::string prefix = normalizePath(mountDirectory);
+        if(prefix == "." || prefix.empty()) {
+            prefix.clear();
+        } else if(prefix.back() != '/') {
+            prefix += '/';
+        }
+        auto& mountPoints = getMountPoints();
+        mountPoints.insert(mountPoints.begin(), MountPoint{prefix, std::make_unique<AssetArchive>(archivePath)});
+    }
+
+    void AssetArchive::unmountAll()
+    {
+        getMountPoints().clear();
+    }
+
+    AssetData AssetArchive::load(const std::string& filepath)
+    {
+        const auto& mountPoints = getMountPoints();
+        if(!mountPoints.empty()) {
+            const std::string path = normalizePath(filepath);
+            for(const auto& mountPoint : mountPoints) {
+                if(path.compare(0, mountPoint.prefix.size(), mountPoint.prefix) != 0) continue;
+                if(const ArchiveEntry* entry = mountPoint.archive->find(path.substr(mountPoint.prefix.size()))) {
+                    return mountPoint.archive->read(*entry);
+                }
+            }
+        }
+
+        AssetData asset{};
+        asset.file = std::make_shared<MappedFile>(filepath);
+        asset.begin = asset.file->data();
+        asset.length = asset.file->size();
+        return asset;
+    }
+
+    void AssetArchive::write(
+        const std::string& archivePath,
+        const std::vector<std::string>& names,
+        const std::vector<std::vector<char>>& data,
+        bool compress)
+    {
+        if(names.size() != data.size()) {
+            throw std::invalid_argument("every archive entry needs a name");
+        }
+
+        std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open()) {
+            throw std::runtime_error("failed to open file: " + archivePath);
+        }
+
+        auto align = [&file]() {
+            const uint64_t offset = static_cast<uint64_t>(file.tellp());
+            const uint64_t padding = ((offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1)) - offset;
+            const char zeros[BLOB_ALIGNMENT]{};
+            file.write(zeros, static_cast<std::streamsize>(padding));
+            return offset + padding;
+        };
+
+        ArchiveHeader header{};
+        header.entryCount = static_cast<uint32_t>(names.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<ArchiveEntry> entries(names.size());
+        std::string nameTable;
+        std::vector<char> compressed;
+        for(size_t i = 0; i < names.size(); i++) {
+            ArchiveEntry& entry = entries[i];
+            entry.nameHash = hashName(names[i]);
+            entry.nameOffset = static_cast<uint32_t>(nameTable.size());
+            entry.nameLength = static_cast<uint32_t>(names[i].size());
+            nameTable += names[i];
+
+            entry.size = data[i].size();
+            entry.offset = align();
+            size_t compressedSize = 0;
+            if(compress && !data[i].empty()) {
+                // anything that would not save an eighth is not worth decoding
+                compressed.resize(Lz4::compressBound(data[i].size()));
+                compressedSize = Lz4::compress(data[i].data(), data[i].size(), compressed.data(),
+                    data[i].size() - data[i].size() / 8);
+            }
+            if(compressedSize != 0) {
+                entry.compression = ArchiveCompression::LZ4;
+                entry.storedSize = compressedSize;
+                file.write(compressed.data(), static_cast<std::streamsize>(compressedSize));
+            } else {
+                entry.storedSize = data[i].size();
+                file.write(data[i].data(), static_cast<std::streamsize>(data[i].size()));
+            }
+        }
+
+        std::vector<uint32_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+            [&entries](uint32_t a, uint32_t b) { return entries[a].nameHash < entries[b].nameHash; });
+        header.entriesOffset = align();
+        for(uint32_t i : order) {
+            file.write(reinterpret_cast<const char*>(&entries[i]), sizeof(ArchiveEntry));
+        }
+        header.namesOffset = static_cast<uint64_t>(file.tellp());
+        file.write(nameTable.data(), static_cast<std::streamsize>(nameTable.size()));
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if(!file) {
+            throw std::runtime_error("failed to write asset archive: " + archivePath);
+        }
+    }
+
+    // FNV-1a, stored in the archive so it must not depend on the standard library implementation
+    uint64_t AssetArchive::hashName(const std::string& name)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for(char c : name) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+}
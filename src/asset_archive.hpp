@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace Cosmos {
+
+    enum class ArchiveCompression : uint32_t {
+        None = 0,
+        LZ4 = 1, // one LZ4 block per entry
+    };
+
+    /*
+    Packed asset archive (.pak):
+        ArchiveHeader
+        entry data, each blob aligned to BLOB_ALIGNMENT
+        ArchiveEntry[entryCount]   sorted by nameHash
+        entry names, not terminated
+    Names are relative paths with '/' separators, e.g. "models/flat_vase.obj".
+    All values are little endian.
+    */
+    struct ArchiveHeader {
+        static constexpr uint32_t MAGIC = 0x4B415043; // "CPAK"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t entryCount = 0;
+        uint32_t reserved = 0;
+        uint64_t entriesOffset = 0;
+        uint64_t namesOffset = 0;
+    };
+
+    struct ArchiveEntry {
+        uint64_t nameHash = 0;
+        uint64_t offset = 0;     // from the beginning of the archive
+        uint64_t storedSize = 0; // bytes in the archive
+        uint64_t size = 0;       // bytes once decompressed
+        uint32_t nameOffset = 0; // into the name table
+        uint32_t nameLength = 0;
+        ArchiveCompression compression = ArchiveCompression::None;
+        uint32_t reserved = 0;
+    };
+
+    // Contents of one asset: a view into the mapped archive or file, or decompressed bytes it owns
+    class AssetData {
+    public:
+        AssetData() = default;
+
+        const char* data() const { return begin; }
+        size_t size() const { return length; }
+
+    private:
+        friend class AssetArchive;
+
+        const char* begin = nullptr;
+        size_t length = 0;
+        std::shared_ptr<MappedFile> file{}; // keeps loose files mapped
+        std::vector<char> decompressed{};
+    };
+
+    /*
+    Read only access to a packed archive, mapped as a whole so opening an uncompressed entry is a
+    table lookup and its pages are only read on first access.
+    Mounted archives are searched by AssetArchive::load before the loose files, mount them at
+    start up before any asset is loaded.
+    */
+    class AssetArchive {
+    public:
+        static constexpr uint64_t BLOB_ALIGNMENT = 16;
+
+        explicit AssetArchive(const std::string& archivePath);
+
+        AssetArchive(const AssetArchive&) = delete;
+        AssetArchive& operator=(const AssetArchive&) = delete;
+
+        // name: relative path inside the archive
+        const ArchiveEntry* find(const std::string& name) const;
+        AssetData read(const ArchiveEntry& entry) const;
+        std::string getName(const ArchiveEntry& entry) const;
+        uint32_t getEntryCount() const { return header.entryCount; }
+        const ArchiveEntry& getEntry(uint32_t index) const { return entries[index]; }
+
+        // Paths below mountDirectory (e.g. "../models/quad.obj" for "..") are looked up in the archive,
+        // archives mounted later take precedence
+        static void mount(const std::string& archivePath, const std::string& mountDirectory);
+        static void unmountAll();
+        // From the first mounted archive containing the path, otherwise the loose file
+        static AssetData load(const std::string& filepath);
+
+        // Writes an archive, data[i] stored under names[i]. compress: try LZ4 on every entry,
+        // entries which do not shrink by at least 1/8 are stored uncompressed.
+        static void write(
+            const std::string& archivePath,
+            const std::vector<std::string>& names,
+            const std::vector<std::vector<char>>& data,
+            bool compress);
+
+        static uint64_t hashName(const std::string& name);
+
+    private:
+        std::string archivePath;
+        MappedFile file;
+        ArchiveHeader header{};
+        const ArchiveEntry* entries = nullptr;
+        const char* names = nullptr;
+    };
+}
@@ -0,0 +1,173 @@
+#include "asset_manager.hpp"
+
+#include "dedup_table.hpp"
+#include "engine_utils.hpp"
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace Cosmos {
+
+    AssetManager::AssetManager(EngineDevice& device) : AssetManager{device, Settings{}} {}
+
+    AssetManager::AssetManager(EngineDevice& device, const Settings& settings)
+        : engineDevice{device}, settings{settings} {}
+
+    AssetManager::~AssetManager()
+    {
+        // loads still running reference this manager, collect the futures first since a finishing
+        // load takes the mutex
+        std::vector<std::shared_future<ModelHandle>> pending;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            for(auto& kv : modelsByContent) pending.push_back(kv.second->model);
+        }
+        for(auto& future : pending) future.wait();
+    }
+
+    AssetManager::ModelHandle AssetManager::loadModel(const std::string& filepath, const Model::Builder& importSettings)
+    {
+        return loadModelAsync(filepath, importSettings).get();
+    }
+
+    std::shared_future<AssetManager::ModelHandle> AssetManager::loadModelAsync(const std::string& filepath,
+        const Model::Builder& importSettings)
+    {
+        const uint64_t settingsHash = hashImportSettings(importSettings);
+        const std::string key = makeKey(filepath, settingsHash);
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto it = modelsByKey.find(key);
+            if(it != modelsByKey.end()) {
+                it->second->lastRequest = ++requestCounter;
+                return it->second->model;
+            }
+        }
+
+        // new path, hash the content outside the lock to find copies of an already loaded file
+        size_t contentKey = static_cast<size_t>(hashFileContent(filepath));
+        hashCombine(contentKey, settingsHash);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        // another thread may have requested the same path meanwhile
+        auto it = modelsByKey.find(key);
+        if(it != modelsByKey.end()) {
+            it->second->lastRequest = ++requestCounter;
+            return it->second->model;
+        }
+        auto contentIt = modelsByContent.find(contentKey);
+        if(contentIt != modelsByContent.end()) {
+            contentIt->second->keys.push_back(key);
+            contentIt->second->lastRequest = ++requestCounter;
+            modelsByKey.emplace(key, contentIt->second);
+            return contentIt->second->model;
+        }
+
+        auto entry = std::make_shared<ModelEntry>();
+        entry->keys.push_back(key);
+        entry->contentKey = contentKey;
+        entry->lastRequest = ++requestCounter;
+        modelsByKey.emplace(key, entry);
+        modelsByContent.emplace(contentKey, entry);
+        // the worker needs the mutex to finish, so entry->model is set before it can complete
+        entry->model = std::async(std::launch::async, &AssetManager::createModel, this, entry, filepath,
+            importSettings).share();
+        return entry->model;
+    }
+
+    AssetManager::ModelHandle AssetManager::createModel(const std::shared_ptr<ModelEntry>& entry,
+        const std::string& filepath, const Model::Builder& importSettings)
+    {
+        ModelHandle model;
+        try {
+            Model::Builder builder{};
+            builder.vertexFormat = importSettings.vertexFormat;
+            builder.splitForUint16Indices = importSettings.splitForUint16Indices;
+            builder.lodCount = importSettings.lodCount;
+            builder.meshletCulling = importSettings.meshletCulling;
+            builder.meshletBackfaceCulling = importSettings.meshletBackfaceCulling;
+            builder.importThreads = importSettings.importThreads;
+            builder.loadModel(filepath);
+            model = std::make_shared<Model>(engineDevice, builder);
+        } catch(...) {
+            // forget the failed load so a later request retries, waiting callers get the exception
+            std::lock_guard<std::mutex> lock{mutex};
+            removeEntry(entry);
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        entry->bytes = model->getDeviceMemorySize();
+        residentBytes += entry->bytes;
+        return model;
+    }
+
+    void AssetManager::removeEntry(const std::shared_ptr<ModelEntry>& entry)
+    {
+        for(const auto& key : entry->keys) modelsByKey.erase(key);
+        modelsByContent.erase(entry->contentKey);
+        residentBytes -= entry->bytes;
+    }
+
+    void AssetManager::update()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if(residentBytes <= settings.memoryBudget) return;
+
+        // loaded models only the cache holds on to, least recently requested first
+        std::vector<std::shared_ptr<ModelEntry>> candidates;
+        for(auto& kv : modelsByContent) {
+            auto& entry = kv.second;
+            if(entry->model.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+            if(entry->model.get().use_count() == 1) candidates.push_back(entry);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) { return a->lastRequest < b->lastRequest; });
+
+        for(auto& entry : candidates) {
+            if(residentBytes <= settings.memoryBudget) break;
+            // dropping the last reference is enough, the model's buffers are retired until frames in flight are done
+            removeEntry(entry);
+        }
+    }
+
+    void AssetManager::setMemoryBudget(VkDeviceSize budget)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        settings.memoryBudget = budget;
+    }
+
+    VkDeviceSize AssetManager::getResidentBytes() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return residentBytes;
+    }
+
+    size_t AssetManager::getModelCount() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return modelsByContent.size();
+    }
+
+    std::string AssetManager::makeKey(const std::string& filepath, uint64_t settingsHash)
+    {
+        return std::filesystem::path(filepath).lexically_normal().generic_string() + '#' + std::to_string(settingsHash);
+    }
+
+    // Options that change the imported data, importThreads only changes how fast it is produced
+    uint64_t AssetManager::hashImportSettings(const Model::Builder& importSettings)
+    {
+        size_t seed = 0;
+        hashCombine(seed, static_cast<int>(importSettings.vertexFormat), importSettings.splitForUint16Indices,
+            importSettings.lodCount, importSettings.meshletCulling, importSettings.meshletBackfaceCulling);
+        return seed;
+    }
+
+    uint64_t AssetManager::hashFileContent(const std::string& filepath)
+    {
+        AssetData file = AssetArchive::load(filepath);
+        return DedupTable<uint64_t>::hashBytes(file.data(), file.size());
+    }
+}
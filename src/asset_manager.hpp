@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "model.hpp"
+
+namespace Cosmos {
+
+    /*
+    Shared cache of GPU assets. Models are keyed by path and import settings, a second index by content
+    hash catches the same file under another path. Requests for an asset that is still loading join
+    that load instead of starting another one. Assets nobody references anymore stay cached until the
+    resident size exceeds the memory budget, then the least recently requested ones are evicted and
+    destroyed once no frame in flight can still draw them.
+    */
+    class AssetManager {
+    public:
+        struct Settings {
+            VkDeviceSize memoryBudget = 256ull * 1024 * 1024; // referenced assets are never evicted, even above it
+        };
+
+        using ModelHandle = std::shared_ptr<Model>;
+
+        explicit AssetManager(EngineDevice& device);
+        AssetManager(EngineDevice& device, const Settings& settings);
+        ~AssetManager();
+
+        AssetManager(const AssetManager&) = delete;
+        AssetManager& operator=(const AssetManager&) = delete;
+
+        // Only the import options of importSettings are used (vertexFormat, lodCount, meshletCulling, ...)
+        ModelHandle loadModel(const std::string& filepath, const Model::Builder& importSettings = Model::Builder{});
+        // Starts the import on a worker thread, or returns the load already running for the same asset
+        std::shared_future<ModelHandle> loadModelAsync(const std::string& filepath,
+            const Model::Builder& importSettings = Model::Builder{});
+
+        // Evicts unreferenced assets above the budget, call once per frame
+        void update();
+
+        void setMemoryBudget(VkDeviceSize budget);
+        VkDeviceSize getResidentBytes() const;
+        size_t getModelCount() const;
+
+    private:
+        struct ModelEntry {
+            std::shared_future<ModelHandle> model;
+            std::vector<std::string> keys{}; // every path key resolving to this entry
+            uint64_t contentKey = 0;         // file content and import settings
+            VkDeviceSize bytes = 0;          // known once loaded
+            uint64_t lastRequest = 0;
+        };
+
+        static std::string makeKey(const std::string& filepath, uint64_t settingsHash);
+        static uint64_t hashImportSettings(const Model::Builder& importSettings);
+        static uint64_t hashFileContent(const std::string& filepath);
+
+        ModelHandle createModel(const std::shared_ptr<ModelEntry>& entry, const std::string& filepath,
+            const Model::Builder& importSettings);
+        void removeEntry(const std::shared_ptr<ModelEntry>& entry);
+
+        EngineDevice& engineDevice;
+        Settings settings;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<ModelEntry>> modelsByKey;
+        std::unordered_map<uint64_t, std::shared_ptr<ModelEntry>> modelsByContent; // one per entry
+        uint64_t requestCounter = 0;
+        VkDeviceSize residentBytes = 0;
+    };
+}
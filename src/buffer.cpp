@@ -48,8 +48,11 @@ namespace Cosmos {
 
   Buffer::~Buffer() {
     unmap();
-    vkDestroyBuffer(engineDevice.device(), buffer, nullptr);
-    vkFreeMemory(engineDevice.device(), memory, nullptr);
+    // frames in flight may still read it
+    engineDevice.retire([device = engineDevice.device(), buffer = buffer, memory = memory]() {
+      vkDestroyBuffer(device, buffer, nullptr);
+      vkFreeMemory(device, memory, nullptr);
+    });
   }
 
   /**
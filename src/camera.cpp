@@ -107,4 +107,32 @@ namespace Cosmos
         inverseViewMatrix[3][1] = position.y;
         inverseViewMatrix[3][2] = position.z;
     }
-}
\ No newline at end of file
+
+    // Gribb/Hartmann extraction for a [0, 1] depth range
+    Frustum Camera::getFrustum() const
+    {
+        const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+        auto row = [&](int i) {
+            return glm::vec4{viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]};
+        };
+        Frustum frustum{};
+        frustum.planes[0] = row(3) + row(0); // left
+        frustum.planes[1] = row(3) - row(0); // right
+        frustum.planes[2] = row(3) + row(1); // bottom
+        frustum.planes[3] = row(3) - row(1); // top
+        frustum.planes[4] = row(2);          // near
+        frustum.planes[5] = row(3) - row(2); // far
+        for(auto& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for(const auto& plane : planes) {
+            if(glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+        }
+        return true;
+    }
+}
@@ -6,6 +6,13 @@
 
 namespace Cosmos
 {
+    // World space planes (left, right, bottom, top, near, far), normals point inside
+    struct Frustum {
+        glm::vec4 planes[6];
+
+        bool intersectsSphere(const glm::vec3& center, float radius) const;
+    };
+
     class Camera{
     public:
 
@@ -20,6 +27,7 @@ namespace Cosmos
         const glm::mat4& getView() const {return viewMatrix; }
         const glm::mat4& getInverseView() const {return inverseViewMatrix; }
         const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
+        Frustum getFrustum() const;
 
     private:
         glm::mat4 projectionMatrix{1.f};
@@ -0,0 +1,164 @@
+#include "cooked_texture.hpp"
+
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    bool isBlockCompressed(CookedTextureFormat format)
+    {
+        return format != CookedTextureFormat::RGBA8_UNORM && format != CookedTextureFormat::RGBA8_SRGB;
+    }
+
+    uint32_t getBlockSize(CookedTextureFormat format)
+    {
+        switch(format) {
+            case CookedTextureFormat::RGBA8_UNORM:
+            case CookedTextureFormat::RGBA8_SRGB:
+                return 4;
+            case CookedTextureFormat::BC1_UNORM:
+            case CookedTextureFormat::BC1_SRGB:
+                return 8;
+            case CookedTextureFormat::BC5_UNORM:
+            case CookedTextureFormat::BC7_UNORM:
+            case CookedTextureFormat::BC7_SRGB:
+                return 16;
+        }
+        throw std::runtime_error("unknown cooked texture format!");
+    }
+
+    uint64_t getLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height)
+    {
+        if(!isBlockCompressed(format)) {
+            return static_cast<uint64_t>(width) * height * getBlockSize(format);
+        }
+        uint64_t blocksX = (width + 3) / 4;
+        uint64_t blocksY = (height + 3) / 4;
+        return blocksX * blocksY * getBlockSize(format);
+    }
+
+    CookedTextureFile::CookedTextureFile(const std::string& filepath) : filepath{filepath}
+    {
+        AssetData file = AssetArchive::load(filepath);
+        if(file.size() < sizeof(header)) {
+            throw std::runtime_error("not a cooked texture: " + filepath);
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if(header.magic != CookedTextureHeader::MAGIC) {
+            throw std::runtime_error("not a cooked texture: " + filepath);
+        }
+        if(header.version != CookedTextureHeader::VERSION) {
+            throw std::runtime_error("unsupported cooked texture version: " + filepath);
+        }
+        if(header.mipCount == 0 || header.width == 0 || header.height == 0) {
+            throw std::runtime_error("empty cooked texture: " + filepath);
+        }
+
+        if(static_cast<uint32_t>(header.format) > static_cast<uint32_t>(CookedTextureFormat::BC7_SRGB)) {
+            throw std::runtime_error("unknown cooked texture format: " + filepath);
+        }
+        // a full chain ends at 1x1, anything longer is corrupt
+        uint32_t maxMipCount = 1;
+        for(uint32_t extent = std::max(header.width, header.height); extent > 1; extent >>= 1) {
+            maxMipCount++;
+        }
+        if(header.mipCount > maxMipCount) {
+            throw std::runtime_error("too many mip levels in cooked texture: " + filepath);
+        }
+
+        const uint64_t tableEnd = sizeof(header) + sizeof(CookedTextureLevel) * static_cast<uint64_t>(header.mipCount);
+        if(file.size() < tableEnd) {
+            throw std::runtime_error("truncated cooked texture level table: " + filepath);
+        }
+        levels.resize(header.mipCount);
+        std::memcpy(levels.data(), file.data() + sizeof(header), sizeof(CookedTextureLevel) * levels.size());
+
+        for(uint32_t mip = 0; mip < header.mipCount; mip++) {
+            const CookedTextureLevel& level = levels[mip];
+            if(level.width != std::max(header.width >> mip, 1u) || level.height != std::max(header.height >> mip, 1u)) {
+                throw std::runtime_error("invalid cooked texture level extent: " + filepath);
+            }
+            if(level.size != getLevelSize(header.format, level.width, level.height)) {
+                throw std::runtime_error("invalid cooked texture level size: " + filepath);
+            }
+            if(level.offset < tableEnd || level.offset > file.size() || level.size > file.size() - level.offset) {
+                throw std::runtime_error("truncated cooked texture level data: " + filepath);
+            }
+        }
+    }
+
+    uint64_t CookedTextureFile::getLevelsSize(uint32_t firstMip, uint32_t count) const
+    {
+        assert(firstMip + count <= header.mipCount && "Mip range out of bounds");
+        uint64_t size = 0;
+        for(uint32_t mip = firstMip; mip < firstMip + count; mip++) {
+            size += levels[mip].size;
+        }
+        return size;
+    }
+
+    uint64_t CookedTextureFile::readLevels(uint32_t firstMip, uint32_t count, uint8_t* dst) const
+    {
+        assert(firstMip + count <= header.mipCount && "Mip range out of bounds");
+        // opened per read, a streamer may keep thousands of these alive. Mapped (or a view into a mounted
+        // archive) so only the pages of the requested levels are read
+        AssetData file = AssetArchive::load(filepath);
+
+        uint64_t written = 0;
+        for(uint32_t mip = firstMip; mip < firstMip + count; mip++) {
+            if(levels[mip].offset + levels[mip].size > file.size()) {
+                throw std::runtime_error("truncated cooked texture level data: " + filepath);
+            }
+            std::memcpy(dst + written, file.data() + levels[mip].offset, levels[mip].size);
+            written += levels[mip].size;
+        }
+        return written;
+    }
+
+    void CookedTextureFile::write(
+        const std::string& filepath,
+        CookedTextureFormat format,
+        const std::vector<CookedTextureLevel>& levels,
+        const std::vector<std::vector<uint8_t>>& levelData)
+    {
+        assert(!levels.empty() && levels.size() == levelData.size() && "Every level needs data");
+
+        CookedTextureHeader header{};
+        header.format = format;
+        header.width = levels[0].width;
+        header.height = levels[0].height;
+        header.mipCount = static_cast<uint32_t>(levels.size());
+
+        // lay the levels out after the tables
+        std::vector<CookedTextureLevel> table = levels;
+        uint64_t offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureLevel) * table.size();
+        for(size_t i = 0; i < table.size(); i++) {
+            offset = (offset + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+            table[i].offset = offset;
+            table[i].size = levelData[i].size();
+            offset += table[i].size;
+        }
+
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open()) {
+            throw std::runtime_error("failed to open file for writing: " + filepath);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), sizeof(CookedTextureLevel) * table.size());
+
+        const char zeros[LEVEL_ALIGNMENT] = {};
+        for(size_t i = 0; i < table.size(); i++) {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(zeros, static_cast<std::streamsize>(table[i].offset - position));
+            file.write(reinterpret_cast<const char*>(levelData[i].data()), static_cast<std::streamsize>(levelData[i].size()));
+        }
+        if(!file) {
+            throw std::runtime_error("failed to write cooked texture: " + filepath);
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Cosmos {
+
+    // Pixel formats a cooked texture can be stored in, mapped to VkFormat at load time
+    enum class CookedTextureFormat : uint32_t {
+        RGBA8_UNORM = 0,
+        RGBA8_SRGB = 1,
+        BC1_UNORM = 2, // RGB, 4 bpp
+        BC1_SRGB = 3,
+        BC5_UNORM = 4, // two channel (normal maps), 8 bpp
+        BC7_UNORM = 5, // RGBA, 8 bpp
+        BC7_SRGB = 6,
+    };
+
+    bool isBlockCompressed(CookedTextureFormat format);
+    // bytes per 4x4 block, or per texel for uncompressed formats
+    uint32_t getBlockSize(CookedTextureFormat format);
+    uint64_t getLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height);
+
+    /*
+    Container for offline cooked textures (KTX2-like, .ctex):
+        CookedTextureHeader
+        CookedTextureLevel[mipCount]   level 0 is the full resolution image
+        level data, each level aligned to LEVEL_ALIGNMENT
+    All values are little endian.
+    */
+    struct CookedTextureHeader {
+        static constexpr uint32_t MAGIC = 0x58455443; // "CTEX"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        CookedTextureFormat format = CookedTextureFormat::RGBA8_SRGB;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipCount = 0;
+        uint32_t reserved[2]{};
+    };
+
+    struct CookedTextureLevel {
+        uint64_t offset = 0; // from the beginning of the file
+        uint64_t size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    // Reads the level table up front, level data on demand
+    class CookedTextureFile {
+    public:
+        static constexpr uint64_t LEVEL_ALIGNMENT = 16;
+
+        explicit CookedTextureFile(const std::string& filepath);
+
+        const CookedTextureHeader& getHeader() const { return header; }
+        const CookedTextureLevel& getLevel(uint32_t mip) const { return levels[mip]; }
+        uint32_t getMipCount() const { return header.mipCount; }
+        const std::string& getPath() const { return filepath; }
+
+        // Copies levels [firstMip, firstMip + count) back to back into dst, returns bytes written
+        uint64_t readLevels(uint32_t firstMip, uint32_t count, uint8_t* dst) const;
+        uint64_t getLevelsSize(uint32_t firstMip, uint32_t count) const;
+
+        static void write(
+            const std::string& filepath,
+            CookedTextureFormat format,
+            const std::vector<CookedTextureLevel>& levels,
+            const std::vector<std::vector<uint8_t>>& levelData);
+
+    private:
+        std::string filepath;
+        CookedTextureHeader header{};
+        std::vector<CookedTextureLevel> levels{};
+    };
+}
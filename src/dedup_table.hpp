@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Cosmos {
+
+    /*
+    Open addressing key -> uint32_t table for vertex deduplication at import time.
+    SwissTable style layout: one control byte per slot (empty, or 7 bits of the hash) kept apart from
+    the keys, so a probe scans a dense byte array and only compares keys whose tag matches.
+    Keys are hashed and compared as raw bytes, they must not contain padding
+    (note -0.f and +0.f or two NaNs with different bits are different keys).
+    Nothing is ever erased, which keeps linear probing simple.
+    */
+    template<typename Key>
+    class DedupTable {
+        static_assert(std::is_trivially_copyable<Key>::value, "DedupTable keys are compared as raw bytes");
+
+    public:
+        explicit DedupTable(size_t expectedCount = 0) { reserve(expectedCount); }
+
+        // Sizes the table so expectedCount keys fit without growing
+        void reserve(size_t expectedCount)
+        {
+            size_t capacity = 16;
+            while(capacity * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < expectedCount) capacity *= 2;
+            if(capacity > control.size()) rehash(capacity);
+        }
+
+        // Returns the value of key, storing `value` first if key is new (one probe sequence either way)
+        uint32_t findOrInsert(const Key& key, uint32_t value, bool& inserted)
+        {
+            if((count + 1) * MAX_LOAD_DENOMINATOR > control.size() * MAX_LOAD_NUMERATOR) {
+                rehash(control.size() * 2);
+            }
+
+            const uint64_t hash = hashBytes(&key, sizeof(Key));
+            const uint8_t tag = static_cast<uint8_t>(hash >> 57); // top 7 bits, never EMPTY
+            for(size_t slot = static_cast<size_t>(hash) & mask;; slot = (slot + 1) & mask)
+            {
+                if(control[slot] == EMPTY) {
+                    control[slot] = tag;
+                    keys[slot] = key;
+                    values[slot] = value;
+                    count++;
+                    inserted = true;
+                    return value;
+                }
+                if(control[slot] == tag && std::memcmp(&keys[slot], &key, sizeof(Key)) == 0) {
+                    inserted = false;
+                    return values[slot];
+                }
+            }
+        }
+
+        size_t size() const { return count; }
+        size_t capacity() const { return control.size(); }
+
+        // 64 bit multiply-xorshift over 8 byte words, sizeof(Key) is a constant so the loop unrolls
+        static uint64_t hashBytes(const void* data, size_t size)
+        {
+            const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            uint64_t hash = size * multiplier;
+            size_t offset = 0;
+            for(; offset + 8 <= size; offset += 8) {
+                uint64_t word;
+                std::memcpy(&word, bytes + offset, 8);
+                hash = (hash ^ word) * multiplier;
+                hash ^= hash >> 32;
+            }
+            if(offset < size) {
+                uint64_t word = 0;
+                std::memcpy(&word, bytes + offset, size - offset);
+                hash = (hash ^ word) * multiplier;
+                hash ^= hash >> 32;
+            }
+            // final avalanche so both the low bits (slot) and the top bits (tag) depend on every input bit
+            hash ^= hash >> 29;
+            hash *= 0xBF58476D1CE4E5B9ull;
+            hash ^= hash >> 32;
+            return hash;
+        }
+
+    private:
+        static constexpr uint8_t EMPTY = 0x80;
+        // grows beyond 7/8 occupancy
+        static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+        static constexpr size_t MAX_LOAD_DENOMINATOR = 8;
+
+        void rehash(size_t newCapacity)
+        {
+            assert((newCapacity & (newCapacity - 1)) == 0 && "DedupTable capacity must be a power of two");
+            std::vector<uint8_t> oldControl = std::move(control);
+            std::vector<Key> oldKeys = std::move(keys);
+            std::vector<uint32_t> oldValues = std::move(values);
+            control.assign(newCapacity, EMPTY);
+            keys.assign(newCapacity, Key{});
+            values.assign(newCapacity, 0);
+            mask = newCapacity - 1;
+
+            for(size_t i = 0; i < oldControl.size(); i++) {
+                if(oldControl[i] == EMPTY) continue;
+                size_t slot = static_cast<size_t>(hashBytes(&oldKeys[i], sizeof(Key))) & mask;
+                while(control[slot] != EMPTY) slot = (slot + 1) & mask;
+                control[slot] = oldControl[i];
+                keys[slot] = oldKeys[i];
+                values[slot] = oldValues[i];
+            }
+        }
+
+        std::vector<uint8_t> control{};
+        std::vector<Key> keys{};
+        std::vector<uint32_t> values{};
+        size_t count = 0;
+        size_t mask = 0;
+    };
+}
@@ -0,0 +1,63 @@
+#include "deletion_queue.hpp"
+
+#include <utility>
+
+namespace Cosmos {
+
+    DeletionQueue::~DeletionQueue()
+    {
+        flush();
+    }
+
+    void DeletionQueue::retire(Deleter deleter)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        unsealed.push_back(std::move(deleter));
+    }
+
+    void DeletionQueue::seal(uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for(auto& deleter : unsealed) {
+            sealed.push_back({value, std::move(deleter)});
+        }
+        unsealed.clear();
+    }
+
+    void DeletionQueue::collect(uint64_t completedValue)
+    {
+        std::vector<Deleter> ready;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            while(!sealed.empty() && sealed.front().value <= completedValue) {
+                ready.push_back(std::move(sealed.front().deleter));
+                sealed.pop_front();
+            }
+        }
+        for(auto& deleter : ready) deleter();
+    }
+
+    void DeletionQueue::flush()
+    {
+        // a deleter may retire more (a model releasing its buffers), repeat until nothing is left
+        while(true)
+        {
+            std::vector<Deleter> ready;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                for(auto& retired : sealed) ready.push_back(std::move(retired.deleter));
+                sealed.clear();
+                for(auto& deleter : unsealed) ready.push_back(std::move(deleter));
+                unsealed.clear();
+            }
+            if(ready.empty()) break;
+            for(auto& deleter : ready) deleter();
+        }
+    }
+
+    size_t DeletionQueue::size() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return unsealed.size() + sealed.size();
+    }
+}
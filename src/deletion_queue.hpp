@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Cosmos {
+
+    /*
+    GPU objects can't be destroyed while a submitted command buffer may still use them. Instead of
+    waiting, their owner retires a deleter here. The next frame submit seals everything retired so
+    far with its graphics timeline value, and the deleters run once the GPU passed that value.
+    Sealing with the following frame submit is always late enough: a frame that is still recorded
+    when the object is retired is submitted no earlier than that, and work submitted earlier
+    finished before it anyway (single graphics queue).
+    Thread safe; deleters run outside the lock and may retire further objects.
+    */
+    class DeletionQueue {
+    public:
+        using Deleter = std::function<void()>;
+
+        DeletionQueue() = default;
+        ~DeletionQueue();
+
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+        void retire(Deleter deleter);
+        // Render thread, right after a frame submit; values never decrease
+        void seal(uint64_t value);
+        // Runs every deleter whose value the graphics timeline reached
+        void collect(uint64_t completedValue);
+        // Runs everything, the device has to be idle
+        void flush();
+
+        size_t size() const;
+
+    private:
+        struct Retired {
+            uint64_t value;
+            Deleter deleter;
+        };
+
+        mutable std::mutex mutex;
+        std::vector<Deleter> unsealed{};
+        std::deque<Retired> sealed{}; // ordered by value
+    };
+}
@@ -1,7 +1,11 @@
 #include "descriptors.hpp"
 
+#include "engine_utils.hpp"
+
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 namespace Cosmos {
@@ -12,7 +16,8 @@ DescriptorSetLayout::Builder &DescriptorSetLayout::Builder::addBinding(
     uint32_t binding,
     VkDescriptorType descriptorType,
     VkShaderStageFlags stageFlags,
-    uint32_t count) {
+    uint32_t count,
+    VkDescriptorBindingFlags flags) {
   assert(bindings.count(binding) == 0 && "Binding already in use");
   VkDescriptorSetLayoutBinding layoutBinding{};
   layoutBinding.binding = binding;
@@ -20,27 +25,53 @@ DescriptorSetLayout::Builder &DescriptorSetLayout::Builder::addBinding(
   layoutBinding.descriptorCount = count;
   layoutBinding.stageFlags = stageFlags;
   bindings[binding] = layoutBinding;
+  if (flags != 0) {
+    bindingFlags[binding] = flags;
+  }
   return *this;
 }
 
 std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build() const {
-  return std::make_unique<DescriptorSetLayout>(engineDevice, bindings);
+  return std::make_unique<DescriptorSetLayout>(engineDevice, bindings, bindingFlags);
+}
+
+std::shared_ptr<DescriptorSetLayout> DescriptorSetLayout::Builder::build(
+    DescriptorSetLayoutCache &cache) const {
+  return cache.getLayout(bindings, bindingFlags);
 }
 
 // *************** Descriptor Set Layout *********************
 
 DescriptorSetLayout::DescriptorSetLayout(
-    EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+    EngineDevice &engineDevice,
+    std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+    std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags)
     : engineDevice{engineDevice}, bindings{bindings} {
   std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+  std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+  bool updateAfterBind = false;
   for (auto kv : bindings) {
     setLayoutBindings.push_back(kv.second);
+    auto flags = bindingFlags.count(kv.first) ? bindingFlags[kv.first] : 0;
+    setLayoutBindingFlags.push_back(flags);
+    updateAfterBind |= (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
   }
 
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+  bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+  bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
   VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
   descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
   descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
   descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+  if (!bindingFlags.empty()) {
+    descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+  }
+  if (updateAfterBind) {
+    descriptorSetLayoutInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  }
 
   if (vkCreateDescriptorSetLayout(
           engineDevice.device(),
@@ -110,14 +141,24 @@ bool DescriptorPool::allocateDescriptor(
   allocInfo.pSetLayouts = &descriptorSetLayout;
   allocInfo.descriptorSetCount = 1;
 
-  // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-  // a new pool whenever an old pool fills up. But this is beyond our current scope
+  // Fixed size pool: use DescriptorAllocator when the number of sets is not known up front
   if (vkAllocateDescriptorSets(engineDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
     return false;
   }
   return true;
 }
 
+VkResult DescriptorPool::tryAllocateDescriptor(
+    const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const {
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = descriptorPool;
+  allocInfo.pSetLayouts = &descriptorSetLayout;
+  allocInfo.descriptorSetCount = 1;
+
+  return vkAllocateDescriptorSets(engineDevice.device(), &allocInfo, &descriptor);
+}
+
 void DescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const {
   vkFreeDescriptorSets(
       engineDevice.device(),
@@ -130,10 +171,167 @@ void DescriptorPool::resetPool() {
   vkResetDescriptorPool(engineDevice.device(), descriptorPool, 0);
 }
 
+// *************** Descriptor Set Layout Cache *********************
+
+bool DescriptorSetLayoutCache::LayoutKey::operator==(const LayoutKey &other) const {
+  if (bindings.size() != other.bindings.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < bindings.size(); i++) {
+    const auto &a = bindings[i];
+    const auto &b = other.bindings[i];
+    if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+        a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags ||
+        bindingFlags[i] != other.bindingFlags[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t DescriptorSetLayoutCache::LayoutKeyHash::operator()(const LayoutKey &key) const {
+  size_t seed = key.bindings.size();
+  for (size_t i = 0; i < key.bindings.size(); i++) {
+    const auto &binding = key.bindings[i];
+    hashCombine(
+        seed,
+        binding.binding,
+        static_cast<uint32_t>(binding.descriptorType),
+        binding.descriptorCount,
+        static_cast<uint32_t>(binding.stageFlags),
+        static_cast<uint32_t>(key.bindingFlags[i]));
+  }
+  return seed;
+}
+
+std::shared_ptr<DescriptorSetLayout> DescriptorSetLayoutCache::getLayout(
+    const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+    const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags) {
+  LayoutKey key{};
+  key.bindings.reserve(bindings.size());
+  for (const auto &kv : bindings) {
+    key.bindings.push_back(kv.second);
+  }
+  // unordered_map iteration order is unspecified, the signature must not depend on it
+  std::sort(
+      key.bindings.begin(),
+      key.bindings.end(),
+      [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+        return a.binding < b.binding;
+      });
+  key.bindingFlags.reserve(key.bindings.size());
+  for (const auto &binding : key.bindings) {
+    auto it = bindingFlags.find(binding.binding);
+    key.bindingFlags.push_back(it != bindingFlags.end() ? it->second : 0);
+  }
+
+  auto it = layouts.find(key);
+  if (it != layouts.end()) {
+    return it->second;
+  }
+
+  auto layout = std::make_shared<DescriptorSetLayout>(engineDevice, bindings, bindingFlags);
+  layouts.emplace(std::move(key), layout);
+  return layout;
+}
+
+// *************** Descriptor Allocator Builder *********************
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::addPoolSizeRatio(
+    VkDescriptorType descriptorType, float ratio) {
+  ratios.push_back({descriptorType, ratio});
+  return *this;
+}
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::setPoolFlags(
+    VkDescriptorPoolCreateFlags flags) {
+  poolFlags = flags;
+  return *this;
+}
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::setInitialSets(uint32_t count) {
+  initialSets = count;
+  return *this;
+}
+
+DescriptorAllocator::Builder &DescriptorAllocator::Builder::setMaxSetsPerPool(uint32_t count) {
+  maxSetsPerPool = count;
+  return *this;
+}
+
+std::unique_ptr<DescriptorAllocator> DescriptorAllocator::Builder::build() const {
+  return std::make_unique<DescriptorAllocator>(
+      engineDevice,
+      initialSets,
+      maxSetsPerPool,
+      poolFlags,
+      ratios);
+}
+
+// *************** Descriptor Allocator *********************
+
+DescriptorAllocator::DescriptorAllocator(
+    EngineDevice &engineDevice,
+    uint32_t initialSets,
+    uint32_t maxSetsPerPool,
+    VkDescriptorPoolCreateFlags poolFlags,
+    const std::vector<PoolSizeRatio> &ratios)
+    : engineDevice{engineDevice},
+      ratios{ratios},
+      poolFlags{poolFlags},
+      setsPerPool{std::max(initialSets, 1u)},
+      maxSetsPerPool{std::max(maxSetsPerPool, initialSets)} {
+  assert(!ratios.empty() && "Descriptor allocator needs at least one pool size ratio");
+  currentPool = grabPool();
+}
+
+std::unique_ptr<DescriptorPool> DescriptorAllocator::grabPool() {
+  if (!readyPools.empty()) {
+    auto pool = std::move(readyPools.back());
+    readyPools.pop_back();
+    return pool;
+  }
+
+  std::vector<VkDescriptorPoolSize> poolSizes{};
+  poolSizes.reserve(ratios.size());
+  for (const auto &ratio : ratios) {
+    uint32_t count = static_cast<uint32_t>(std::ceil(ratio.ratio * setsPerPool));
+    poolSizes.push_back({ratio.descriptorType, std::max(count, 1u)});
+  }
+  auto pool = std::make_unique<DescriptorPool>(engineDevice, setsPerPool, poolFlags, poolSizes);
+
+  // every new pool is bigger than the previous one, so a busy allocator settles on few pools
+  setsPerPool = std::min(setsPerPool + setsPerPool / 2, maxSetsPerPool);
+  return pool;
+}
+
+bool DescriptorAllocator::allocateDescriptor(
+    const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) {
+  VkResult result = currentPool->tryAllocateDescriptor(descriptorSetLayout, descriptor);
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+    fullPools.push_back(std::move(currentPool));
+    currentPool = grabPool();
+    result = currentPool->tryAllocateDescriptor(descriptorSetLayout, descriptor);
+  }
+  return result == VK_SUCCESS;
+}
+
+void DescriptorAllocator::resetPools() {
+  currentPool->resetPool();
+  for (auto &pool : fullPools) {
+    pool->resetPool();
+    readyPools.push_back(std::move(pool));
+  }
+  fullPools.clear();
+}
+
 // *************** Descriptor Writer *********************
 
 DescriptorWriter::DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool)
-    : setLayout{setLayout}, pool{pool} {}
+    : setLayout{setLayout}, pool{&pool} {}
+
+DescriptorWriter::DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorAllocator &allocator)
+    : setLayout{setLayout}, allocator{&allocator} {}
 
 DescriptorWriter &DescriptorWriter::writeBuffer(
     uint32_t binding, VkDescriptorBufferInfo *bufferInfo) {
@@ -177,8 +375,32 @@ DescriptorWriter &DescriptorWriter::writeImage(
   return *this;
 }
 
+DescriptorWriter &DescriptorWriter::writeImage(
+    uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t arrayElement) {
+  assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+  auto &bindingDescription = setLayout.bindings[binding];
+
+  assert(
+      arrayElement < bindingDescription.descriptorCount &&
+      "Array element is out of range of the binding");
+
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.descriptorType = bindingDescription.descriptorType;
+  write.dstBinding = binding;
+  write.dstArrayElement = arrayElement;
+  write.pImageInfo = imageInfo;
+  write.descriptorCount = 1;
+
+  writes.push_back(write);
+  return *this;
+}
+
 bool DescriptorWriter::build(VkDescriptorSet &set) {
-  bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
+  bool success = allocator != nullptr
+                     ? allocator->allocateDescriptor(setLayout.getDescriptorSetLayout(), set)
+                     : pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
   if (!success) {
     return false;
   }
@@ -190,7 +412,7 @@ void DescriptorWriter::overwrite(VkDescriptorSet &set) {
   for (auto &write : writes) {
     write.dstSet = set;
   }
-  vkUpdateDescriptorSets(pool.engineDevice.device(), writes.size(), writes.data(), 0, nullptr);
+  vkUpdateDescriptorSets(setLayout.engineDevice.device(), writes.size(), writes.data(), 0, nullptr);
 }
 
 }  // namespace Cosmos
\ No newline at end of file
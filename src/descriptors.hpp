@@ -9,6 +9,9 @@
 
 namespace Cosmos {
 
+    class DescriptorSetLayoutCache;
+    class DescriptorAllocator;
+
     class DescriptorSetLayout {
     public:
         class Builder {
@@ -19,16 +22,22 @@ namespace Cosmos {
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlags bindingFlags = 0);
             std::unique_ptr<DescriptorSetLayout> build() const;
+            // Returns the layout shared by every builder with the same binding signature
+            std::shared_ptr<DescriptorSetLayout> build(DescriptorSetLayoutCache &cache) const;
 
         private:
             EngineDevice &engineDevice;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
         };
 
     DescriptorSetLayout(
-        EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+        EngineDevice &engineDevice,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags = {});
     ~DescriptorSetLayout();
     DescriptorSetLayout(const DescriptorSetLayout &) = delete;
     DescriptorSetLayout &operator=(const DescriptorSetLayout &) = delete;
@@ -72,6 +81,8 @@ namespace Cosmos {
 
         bool allocateDescriptor(
             const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
+        VkResult tryAllocateDescriptor(
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
 
         void freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const;
 
@@ -84,19 +95,116 @@ namespace Cosmos {
         friend class DescriptorWriter;
     };
 
+    /*
+    Caches descriptor set layouts by their binding signature, so systems that describe
+    the same bindings share one VkDescriptorSetLayout instead of creating duplicates.
+    */
+    class DescriptorSetLayoutCache {
+    public:
+        DescriptorSetLayoutCache(EngineDevice &engineDevice) : engineDevice{engineDevice} {}
+        DescriptorSetLayoutCache(const DescriptorSetLayoutCache &) = delete;
+        DescriptorSetLayoutCache &operator=(const DescriptorSetLayoutCache &) = delete;
+
+        std::shared_ptr<DescriptorSetLayout> getLayout(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
+        size_t size() const { return layouts.size(); }
+        void clear() { layouts.clear(); }
+
+    private:
+        struct LayoutKey {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            std::vector<VkDescriptorBindingFlags> bindingFlags; // parallel to bindings
+            bool operator==(const LayoutKey &other) const;
+        };
+        struct LayoutKeyHash {
+            size_t operator()(const LayoutKey &key) const;
+        };
+
+        EngineDevice &engineDevice;
+        std::unordered_map<LayoutKey, std::shared_ptr<DescriptorSetLayout>, LayoutKeyHash> layouts;
+    };
+
+    /*
+    Growable descriptor allocator. Owns a chain of DescriptorPools: when the current pool
+    runs out (VK_ERROR_OUT_OF_POOL_MEMORY / VK_ERROR_FRAGMENTED_POOL) a new, larger pool is
+    created and allocation is retried. resetPools() returns every set at once, which makes
+    one allocator per frame in flight a cheap home for transient descriptor sets.
+    */
+    class DescriptorAllocator {
+    public:
+        struct PoolSizeRatio {
+            VkDescriptorType descriptorType;
+            float ratio; // descriptors of this type per set
+        };
+
+        class Builder {
+        public:
+            Builder(EngineDevice &engineDevice) : engineDevice{engineDevice} {}
+
+            Builder &addPoolSizeRatio(VkDescriptorType descriptorType, float ratio);
+            Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+            Builder &setInitialSets(uint32_t count);
+            Builder &setMaxSetsPerPool(uint32_t count);
+            std::unique_ptr<DescriptorAllocator> build() const;
+
+        private:
+            EngineDevice &engineDevice;
+            std::vector<PoolSizeRatio> ratios{};
+            uint32_t initialSets = 64;
+            uint32_t maxSetsPerPool = 4096;
+            VkDescriptorPoolCreateFlags poolFlags = 0;
+        };
+
+        DescriptorAllocator(
+            EngineDevice &engineDevice,
+            uint32_t initialSets,
+            uint32_t maxSetsPerPool,
+            VkDescriptorPoolCreateFlags poolFlags,
+            const std::vector<PoolSizeRatio> &ratios);
+        DescriptorAllocator(const DescriptorAllocator &) = delete;
+        DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+        bool allocateDescriptor(
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor);
+
+        // Returns every set allocated since the last reset, keeps the pools for reuse
+        void resetPools();
+
+        size_t getPoolCount() const { return readyPools.size() + fullPools.size() + (currentPool ? 1 : 0); }
+
+    private:
+        std::unique_ptr<DescriptorPool> grabPool();
+
+        EngineDevice &engineDevice;
+        std::vector<PoolSizeRatio> ratios;
+        VkDescriptorPoolCreateFlags poolFlags;
+        uint32_t setsPerPool;
+        uint32_t maxSetsPerPool;
+
+        std::unique_ptr<DescriptorPool> currentPool;
+        std::vector<std::unique_ptr<DescriptorPool>> readyPools;
+        std::vector<std::unique_ptr<DescriptorPool>> fullPools;
+    };
+
     class DescriptorWriter {
         public:
         DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorPool &pool);
+        DescriptorWriter(DescriptorSetLayout &setLayout, DescriptorAllocator &allocator);
 
         DescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
         DescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+        // writes a single element of an arrayed binding (e.g. the bindless texture array)
+        DescriptorWriter &writeImage(
+            uint32_t binding, VkDescriptorImageInfo *imageInfo, uint32_t arrayElement);
 
         bool build(VkDescriptorSet &set);
         void overwrite(VkDescriptorSet &set);
 
     private:
         DescriptorSetLayout &setLayout;
-        DescriptorPool &pool;
+        DescriptorPool *pool = nullptr;
+        DescriptorAllocator *allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
     };
 
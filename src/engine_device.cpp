@@ -1,6 +1,7 @@
 #include "engine_device.hpp"
 
 // std headers
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -54,10 +55,19 @@ EngineDevice::EngineDevice(Window &window) : window{window} {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createTimelineSemaphore();
 }
 
 EngineDevice::~EngineDevice() {
+  // whatever was retired last is still sealed with a frame the GPU may be working on
+  vkDeviceWaitIdle(device_);
+  deletionQueue.flush();
+
+  for (VkCommandPool pool : uploadPools) {
+    vkDestroyCommandPool(device_, pool, nullptr);
+  }
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  vkDestroySemaphore(device_, graphicsTimeline_, nullptr);
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
@@ -79,7 +89,8 @@ void EngineDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // 1.2 for descriptor indexing (bindless textures)
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -155,18 +166,82 @@ void EngineDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
-  VkPhysicalDeviceFeatures deviceFeatures = {};
-  deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // descriptor indexing features used by the bindless material set
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.descriptorIndexing = VK_TRUE;
+  vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+  vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+  vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  // frame and upload synchronization
+  vulkan12Features.timelineSemaphore = VK_TRUE;
+
+  // block compressed textures are optional, cooked textures fall back to rgba8 without them
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+  textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+  VkPhysicalDeviceFeatures2 deviceFeatures = {};
+  deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  deviceFeatures.features.samplerAnisotropy = VK_TRUE;
+  deviceFeatures.features.textureCompressionBC = supportedFeatures.textureCompressionBC;
+  deviceFeatures.pNext = &vulkan12Features;
+
+  // present timing for the frame pacer, optional, it falls back to the time vkQueuePresentKHR returns
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+  presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+  presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  bool presentWait = false;
+  if (isDeviceExtensionAvailable(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+      isDeviceExtensionAvailable(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+    presentIdFeatures.pNext = &presentWaitFeatures;
+    VkPhysicalDeviceFeatures2 supported = {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &presentIdFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+    presentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+  }
+  // optional feature structs are appended to the chain behind vulkan12Features
+  void **featureChainEnd = &vulkan12Features.pNext;
+  if (presentWait) {
+    enabledExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    enabledExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    *featureChainEnd = &presentIdFeatures;
+    featureChainEnd = &presentWaitFeatures.pNext;
+  }
+
+  // rendering without render pass and framebuffer objects, optional, the swap chain keeps its render pass without it
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  bool dynamicRendering = false;
+  if (isDeviceExtensionAvailable(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+    VkPhysicalDeviceFeatures2 supported = {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+    dynamicRendering = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+  }
+  if (dynamicRendering) {
+    enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    *featureChainEnd = &dynamicRenderingFeatures;
+    featureChainEnd = &dynamicRenderingFeatures.pNext;
+  }
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &deviceFeatures;
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-  createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  // features are passed through VkPhysicalDeviceFeatures2 in pNext
+  createInfo.pEnabledFeatures = nullptr;
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -183,6 +258,17 @@ void EngineDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+  if (presentWait) {
+    vkWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+        vkGetDeviceProcAddr(device_, "vkWaitForPresentKHR"));
+  }
+  if (dynamicRendering) {
+    cmdBeginRendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+    cmdEndRendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+  }
 }
 
 void EngineDevice::createCommandPool() {
@@ -199,6 +285,21 @@ void EngineDevice::createCommandPool() {
   }
 }
 
+void EngineDevice::createTimelineSemaphore() {
+  VkSemaphoreTypeCreateInfo typeInfo = {};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphoreInfo = {};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = &typeInfo;
+
+  if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &graphicsTimeline_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create graphics timeline semaphore!");
+  }
+}
+
 void EngineDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
 
 bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
@@ -216,7 +317,30 @@ bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
   vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
   return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+         supportedFeatures.samplerAnisotropy && checkDeviceFeatureSupport(device);
+}
+
+bool EngineDevice::checkDeviceFeatureSupport(VkPhysicalDevice device) {
+  VkPhysicalDeviceProperties deviceProperties;
+  vkGetPhysicalDeviceProperties(device, &deviceProperties);
+  if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+  VkPhysicalDeviceFeatures2 features = {};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  return vulkan12Features.descriptorIndexing && vulkan12Features.runtimeDescriptorArray &&
+         vulkan12Features.descriptorBindingPartiallyBound &&
+         vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+         vulkan12Features.descriptorBindingUpdateUnusedWhilePending &&
+         vulkan12Features.shaderSampledImageArrayNonUniformIndexing &&
+         vulkan12Features.timelineSemaphore;
 }
 
 void EngineDevice::populateDebugMessengerCreateInfo(
@@ -323,6 +447,23 @@ bool EngineDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+bool EngineDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      device,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (std::strcmp(extension.extensionName, extensionName) == 0) return true;
+  }
+  return false;
+}
+
 QueueFamilyIndices EngineDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -396,6 +537,12 @@ VkFormat EngineDevice::findSupportedFormat(
   throw std::runtime_error("failed to find supported format!");
 }
 
+VkFormatProperties EngineDevice::getFormatProperties(VkFormat format) {
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+  return props;
+}
+
 uint32_t EngineDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
   VkPhysicalDeviceMemoryProperties memProperties;
   vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
@@ -441,14 +588,39 @@ void EngineDevice::createBuffer(
 }
 
 VkCommandBuffer EngineDevice::beginSingleTimeCommands() {
+  // command pools are externally synchronized, loader threads must not share the renderer's pool
+  VkCommandPool pool = VK_NULL_HANDLE;
+  {
+    std::lock_guard<std::mutex> lock{uploadPoolMutex};
+    if (!freeUploadPools.empty()) {
+      pool = freeUploadPools.back();
+      freeUploadPools.pop_back();
+    }
+  }
+  if (pool == VK_NULL_HANDLE) {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = findPhysicalQueueFamilies().graphicsFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload command pool!");
+    }
+    std::lock_guard<std::mutex> lock{uploadPoolMutex};
+    uploadPools.push_back(pool);
+  }
+
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandPool = commandPool;
+  allocInfo.commandPool = pool;
   allocInfo.commandBufferCount = 1;
 
   VkCommandBuffer commandBuffer;
   vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+  {
+    std::lock_guard<std::mutex> lock{uploadPoolMutex};
+    openUploadCommandBuffers[commandBuffer] = pool;
+  }
 
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -466,10 +638,70 @@ void EngineDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  waitForGraphicsValue(submitGraphics(submitInfo));
+
+  std::lock_guard<std::mutex> lock{uploadPoolMutex};
+  VkCommandPool pool = openUploadCommandBuffers.at(commandBuffer);
+  openUploadCommandBuffers.erase(commandBuffer);
+  vkFreeCommandBuffers(device_, pool, 1, &commandBuffer);
+  freeUploadPools.push_back(pool);
+}
+
+uint64_t EngineDevice::submitGraphics(const VkSubmitInfo &submit) {
+  // binary semaphores the caller signals stay, the timeline is appended; values of binary ones are ignored
+  std::vector<VkSemaphore> signalSemaphores(submit.pSignalSemaphores, submit.pSignalSemaphores + submit.signalSemaphoreCount);
+  signalSemaphores.push_back(graphicsTimeline_);
+  std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.pNext = submit.pNext;
+  timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+  timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+  VkSubmitInfo timelineSubmit = submit;
+  timelineSubmit.pNext = &timelineInfo;
+  timelineSubmit.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+  timelineSubmit.pSignalSemaphores = signalSemaphores.data();
+
+  std::lock_guard<std::mutex> lock{queueMutex};
+  // values have to increase in submission order, so the value is taken under the queue lock
+  signalValues.back() = graphicsTimelineValue + 1;
+  if (vkQueueSubmit(graphicsQueue_, 1, &timelineSubmit, VK_NULL_HANDLE) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit to the graphics queue!");
+  }
+  return ++graphicsTimelineValue;
+}
+
+uint64_t EngineDevice::getSubmittedGraphicsValue() {
+  std::lock_guard<std::mutex> lock{queueMutex};
+  return graphicsTimelineValue;
+}
+
+uint64_t EngineDevice::getCompletedGraphicsValue() {
+  uint64_t value = 0;
+  vkGetSemaphoreCounterValue(device_, graphicsTimeline_, &value);
+  return value;
+}
+
+bool EngineDevice::waitForGraphicsValue(uint64_t value, uint64_t timeout) {
+  VkSemaphoreWaitInfo waitInfo = {};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &graphicsTimeline_;
+  waitInfo.pValues = &value;
+  return vkWaitSemaphores(device_, &waitInfo, timeout) == VK_SUCCESS;
+}
+
+VkResult EngineDevice::present(const VkPresentInfoKHR &presentInfo) {
+  std::lock_guard<std::mutex> lock{queueMutex};
+  return vkQueuePresentKHR(presentQueue_, &presentInfo);
+}
 
-  vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+VkResult EngineDevice::waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout) {
+  assert(supportsPresentWait() && "Present wait is not enabled on this device");
+  // not a queue operation, meant to block a thread of its own while the queue keeps going
+  return vkWaitForPresent(device_, swapChain, presentId, timeout);
 }
 
 void EngineDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
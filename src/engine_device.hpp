@@ -1,9 +1,14 @@
 #pragma once
 
+#include "deletion_queue.hpp"
 #include "window.hpp"
 
 // std lib headers
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <iostream>
@@ -65,6 +70,16 @@ class EngineDevice {
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+  VkFormatProperties getFormatProperties(VkFormat format);
+  bool supportsTextureCompressionBC() const { return textureCompressionBC; }
+  // VK_KHR_present_id + VK_KHR_present_wait, optional
+  bool supportsPresentWait() const { return vkWaitForPresent != nullptr; }
+  // VK_KHR_dynamic_rendering, optional: rendering without render pass and framebuffer objects
+  bool supportsDynamicRendering() const { return cmdBeginRendering_ != nullptr; }
+  void cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR &renderingInfo) {
+    cmdBeginRendering_(commandBuffer, &renderingInfo);
+  }
+  void cmdEndRendering(VkCommandBuffer commandBuffer) { cmdEndRendering_(commandBuffer); }
 
   // Buffer Helper Functions
   void createBuffer(
@@ -73,8 +88,32 @@ class EngineDevice {
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
       VkDeviceMemory &bufferMemory);
+  // Thread safe, every open single time command buffer comes from a pool of its own.
+  // endSingleTimeCommands waits for this submit's timeline value only, not for the whole queue
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+  // The graphics and present queue need external synchronization, every submit goes through these.
+  // Each graphics submit additionally signals the next value of the graphics timeline, which it returns;
+  // work is complete once getCompletedGraphicsValue reaches that value
+  uint64_t submitGraphics(const VkSubmitInfo &submit);
+  VkResult present(const VkPresentInfoKHR &presentInfo);
+
+  // Graphics queue timeline semaphore, one counter for CPU waits, retirement and cross queue waits
+  VkSemaphore graphicsTimeline() { return graphicsTimeline_; }
+  uint64_t getSubmittedGraphicsValue();
+  uint64_t getCompletedGraphicsValue();
+  // Blocks until the graphics timeline reached value, false on timeout
+  bool waitForGraphicsValue(uint64_t value, uint64_t timeout = UINT64_MAX);
+  // Blocks until the present with presentId reached the display, only with supportsPresentWait
+  VkResult waitForPresent(VkSwapchainKHR swapChain, uint64_t presentId, uint64_t timeout);
+
+  // Deferred destruction (see DeletionQueue): the deleter runs once no submitted frame can use the object anymore.
+  // Thread safe, retire from destructors instead of destroying Vulkan objects directly
+  void retire(DeletionQueue::Deleter deleter) { deletionQueue.retire(std::move(deleter)); }
+  // Right after a frame submit, with the timeline value that submit signals
+  void sealRetired(uint64_t frameValue) { deletionQueue.seal(frameValue); }
+  // Once per frame, destroys what the GPU is done with
+  void collectRetired() { deletionQueue.collect(getCompletedGraphicsValue()); }
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
@@ -94,6 +133,7 @@ class EngineDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createTimelineSemaphore();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -103,6 +143,8 @@ class EngineDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool checkDeviceFeatureSupport(VkPhysicalDevice device);
+  bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
@@ -115,6 +157,19 @@ class EngineDevice {
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkSemaphore graphicsTimeline_;
+  uint64_t graphicsTimelineValue = 0; // last value a submit signals, guarded by queueMutex
+  bool textureCompressionBC = false;
+  PFN_vkWaitForPresentKHR vkWaitForPresent = nullptr;
+  PFN_vkCmdBeginRenderingKHR cmdBeginRendering_ = nullptr;
+  PFN_vkCmdEndRenderingKHR cmdEndRendering_ = nullptr;
+
+  std::mutex queueMutex;
+  DeletionQueue deletionQueue;
+  std::mutex uploadPoolMutex;
+  std::vector<VkCommandPool> uploadPools;  // all of them, destroyed with the device
+  std::vector<VkCommandPool> freeUploadPools;
+  std::unordered_map<VkCommandBuffer, VkCommandPool> openUploadCommandBuffers;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {
@@ -1,24 +1,27 @@
 #include "engine_swap_chain.hpp"
 
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <set>
 #include <stdexcept>
 
 namespace Cosmos {
 
-EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent)
-  : device{deviceRef}, windowExtent{extent} {
+EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, const Settings &settings)
+  : device{deviceRef}, windowExtent{extent}, settings{settings} {
   
   init();
 }
 
-EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, std::shared_ptr<EngineSwapChain> previous)
-  : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, const Settings &settings,
+    std::shared_ptr<EngineSwapChain> previous)
+  : device{deviceRef}, windowExtent{extent}, settings{settings}, oldSwapChain{previous} {
   
   init();
 
@@ -28,6 +31,10 @@ EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, std
 
 void EngineSwapChain::init()
 {
+  if (settings.framesInFlight < MIN_FRAMES_IN_FLIGHT || settings.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+    throw std::runtime_error("frames in flight must be between 1 and 4!");
+  }
+  dynamicRendering = settings.dynamicRendering && device.supportsDynamicRendering();
   createSwapChain();
   createImageViews();
   createRenderPass();
@@ -38,43 +45,44 @@ void EngineSwapChain::init()
 
 
 EngineSwapChain::~EngineSwapChain() {
-  for (auto imageView : swapChainImageViews) {
-    vkDestroyImageView(device.device(), imageView, nullptr);
-  }
-  swapChainImageViews.clear();
-
-  if (swapChain != nullptr) {
-    vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
-    swapChain = nullptr;
-  }
-
-  for (int i = 0; i < depthImages.size(); i++) {
-    vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-    vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
-  }
-
-  for (auto framebuffer : swapChainFramebuffers) {
-    vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
-  }
-
-  vkDestroyRenderPass(device.device(), renderPass, nullptr);
+  // frames in flight and their presents may still use all of this. A render pass or depth images
+  // taken over by the next swap chain are no longer in here.
+  // Without VK_EXT_swapchain_maintenance1 there is no signal for a finished present, the swap chain
+  // goes once the frame submitted after it completed, the last present waited for an earlier one
+  device.retire([vkDevice = device.device(),
+                 swapChain = swapChain,
+                 imageViews = swapChainImageViews,
+                 framebuffers = swapChainFramebuffers,
+                 depthImages = depthImages,
+                 renderPass = renderPass,
+                 renderFinishedSemaphores = renderFinishedSemaphores,
+                 imageAvailableSemaphores = imageAvailableSemaphores]() {
+    for (auto framebuffer : framebuffers) {
+      vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+    }
+    for (auto imageView : imageViews) {
+      vkDestroyImageView(vkDevice, imageView, nullptr);
+    }
+    for (const auto &depthImage : depthImages) {
+      vkDestroyImageView(vkDevice, depthImage.view, nullptr);
+      vkDestroyImage(vkDevice, depthImage.image, nullptr);
+      vkFreeMemory(vkDevice, depthImage.memory, nullptr);
+    }
+    vkDestroyRenderPass(vkDevice, renderPass, nullptr);
 
-  // cleanup synchronization objects
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-    vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-    vkDestroyFence(device.device(), inFlightFences[i], nullptr);
-  }
+    // cleanup synchronization objects
+    for (auto semaphore : renderFinishedSemaphores) {
+      vkDestroySemaphore(vkDevice, semaphore, nullptr);
+    }
+    for (auto semaphore : imageAvailableSemaphores) {
+      vkDestroySemaphore(vkDevice, semaphore, nullptr);
+    }
+    vkDestroySwapchainKHR(vkDevice, swapChain, nullptr);
+  });
 }
 
 VkResult EngineSwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+  device.waitForGraphicsValue(frameTimelineValues[currentFrame]);
 
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
@@ -88,11 +96,9 @@ VkResult EngineSwapChain::acquireNextImage(uint32_t *imageIndex) {
 }
 
 VkResult EngineSwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
-  if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-    vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-  }
-  imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+    const VkCommandBuffer *buffers, uint32_t *imageIndex, uint64_t *presentId) {
+  // the depth image of this swap chain image may still be used by a frame of another slot
+  device.waitForGraphicsValue(depthImages[*imageIndex].lastUse);
 
   VkSubmitInfo submitInfo = {};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -106,15 +112,14 @@ VkResult EngineSwapChain::submitCommandBuffers(
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = buffers;
 
-  VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+  VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[*imageIndex]};
   submitInfo.signalSemaphoreCount = 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
-  vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
-  }
+  frameTimelineValues[currentFrame] = device.submitGraphics(submitInfo);
+  depthImages[*imageIndex].lastUse = frameTimelineValues[currentFrame];
+  // objects retired while this frame was recorded may be used by it
+  device.sealRetired(frameTimelineValues[currentFrame]);
 
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -128,9 +133,21 @@ VkResult EngineSwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
-  auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  VkPresentIdKHR presentIdInfo = {};
+  const uint64_t id = ++presentCount;
+  if (device.supportsPresentWait()) {
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &id;
+    presentInfo.pNext = &presentIdInfo;
+  }
+  if (presentId != nullptr) {
+    *presentId = device.supportsPresentWait() ? id : 0;
+  }
+
+  auto result = device.present(presentInfo);
 
-  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
   return result;
 }
@@ -141,10 +158,11 @@ void EngineSwapChain::createSwapChain()
     SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
     VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+    uint32_t imageCount = settings.imageCount != 0 ? settings.imageCount : swapChainSupport.capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
     if (swapChainSupport.capabilities.maxImageCount > 0 &&
         imageCount > swapChainSupport.capabilities.maxImageCount)
     {
@@ -222,14 +240,27 @@ void EngineSwapChain::createImageViews() {
 }
 
 void EngineSwapChain::createRenderPass() {
+  swapChainDepthFormat = findDepthFormat();
+  if (dynamicRendering) {
+    // pipelines only know the attachment formats, the renderer begins rendering with the views themselves
+    return;
+  }
+  if (oldSwapChain != nullptr && compareSwapFormats(*oldSwapChain)) {
+    // same attachments, pipelines created against the old render pass stay valid with the very same object
+    renderPass = oldSwapChain->renderPass;
+    oldSwapChain->renderPass = VK_NULL_HANDLE;
+    return;
+  }
+
   VkAttachmentDescription depthAttachment{};
-  depthAttachment.format = findDepthFormat();
+  depthAttachment.format = swapChainDepthFormat;
   depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
   depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
   depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  // layout transitions and their synchronization happen in the render graph, outside the render pass
+  depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
   depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
   VkAttachmentReference depthAttachmentRef{};
@@ -243,8 +274,8 @@ void EngineSwapChain::createRenderPass() {
   colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
   colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
   VkAttachmentReference colorAttachmentRef = {};
   colorAttachmentRef.attachment = 0;
@@ -256,17 +287,6 @@ void EngineSwapChain::createRenderPass() {
   subpass.pColorAttachments = &colorAttachmentRef;
   subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
-  VkSubpassDependency dependency = {};
-  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependency.srcAccessMask = 0;
-  dependency.srcStageMask =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-  dependency.dstSubpass = 0;
-  dependency.dstStageMask =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-  dependency.dstAccessMask =
-      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
   std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
   VkRenderPassCreateInfo renderPassInfo = {};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -274,8 +294,6 @@ void EngineSwapChain::createRenderPass() {
   renderPassInfo.pAttachments = attachments.data();
   renderPassInfo.subpassCount = 1;
   renderPassInfo.pSubpasses = &subpass;
-  renderPassInfo.dependencyCount = 1;
-  renderPassInfo.pDependencies = &dependency;
 
   if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
     throw std::runtime_error("failed to create render pass!");
@@ -283,9 +301,12 @@ void EngineSwapChain::createRenderPass() {
 }
 
 void EngineSwapChain::createFramebuffers() {
+  if (dynamicRendering) {
+    return;
+  }
   swapChainFramebuffers.resize(imageCount());
   for (size_t i = 0; i < imageCount(); i++) {
-    std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImageViews[i]};
+    std::array<VkImageView, 2> attachments = {swapChainImageViews[i], depthImages[i].view};
 
     VkExtent2D swapChainExtent = getSwapChainExtent();
     VkFramebufferCreateInfo framebufferInfo = {};
@@ -308,76 +329,108 @@ void EngineSwapChain::createFramebuffers() {
 }
 
 void EngineSwapChain::createDepthResources() {
-  VkFormat depthFormat = findDepthFormat();
-  swapChainDepthFormat = depthFormat;
-  VkExtent2D swapChainExtent = getSwapChainExtent();
+  VkExtent2D extent = getSwapChainExtent();
+  auto roundUp = [](uint32_t size) {
+    return (size + DEPTH_EXTENT_GRANULARITY - 1) / DEPTH_EXTENT_GRANULARITY * DEPTH_EXTENT_GRANULARITY;
+  };
+  VkExtent2D allocation = {roundUp(extent.width), roundUp(extent.height)};
+
+  // take over the previous swap chain's depth images of this size class, they keep their last use
+  // and the first frame rendering with one waits for it like for any other
+  std::vector<DepthImage> reusable;
+  if (oldSwapChain != nullptr && oldSwapChain->swapChainDepthFormat == swapChainDepthFormat) {
+    auto &previous = oldSwapChain->depthImages;
+    auto sameSize = [&](const DepthImage &depthImage) {
+      return depthImage.extent.width == allocation.width && depthImage.extent.height == allocation.height;
+    };
+    std::copy_if(previous.begin(), previous.end(), std::back_inserter(reusable), sameSize);
+    previous.erase(std::remove_if(previous.begin(), previous.end(), sameSize), previous.end());
+  }
 
   depthImages.resize(imageCount());
-  depthImageMemorys.resize(imageCount());
-  depthImageViews.resize(imageCount());
-
-  for (int i = 0; i < depthImages.size(); i++) {
-    VkImageCreateInfo imageInfo{};
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = swapChainExtent.width;
-    imageInfo.extent.height = swapChainExtent.height;
-    imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.format = depthFormat;
-    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    imageInfo.flags = 0;
-
-    device.createImageWithInfo(
-        imageInfo,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        depthImages[i],
-        depthImageMemorys[i]);
-
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = depthImages[i];
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = depthFormat;
-    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
-
-    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
-      throw std::runtime_error("failed to create texture image view!");
+  for (auto &depthImage : depthImages) {
+    if (!reusable.empty()) {
+      depthImage = reusable.back();
+      reusable.pop_back();
+    } else {
+      depthImage = createDepthImage(allocation);
     }
   }
+  // fewer images than before, the rest is retired with the previous swap chain
+  if (oldSwapChain != nullptr) {
+    oldSwapChain->depthImages.insert(oldSwapChain->depthImages.end(), reusable.begin(), reusable.end());
+  }
+}
+
+EngineSwapChain::DepthImage EngineSwapChain::createDepthImage(VkExtent2D extent) {
+  DepthImage depthImage{};
+  depthImage.extent = extent;
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = extent.width;
+  imageInfo.extent.height = extent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = swapChainDepthFormat;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.flags = 0;
+
+  device.createImageWithInfo(
+      imageInfo,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      depthImage.image,
+      depthImage.memory);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = depthImage.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = swapChainDepthFormat;
+  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = 1;
+
+  if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImage.view) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create texture image view!");
+  }
+  return depthImage;
 }
 
 void EngineSwapChain::createSyncObjects() {
-  imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-  imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+  imageAvailableSemaphores.resize(settings.framesInFlight);
+  renderFinishedSemaphores.resize(imageCount());
+  if (oldSwapChain != nullptr) {
+    // same settings, the frame slots carry on: their command buffers may still be executing and
+    // the renderer keeps counting slots across swap chains
+    frameTimelineValues = oldSwapChain->frameTimelineValues;
+    currentFrame = oldSwapChain->currentFrame;
+  } else {
+    // a slot that never submitted waits for value 0, which the timeline starts at
+    frameTimelineValues.assign(settings.framesInFlight, 0);
+  }
 
   VkSemaphoreCreateInfo semaphoreInfo = {};
   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-  VkFenceCreateInfo fenceInfo = {};
-  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-            VK_SUCCESS ||
-        vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-            VK_SUCCESS ||
-        vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+  for (auto &semaphore : imageAvailableSemaphores) {
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
       throw std::runtime_error("failed to create synchronization objects for a frame!");
     }
   }
+  for (auto &semaphore : renderFinishedSemaphores) {
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create synchronization objects for an image!");
+    }
+  }
 }
 
 VkSurfaceFormatKHR EngineSwapChain::chooseSwapSurfaceFormat(
@@ -394,21 +447,24 @@ VkSurfaceFormatKHR EngineSwapChain::chooseSwapSurfaceFormat(
 
 VkPresentModeKHR EngineSwapChain::chooseSwapPresentMode(
     const std::vector<VkPresentModeKHR> &availablePresentModes) {
+  auto name = [](VkPresentModeKHR mode) {
+    switch (mode) {
+      case VK_PRESENT_MODE_IMMEDIATE_KHR: return "Immediate";
+      case VK_PRESENT_MODE_MAILBOX_KHR: return "Mailbox";
+      case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "V-Sync (relaxed)";
+      default: return "V-Sync";
+    }
+  };
+
   for (const auto &availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-      std::cout << "Present mode: Mailbox" << std::endl;
+    if (availablePresentMode == settings.presentMode) {
+      std::cout << "Present mode: " << name(availablePresentMode) << std::endl;
       return availablePresentMode;
     }
   }
 
-  // for (const auto &availablePresentMode : availablePresentModes) {
-  //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-  //     std::cout << "Present mode: Immediate" << std::endl;
-  //     return availablePresentMode;
-  //   }
-  // }
-
-  std::cout << "Present mode: V-Sync" << std::endl;
+  // FIFO is the only mode every surface has to support
+  std::cout << "Present mode: " << name(settings.presentMode) << " not supported, V-Sync" << std::endl;
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
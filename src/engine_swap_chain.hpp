@@ -14,20 +14,43 @@ namespace Cosmos {
 
 class EngineSwapChain {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  EngineSwapChain(EngineDevice &deviceRef, VkExtent2D windowExtent);
-  EngineSwapChain(EngineDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<EngineSwapChain> previous);
+  static constexpr uint32_t MIN_FRAMES_IN_FLIGHT = 1;
+  static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+  // Latency against throughput: fewer frames in flight and MAILBOX/IMMEDIATE keep input latency low,
+  // more frames and FIFO keep the GPU busy
+  struct Settings {
+    uint32_t framesInFlight = 2;                                // MIN_FRAMES_IN_FLIGHT..MAX_FRAMES_IN_FLIGHT
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR; // falls back to FIFO when unsupported
+    uint32_t imageCount = 0; // 0: one more than the surface minimum, always clamped to the surface limits
+    // No render pass and no framebuffers, recreation only replaces images. Needs VK_KHR_dynamic_rendering,
+    // the render pass is used without it
+    bool dynamicRendering = false;
+  };
+
+  EngineSwapChain(EngineDevice &deviceRef, VkExtent2D windowExtent, const Settings &settings);
+  // Recreation without waiting for the device: the render pass is kept when the formats match, depth
+  // images of the same size class are kept, the frame slots continue, everything else is retired
+  EngineSwapChain(EngineDevice &deviceRef, VkExtent2D windowExtent, const Settings &settings,
+      std::shared_ptr<EngineSwapChain> previous);
   ~EngineSwapChain();
 
   EngineSwapChain(const EngineSwapChain &) = delete;
   EngineSwapChain& operator=(const EngineSwapChain &) = delete;
 
   VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+  // VK_NULL_HANDLE with dynamic rendering
   VkRenderPass getRenderPass() { return renderPass; }
+  bool usesDynamicRendering() const { return dynamicRendering; }
+  VkImage getImage(int index) { return swapChainImages[index]; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  VkImage getDepthImage(int index) { return depthImages[index].image; }
+  VkImageView getDepthImageView(int index) { return depthImages[index].view; }
   size_t imageCount() { return swapChainImages.size(); }
+  uint32_t getFramesInFlight() const { return settings.framesInFlight; }
+  VkPresentModeKHR getPresentMode() const { return presentMode; }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+  VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
@@ -37,8 +60,14 @@ class EngineSwapChain {
   }
   VkFormat findDepthFormat();
 
+  // Waits until the graphics timeline passed the last submit of this frame slot, then acquires
   VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  // presentId receives the id the image was presented with, 0 without present wait support
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex, uint64_t *presentId = nullptr);
+  // Ids count up from 1 per swap chain, see EngineDevice::waitForPresent
+  VkResult waitForPresent(uint64_t presentId, uint64_t timeout) {
+    return device.waitForPresent(swapChain, presentId, timeout);
+  }
 
   bool compareSwapFormats(const EngineSwapChain& swapChain) const {
     return swapChain.swapChainDepthFormat == swapChainDepthFormat 
@@ -46,6 +75,18 @@ class EngineSwapChain {
   }
 
  private:
+  // Depth images are allocated in steps of this many pixels and rendered at the swap chain extent,
+  // dragging a window edge stays within one size class for a while and allocates nothing
+  static constexpr uint32_t DEPTH_EXTENT_GRANULARITY = 128;
+
+  struct DepthImage {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkExtent2D extent{}; // allocated size, a multiple of DEPTH_EXTENT_GRANULARITY
+    uint64_t lastUse = 0; // graphics timeline value of the last submit rendering with it
+  };
+
   void init();
   void createSwapChain();
   void createImageViews();
@@ -53,6 +94,7 @@ class EngineSwapChain {
   void createRenderPass();
   void createFramebuffers();
   void createSyncObjects();
+  DepthImage createDepthImage(VkExtent2D extent);
 
   // Helper functions
   VkSurfaceFormatKHR chooseSwapSurfaceFormat(
@@ -65,26 +107,27 @@ class EngineSwapChain {
   VkFormat swapChainDepthFormat;
   VkExtent2D swapChainExtent;
 
-  std::vector<VkFramebuffer> swapChainFramebuffers;
-  VkRenderPass renderPass;
+  bool dynamicRendering = false;
+  std::vector<VkFramebuffer> swapChainFramebuffers; // empty with dynamic rendering
+  VkRenderPass renderPass = VK_NULL_HANDLE;
 
-  std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
-  std::vector<VkImageView> depthImageViews;
+  std::vector<DepthImage> depthImages; // per swap chain image
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
 
   EngineDevice &device;
   VkExtent2D windowExtent;
+  const Settings settings;
+  VkPresentModeKHR presentMode;
 
   VkSwapchainKHR swapChain;
   std::shared_ptr<EngineSwapChain> oldSwapChain;
 
-  std::vector<VkSemaphore> imageAvailableSemaphores;
-  std::vector<VkSemaphore> renderFinishedSemaphores;
-  std::vector<VkFence> inFlightFences;
-  std::vector<VkFence> imagesInFlight;
+  std::vector<VkSemaphore> imageAvailableSemaphores; // per frame slot
+  std::vector<VkSemaphore> renderFinishedSemaphores; // per image, its present waited on it before it is reacquired
+  std::vector<uint64_t> frameTimelineValues;         // graphics timeline value of each slot's last submit
   size_t currentFrame = 0;
+  uint64_t presentCount = 0;
 };
 
 }  // namespace lve
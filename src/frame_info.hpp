@@ -2,9 +2,15 @@
 
 #include "camera.hpp"
 #include "game_object.hpp"
+#include "descriptors.hpp"
 
 #include <vulkan/vulkan.h>
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace Cosmos {
 
     #define MAX_LIGHTS 10
@@ -25,13 +31,42 @@ namespace Cosmos {
         int numLights;
     };
 
+    // Snapshot of one game object for the render thread, matrices are resolved on the main thread
+    struct RenderObject {
+        GameObject::id_t id;
+        std::shared_ptr<Model> model{}; // keeps the model alive until the frame is recorded
+        glm::mat4 modelMatrix{1.f};
+        glm::mat3 normalMatrix{1.f};
+        glm::vec3 position{};
+        float maxScale = 1.f;           // largest absolute scale factor
+        glm::vec3 color{};
+        uint32_t materialIndex = 0;
+        bool pointLight = false;
+        float lightIntensity = 0.f;
+        float lightRadius = 0.f;
+    };
+
+    // Everything the render thread needs for one frame, built by the main thread
+    struct FramePacket {
+        uint64_t frameNumber = 0;
+        float frameTime = 0.f;
+        std::chrono::steady_clock::time_point inputTime{}; // events were polled, for the FramePacer
+        Camera camera{};
+        float fovY = 0.f;
+        GlobalUbo ubo{};
+        std::vector<RenderObject> objects{}; // models inside the view frustum and every point light
+    };
+
     struct FrameInfo{
         int frameIndex;
         float frameTime;
         VkCommandBuffer commandBuffer;
         Camera camera;
         VkDescriptorSet globalDescriptorSet;
-        GameObject::Map &gameObjects;
+        const std::vector<RenderObject> &objects;
+        DescriptorAllocator &frameDescriptorAllocator; // transient sets, valid for this frame only
+        VkDescriptorSet materialDescriptorSet; // bindless textures + material buffer
+        VkExtent2D extent; // swap chain extent, for screen space metrics
     };
     
 }
\ No newline at end of file
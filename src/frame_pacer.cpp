@@ -0,0 +1,174 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+namespace Cosmos {
+
+    namespace {
+        double milliseconds(FramePacer::Clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+    }
+
+    void FramePacer::Histogram::add(double value)
+    {
+        const double bucket = std::max(value, 0.0) / BUCKET_WIDTH;
+        buckets[std::min(static_cast<size_t>(bucket), BUCKET_COUNT - 1)]++;
+        total++;
+        sum += value;
+        maximum = std::max(maximum, value);
+    }
+
+    void FramePacer::Histogram::reset()
+    {
+        *this = Histogram{};
+    }
+
+    double FramePacer::Histogram::percentile(double fraction) const
+    {
+        if(total == 0) return 0.0;
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * total));
+        size_t seen = 0;
+        for(size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if(seen >= std::max<size_t>(rank, 1)) {
+                // upper edge, never above the largest sample (the overflow bucket has no edge at all)
+                return i + 1 < BUCKET_COUNT ? std::min((i + 1) * BUCKET_WIDTH, maximum) : maximum;
+            }
+        }
+        return maximum;
+    }
+
+    void FramePacer::Report::print(std::ostream& out) const
+    {
+        if(frameCount == 0) return;
+        const char* source = displayMeasured == frameCount ? "present wait"
+            : displayMeasured == 0 ? "present call, no present wait" : "present wait, partly present call";
+        const double framesPerSecond = seconds > 0.0 ? (frameCount - 1) / seconds : 0.0;
+        out << std::fixed << std::setprecision(1)
+            << "Frame pacing (" << source << "): " << frameCount << " frames, " << framesPerSecond << " fps\n"
+            << "  latency  avg " << latency.mean() << "  p50 " << latency.percentile(.5) << "  p99 "
+            << latency.percentile(.99) << "  max " << latency.max() << " ms\n"
+            << "  jitter   avg " << jitter.mean() << "  p50 " << jitter.percentile(.5) << "  p99 "
+            << jitter.percentile(.99) << "  max " << jitter.max() << " ms\n"
+            << "  input->acquire " << inputToAcquire << "  acquire->submit " << acquireToSubmit
+            << "  submit->display " << submitToDisplay << " ms" << std::endl;
+    }
+
+    FramePacer::FramePacer(PresentWaitFunction presentWait) : FramePacer{std::move(presentWait), Settings{}} {}
+
+    FramePacer::FramePacer(PresentWaitFunction presentWait, const Settings& settings)
+        : presentWait{std::move(presentWait)}, settings{settings}
+    {
+        thread = std::thread(&FramePacer::run, this);
+    }
+
+    FramePacer::~FramePacer()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            running = false;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    void FramePacer::waitForNextFrame()
+    {
+        if(settings.frameRateLimit <= 0.0) return;
+
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / settings.frameRateLimit));
+        const auto spin = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(settings.spinDuration));
+
+        auto now = Clock::now();
+        if(now < nextFrame)
+        {
+            // sleeping overshoots by up to a scheduler quantum, the last stretch is spun
+            if(nextFrame - now > spin) std::this_thread::sleep_for(nextFrame - now - spin);
+            while(Clock::now() < nextFrame) std::this_thread::yield();
+            nextFrame += period;
+        }
+        else
+        {
+            // late by less than a frame keeps the cadence, a longer stall (or the first frame) restarts it
+            nextFrame = now - nextFrame < period ? nextFrame + period : now + period;
+        }
+    }
+
+    void FramePacer::recordFrame(const FrameTimestamps& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            pending.push_back(frame);
+        }
+        condition.notify_one();
+    }
+
+    FramePacer::Report FramePacer::getLastReport() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return lastReport;
+    }
+
+    void FramePacer::run()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        while(true)
+        {
+            condition.wait(lock, [this]() { return !pending.empty() || !running; });
+            if(pending.empty()) break;
+
+            // the worker fell behind, the oldest frames are long on screen, don't wait for them
+            bool wait = pending.size() <= MAX_PENDING_FRAMES && running;
+            FrameTimestamps frame = pending.front();
+            pending.pop_front();
+            lock.unlock();
+
+            const bool measured = wait && presentWait && frame.presentId != 0 && presentWait(frame);
+            addFrame(frame, measured ? Clock::now() : frame.present, measured);
+
+            lock.lock();
+        }
+    }
+
+    void FramePacer::addFrame(const FrameTimestamps& frame, Clock::time_point display, bool measured)
+    {
+        if(current.frameCount == 0) reportStart = display;
+
+        current.frameCount++;
+        current.displayMeasured += measured;
+        current.latency.add(milliseconds(display - frame.input));
+        stageSums[0] += milliseconds(frame.acquire - frame.input);
+        stageSums[1] += milliseconds(frame.submit - frame.acquire);
+        stageSums[2] += milliseconds(display - frame.submit);
+
+        if(lastDisplay != Clock::time_point{})
+        {
+            const double interval = milliseconds(display - lastDisplay);
+            if(lastInterval >= 0.0) current.jitter.add(std::abs(interval - lastInterval));
+            lastInterval = interval;
+        }
+        lastDisplay = display;
+
+        current.seconds = std::chrono::duration<double>(display - reportStart).count();
+        if(settings.reportInterval <= 0.0 || current.seconds < settings.reportInterval) return;
+
+        current.inputToAcquire = stageSums[0] / current.frameCount;
+        current.acquireToSubmit = stageSums[1] / current.frameCount;
+        current.submitToDisplay = stageSums[2] / current.frameCount;
+        current.print(std::cout);
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            lastReport = current;
+        }
+        current = Report{};
+        std::fill(std::begin(stageSums), std::end(stageSums), 0.0);
+    }
+}
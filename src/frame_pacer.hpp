@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace Cosmos {
+
+    // Where one frame was on its way from input to display
+    struct FrameTimestamps {
+        using Clock = std::chrono::steady_clock;
+
+        uint64_t frameNumber = 0;
+        Clock::time_point input{};   // events polled, main thread
+        Clock::time_point acquire{}; // swap chain image acquired, includes the wait for the frame slot
+        Clock::time_point submit{};  // command buffer handed to the queue
+        Clock::time_point present{}; // vkQueuePresentKHR returned
+        uint64_t presentId = 0;      // 0 without VK_KHR_present_wait
+        uint64_t swapChainGeneration = 0; // present ids restart with every swap chain
+    };
+
+    /*
+    Frame pacing instrumentation and an optional frame rate limiter. Every presented frame is handed
+    to recordFrame, a worker thread waits until the image is actually on screen (VK_KHR_present_wait)
+    and derives the input to photon latency from it. Without present wait the time vkQueuePresentKHR
+    returned stands in for the display time, which misses the GPU, the compositor and the scan out,
+    the report says which one was measured.
+    Latency and jitter (change of the display interval from one frame to the next) are collected in
+    histograms and printed every reportInterval.
+    */
+    class FramePacer {
+    public:
+        using Clock = FrameTimestamps::Clock;
+        // Blocks until the frame reached the display, false if that can't be known (no present id, timeout,
+        // swap chain replaced), the frame then falls back to its present timestamp
+        using PresentWaitFunction = std::function<bool(const FrameTimestamps& frame)>;
+
+        struct Settings {
+            double frameRateLimit = 0.0; // frames per second, 0 disables the limiter
+            double spinDuration = 0.002; // seconds before the deadline the limiter stops sleeping and spins
+            double reportInterval = 5.0; // seconds, 0 disables the report
+        };
+
+        // Fixed 0.5 ms buckets, percentiles are bucket upper edges clamped to the maximum
+        class Histogram {
+        public:
+            static constexpr double BUCKET_WIDTH = 0.5; // milliseconds
+            static constexpr size_t BUCKET_COUNT = 200; // the last bucket takes everything above 99.5 ms
+
+            void add(double milliseconds);
+            void reset();
+
+            size_t count() const { return total; }
+            double mean() const { return total > 0 ? sum / total : 0.0; }
+            double max() const { return maximum; }
+            double percentile(double fraction) const;
+
+        private:
+            std::array<uint32_t, BUCKET_COUNT> buckets{};
+            size_t total = 0;
+            double sum = 0.0;
+            double maximum = 0.0;
+        };
+
+        struct Report {
+            size_t frameCount = 0;
+            double seconds = 0.0;
+            size_t displayMeasured = 0; // frames whose display time came from present wait
+            Histogram latency{};        // input to display
+            Histogram jitter{};         // |display interval - previous display interval|
+            double inputToAcquire = 0.0; // mean milliseconds of each stage
+            double acquireToSubmit = 0.0;
+            double submitToDisplay = 0.0;
+
+            void print(std::ostream& out) const;
+        };
+
+        explicit FramePacer(PresentWaitFunction presentWait);
+        FramePacer(PresentWaitFunction presentWait, const Settings& settings);
+        ~FramePacer();
+
+        FramePacer(const FramePacer&) = delete;
+        FramePacer& operator=(const FramePacer&) = delete;
+
+        // Main thread, before polling input: sleeps, then spins, until the next frame is due
+        void waitForNextFrame();
+        // Any thread, returns immediately
+        void recordFrame(const FrameTimestamps& frame);
+        // The last complete reporting interval
+        Report getLastReport() const;
+
+    private:
+        // frames waiting for their present, older ones are measured without waiting
+        static constexpr size_t MAX_PENDING_FRAMES = 16;
+
+        void run();
+        void addFrame(const FrameTimestamps& frame, Clock::time_point display, bool measured);
+
+        const PresentWaitFunction presentWait;
+        const Settings settings;
+        Clock::time_point nextFrame{}; // limiter deadline, main thread only
+
+        // worker thread only
+        Report current{};
+        Clock::time_point reportStart{};
+        Clock::time_point lastDisplay{};
+        double lastInterval = -1.0;
+        double stageSums[3] = {};
+
+        mutable std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<FrameTimestamps> pending{};
+        Report lastReport{};
+        bool running = true;
+
+        std::thread thread{}; // last, it starts once everything else is initialized
+    };
+}
@@ -51,6 +51,7 @@ namespace Cosmos {
         id_t getId() const {return id;}
 
         std::shared_ptr<Model> model{};
+        uint32_t materialIndex = 0; // index into MaterialSystem, 0 is the default material
         glm::vec3 color{};
         TransformComponent transform{};
 
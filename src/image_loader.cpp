@@ -0,0 +1,188 @@
+#include "image_loader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    namespace {
+
+        std::vector<uint8_t> readBinaryFile(const std::string& filepath)
+        {
+            std::ifstream file(filepath, std::ios::binary);
+            if(!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + filepath);
+            }
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // Truecolor / grayscale TGA, uncompressed (type 2, 3) or RLE (type 10, 11)
+        void decodeTga(const std::vector<uint8_t>& data, ImageData& image, const std::string& filepath)
+        {
+            if(data.size() < 18) {
+                throw std::runtime_error("truncated tga header: " + filepath);
+            }
+            const uint8_t idLength = data[0];
+            const uint8_t colorMapType = data[1];
+            const uint8_t imageType = data[2];
+            const uint32_t width = data[12] | (data[13] << 8);
+            const uint32_t height = data[14] | (data[15] << 8);
+            const uint8_t pixelDepth = data[16];
+            const bool topLeftOrigin = (data[17] & 0x20) != 0;
+
+            const bool rle = imageType == 10 || imageType == 11;
+            const bool grayscale = imageType == 3 || imageType == 11;
+            if(colorMapType != 0 || !(imageType == 2 || imageType == 3 || rle)) {
+                throw std::runtime_error("unsupported tga image type: " + filepath);
+            }
+            const uint32_t bytesPerPixel = pixelDepth / 8;
+            if((grayscale && bytesPerPixel != 1) || (!grayscale && bytesPerPixel != 3 && bytesPerPixel != 4)) {
+                throw std::runtime_error("unsupported tga pixel depth: " + filepath);
+            }
+
+            image.width = width;
+            image.height = height;
+            image.pixels.assign(static_cast<size_t>(width) * height * 4, 255);
+
+            size_t offset = 18 + idLength;
+            auto readPixel = [&](uint8_t* dst) {
+                if(offset + bytesPerPixel > data.size()) {
+                    throw std::runtime_error("truncated tga pixel data: " + filepath);
+                }
+                const uint8_t* src = data.data() + offset;
+                if(grayscale) {
+                    dst[0] = dst[1] = dst[2] = src[0];
+                } else {
+                    // stored as BGR(A)
+                    dst[0] = src[2];
+                    dst[1] = src[1];
+                    dst[2] = src[0];
+                    if(bytesPerPixel == 4) dst[3] = src[3];
+                }
+                offset += bytesPerPixel;
+            };
+
+            const size_t pixelCount = static_cast<size_t>(width) * height;
+            size_t pixel = 0;
+            while(pixel < pixelCount)
+            {
+                size_t runLength = 1;
+                bool repeat = false;
+                if(rle) {
+                    if(offset >= data.size()) {
+                        throw std::runtime_error("truncated tga rle data: " + filepath);
+                    }
+                    uint8_t packet = data[offset++];
+                    runLength = (packet & 0x7f) + 1;
+                    repeat = (packet & 0x80) != 0;
+                }
+                runLength = std::min(runLength, pixelCount - pixel);
+
+                uint8_t* first = &image.pixels[pixel * 4];
+                readPixel(first);
+                for(size_t i = 1; i < runLength; i++) {
+                    uint8_t* dst = &image.pixels[(pixel + i) * 4];
+                    if(repeat) {
+                        std::memcpy(dst, first, 4);
+                    } else {
+                        readPixel(dst);
+                    }
+                }
+                pixel += runLength;
+            }
+
+            // Vulkan expects the first row at the top
+            if(!topLeftOrigin) {
+                const size_t rowSize = static_cast<size_t>(width) * 4;
+                for(uint32_t y = 0; y < height / 2; y++) {
+                    std::swap_ranges(
+                        image.pixels.begin() + y * rowSize,
+                        image.pixels.begin() + (y + 1) * rowSize,
+                        image.pixels.begin() + (height - 1 - y) * rowSize);
+                }
+            }
+        }
+
+        // Binary 8 bit PPM (P6)
+        void decodePpm(const std::vector<uint8_t>& data, ImageData& image, const std::string& filepath)
+        {
+            size_t offset = 0;
+            auto skipWhitespaceAndComments = [&]() {
+                while(offset < data.size()) {
+                    if(data[offset] == '#') {
+                        while(offset < data.size() && data[offset] != '\n') offset++;
+                    } else if(std::isspace(data[offset])) {
+                        offset++;
+                    } else {
+                        break;
+                    }
+                }
+            };
+            auto readNumber = [&]() {
+                skipWhitespaceAndComments();
+                uint32_t value = 0;
+                bool hasDigits = false;
+                while(offset < data.size() && data[offset] >= '0' && data[offset] <= '9') {
+                    value = value * 10 + (data[offset++] - '0');
+                    hasDigits = true;
+                }
+                if(!hasDigits) {
+                    throw std::runtime_error("malformed ppm header: " + filepath);
+                }
+                return value;
+            };
+
+            if(data.size() < 2 || data[0] != 'P' || data[1] != '6') {
+                throw std::runtime_error("unsupported ppm format (expected P6): " + filepath);
+            }
+            offset = 2;
+            uint32_t width = readNumber();
+            uint32_t height = readNumber();
+            uint32_t maxValue = readNumber();
+            offset++; // single whitespace before the raster
+            if(maxValue == 0 || maxValue > 255) {
+                throw std::runtime_error("unsupported ppm bit depth: " + filepath);
+            }
+
+            const size_t pixelCount = static_cast<size_t>(width) * height;
+            if(offset + pixelCount * 3 > data.size()) {
+                throw std::runtime_error("truncated ppm pixel data: " + filepath);
+            }
+
+            image.width = width;
+            image.height = height;
+            image.pixels.resize(pixelCount * 4);
+            for(size_t i = 0; i < pixelCount; i++) {
+                for(int c = 0; c < 3; c++) {
+                    image.pixels[i * 4 + c] = static_cast<uint8_t>(data[offset + i * 3 + c] * 255 / maxValue);
+                }
+                image.pixels[i * 4 + 3] = 255;
+            }
+        }
+
+        bool hasExtension(const std::string& filepath, const std::string& extension)
+        {
+            if(filepath.size() < extension.size()) return false;
+            return std::equal(extension.rbegin(), extension.rend(), filepath.rbegin(),
+                [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+        }
+    }
+
+    ImageData loadImageFile(const std::string& filepath)
+    {
+        auto data = readBinaryFile(filepath);
+        ImageData image{};
+        if(hasExtension(filepath, ".tga")) {
+            decodeTga(data, image, filepath);
+        } else if(hasExtension(filepath, ".ppm")) {
+            decodePpm(data, image, filepath);
+        } else {
+            throw std::runtime_error("unsupported image format: " + filepath);
+        }
+        return image;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Cosmos {
+
+    // CPU side image, tightly packed RGBA8, first row at the top
+    struct ImageData {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels{};
+    };
+
+    // Supports uncompressed/RLE truecolor or grayscale .tga and binary .ppm
+    ImageData loadImageFile(const std::string& filepath);
+}
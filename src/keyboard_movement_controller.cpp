@@ -2,42 +2,52 @@
 
 namespace Cosmos{
     
-    void KeyboardMovementController::moveInPlaneXZ(GLFWwindow *window, float dt, GameObject &gameObject)
+    KeyboardMovementController::Input KeyboardMovementController::sampleInput(GLFWwindow *window) const
     {
-        // ---------------- Rotation ----------------
-        glm::vec3 rotate{0};
-        if(glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
-        if(glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.f;
-        if(glfwGetKey(window, keys.lookUp) == GLFW_PRESS) rotate.x += 1.f;
-        if(glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
+        Input input{};
+        if(glfwGetKey(window, keys.lookRight) == GLFW_PRESS) input.rotate.y += 1.f;
+        if(glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) input.rotate.y -= 1.f;
+        if(glfwGetKey(window, keys.lookUp) == GLFW_PRESS) input.rotate.x += 1.f;
+        if(glfwGetKey(window, keys.lookDown) == GLFW_PRESS) input.rotate.x -= 1.f;
 
+        if(glfwGetKey(window, keys.moveForward) == GLFW_PRESS) input.move.z += 1.f;
+        if(glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) input.move.z -= 1.f;
+        if(glfwGetKey(window, keys.moveRight) == GLFW_PRESS) input.move.x += 1.f;
+        if(glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) input.move.x -= 1.f;
+        if(glfwGetKey(window, keys.moveUp) == GLFW_PRESS) input.move.y += 1.f;
+        if(glfwGetKey(window, keys.moveDown) == GLFW_PRESS) input.move.y -= 1.f;
+        return input;
+    }
+
+    void KeyboardMovementController::apply(const Input& input, float dt, TransformComponent& transform) const
+    {
+        // ---------------- Rotation ----------------
         // Check if not normilizing zero vector
-        if(glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
+        if(glm::dot(input.rotate, input.rotate) > std::numeric_limits<float>::epsilon())
         {
-            gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+            transform.rotation += lookSpeed * dt * glm::normalize(input.rotate);
         }
         // limit pitch values between about +/- 85 ish degrees
-        gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-        gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+        transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+        transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-        float yaw = gameObject.transform.rotation.y;
+        float yaw = transform.rotation.y;
         const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
         const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
         const glm::vec3 upDir{0.f, -1.f, 0.f};
         
         // ---------------- Movement ----------------
-        glm::vec3 moveDir{0.f};
-        if(glfwGetKey(window, keys.moveForward) == GLFW_PRESS) moveDir += forwardDir;
-        if(glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) moveDir -= forwardDir;
-        if(glfwGetKey(window, keys.moveRight) == GLFW_PRESS) moveDir += rightDir;
-        if(glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) moveDir -= rightDir;
-        if(glfwGetKey(window, keys.moveUp) == GLFW_PRESS) moveDir += upDir;
-        if(glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
+        const glm::vec3 moveDir = input.move.x * rightDir + input.move.y * upDir + input.move.z * forwardDir;
 
         // Check if not normilizing zero vector
         if(glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
         {
-            gameObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+            transform.translation += moveSpeed * dt * glm::normalize(moveDir);
         }
     }
-}
\ No newline at end of file
+
+    void KeyboardMovementController::moveInPlaneXZ(GLFWwindow *window, float dt, GameObject &gameObject)
+    {
+        apply(sampleInput(window), dt, gameObject.transform);
+    }
+}
@@ -23,10 +23,20 @@ namespace Cosmos
             int lookDown = GLFW_KEY_DOWN;
         };
 
+        // Pressed directions, -1, 0 or 1 per axis
+        struct Input {
+            glm::vec3 rotate{0.f}; // x pitch, y yaw
+            glm::vec3 move{0.f};   // x right, y up, z forward, relative to the yaw
+        };
+
+        // GLFW input may only be polled on the main thread, apply can run anywhere
+        Input sampleInput(GLFWwindow* window) const;
+        void apply(const Input& input, float dt, TransformComponent& transform) const;
+
         void moveInPlaneXZ(GLFWwindow* window, float dt, GameObject& gameObject);
         
         KeyMappings keys{};
         float moveSpeed{2.f};
         float lookSpeed{1.f};
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,167 @@
+#include "lz4.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace Cosmos {
+
+    namespace Lz4 {
+
+        namespace {
+            constexpr size_t MIN_MATCH = 4;
+            constexpr size_t LAST_LITERALS = 5; // the last 5 bytes are always literals
+            constexpr size_t MATCH_FIND_LIMIT = 12; // no match may start in the last 12 bytes
+            constexpr size_t MAX_OFFSET = 65535;
+            constexpr unsigned HASH_BITS = 16;
+
+            uint32_t read32(const uint8_t* p)
+            {
+                uint32_t value;
+                std::memcpy(&value, p, 4);
+                return value;
+            }
+
+            uint32_t hash4(uint32_t sequence)
+            {
+                return (sequence * 2654435761u) >> (32 - HASH_BITS);
+            }
+
+            // 15 in the token nibble, then 255s and the remainder
+            uint8_t* writeLength(uint8_t* op, size_t length)
+            {
+                for(; length >= 255; length -= 255) *op++ = 255;
+                *op++ = static_cast<uint8_t>(length);
+                return op;
+            }
+        }
+
+        size_t compressBound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        size_t compress(const char* src, size_t srcSize, char* dst, size_t dstCapacity)
+        {
+            const uint8_t* const input = reinterpret_cast<const uint8_t*>(src);
+            const uint8_t* const inputEnd = input + srcSize;
+            uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+            uint8_t* const outputEnd = op + dstCapacity;
+
+            // literal run plus its token and worst case length bytes, or false if it does not fit
+            auto emitSequence = [&](const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+                size_t required = 1 + literalLength + literalLength / 255 + 1 + (offset ? 2 + matchLength / 255 + 1 : 0);
+                if(static_cast<size_t>(outputEnd - op) < required) return false;
+
+                uint8_t* token = op++;
+                *token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+                if(literalLength >= 15) op = writeLength(op, literalLength - 15);
+                std::memcpy(op, literals, literalLength);
+                op += literalLength;
+                if(offset) {
+                    *op++ = static_cast<uint8_t>(offset);
+                    *op++ = static_cast<uint8_t>(offset >> 8);
+                    size_t length = matchLength - MIN_MATCH;
+                    *token |= static_cast<uint8_t>(length < 15 ? length : 15);
+                    if(length >= 15) op = writeLength(op, length - 15);
+                }
+                return true;
+            };
+
+            const uint8_t* anchor = input;
+            if(srcSize > MATCH_FIND_LIMIT) {
+                // positions relative to input, 0 doubles as "empty" since position 0 is never a useful match for itself
+                std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+                const uint8_t* const matchLimit = inputEnd - LAST_LITERALS;
+                const uint8_t* const searchLimit = inputEnd - MATCH_FIND_LIMIT;
+
+                const uint8_t* ip = input + 1;
+                while(ip < searchLimit) {
+                    const uint32_t sequence = read32(ip);
+                    const uint32_t h = hash4(sequence);
+                    const uint8_t* candidate = input + table[h];
+                    table[h] = static_cast<uint32_t>(ip - input);
+                    if(static_cast<size_t>(ip - candidate) > MAX_OFFSET || read32(candidate) != sequence) {
+                        // step faster through data that does not compress
+                        ip += 1 + ((ip - anchor) >> 6);
+                        continue;
+                    }
+
+                    // extend backwards over literals, then forwards
+                    while(ip > anchor && candidate > input && ip[-1] == candidate[-1]) {
+                        ip--;
+                        candidate--;
+                    }
+                    const uint8_t* matchEnd = ip + MIN_MATCH;
+                    const uint8_t* candidateEnd = candidate + MIN_MATCH;
+                    while(matchEnd < matchLimit && *matchEnd == *candidateEnd) {
+                        matchEnd++;
+                        candidateEnd++;
+                    }
+
+                    if(!emitSequence(anchor, ip - anchor, ip - candidate, matchEnd - ip)) return 0;
+                    anchor = ip = matchEnd;
+                    if(ip < searchLimit) table[hash4(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - input);
+                }
+            }
+
+            if(!emitSequence(anchor, inputEnd - anchor, 0, 0)) return 0;
+            return op - reinterpret_cast<uint8_t*>(dst);
+        }
+
+        void decompress(const char* src, size_t srcSize, char* dst, size_t dstSize)
+        {
+            const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+            const uint8_t* const inputEnd = ip + srcSize;
+            uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+            uint8_t* const output = op;
+            uint8_t* const outputEnd = op + dstSize;
+
+            auto readLength = [&](size_t length) {
+                if(length != 15) return length;
+                uint8_t byte;
+                do {
+                    if(ip >= inputEnd) throw std::runtime_error("truncated LZ4 block");
+                    byte = *ip++;
+                    length += byte;
+                } while(byte == 255);
+                return length;
+            };
+
+            while(true) {
+                if(ip >= inputEnd) throw std::runtime_error("truncated LZ4 block");
+                const uint8_t token = *ip++;
+
+                const size_t literalLength = readLength(token >> 4);
+                if(static_cast<size_t>(inputEnd - ip) < literalLength || static_cast<size_t>(outputEnd - op) < literalLength) {
+                    throw std::runtime_error("LZ4 literal run out of bounds");
+                }
+                std::memcpy(op, ip, literalLength);
+                ip += literalLength;
+                op += literalLength;
+                // the last sequence has no match
+                if(ip == inputEnd) break;
+
+                if(inputEnd - ip < 2) throw std::runtime_error("truncated LZ4 block");
+                const size_t offset = ip[0] | (ip[1] << 8);
+                ip += 2;
+                const size_t matchLength = readLength(token & 15) + MIN_MATCH;
+                if(offset == 0 || offset > static_cast<size_t>(op - output) ||
+                    static_cast<size_t>(outputEnd - op) < matchLength) {
+                    throw std::runtime_error("LZ4 match out of bounds");
+                }
+                // overlapping copies repeat the pattern, so copy forwards byte by byte when they overlap
+                const uint8_t* match = op - offset;
+                if(offset >= matchLength) {
+                    std::memcpy(op, match, matchLength);
+                    op += matchLength;
+                } else {
+                    for(size_t i = 0; i < matchLength; i++) *op++ = match[i];
+                }
+            }
+
+            if(op != outputEnd) throw std::runtime_error("LZ4 block size mismatch");
+        }
+    }
+}
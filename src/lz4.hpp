@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Cosmos {
+
+    // LZ4 block format (no frame header), readable by LZ4_decompress_safe and the reference tools.
+    // Greedy single probe matcher: fast to compress and, like any LZ4 stream, decompresses at memory speed.
+    namespace Lz4 {
+
+        // Worst case compressed size for incompressible input
+        size_t compressBound(size_t size);
+
+        // Returns the compressed size, or 0 if the result does not fit into dstCapacity
+        size_t compress(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+
+        // Decodes exactly dstSize bytes, throws std::runtime_error on malformed input
+        void decompress(const char* src, size_t srcSize, char* dst, size_t dstSize);
+    }
+}
@@ -1,19 +1,74 @@
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <string>
 
 #include "app.hpp"
 
 // TODO: write a macros to create default copy constructors.
 
-int main() {
-    Cosmos::Application app;
-    
+namespace {
+
+    VkPresentModeKHR parsePresentMode(const std::string& name)
+    {
+        if(name == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+        if(name == "fifo_relaxed") return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        if(name == "mailbox") return VK_PRESENT_MODE_MAILBOX_KHR;
+        if(name == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        throw std::runtime_error("unknown present mode " + name);
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: CosmosEngine [--frames-in-flight 1-4] [--present-mode fifo|fifo_relaxed|mailbox|immediate]\n"
+                  << "                    [--swapchain-images N] [--dynamic-rendering] [--fps-limit N]\n"
+                  << "                    [--pacing-report SECONDS] [--depth-prepass]\n"
+                  << "  low latency: --frames-in-flight 1 --present-mode mailbox\n"
+                  << "  throughput:  --frames-in-flight 3 --present-mode fifo --swapchain-images 4\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    Cosmos::Application::Settings settings{};
+    try {
+        for(int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if(arg == "--frames-in-flight" && i + 1 < argc) {
+                const unsigned long frames = std::stoul(argv[++i]);
+                if(frames < Cosmos::EngineSwapChain::MIN_FRAMES_IN_FLIGHT ||
+                   frames > Cosmos::EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
+                    throw std::runtime_error("frames in flight must be between 1 and 4");
+                settings.swapChain.framesInFlight = static_cast<uint32_t>(frames);
+            } else if(arg == "--present-mode" && i + 1 < argc) {
+                settings.swapChain.presentMode = parsePresentMode(argv[++i]);
+            } else if(arg == "--swapchain-images" && i + 1 < argc) {
+                settings.swapChain.imageCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if(arg == "--dynamic-rendering") {
+                settings.swapChain.dynamicRendering = true;
+            } else if(arg == "--depth-prepass") {
+                settings.depthPrepass = true;
+            } else if(arg == "--fps-limit" && i + 1 < argc) {
+                settings.framePacing.frameRateLimit = std::stod(argv[++i]);
+            } else if(arg == "--pacing-report" && i + 1 < argc) {
+                settings.framePacing.reportInterval = std::stod(argv[++i]);
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
     try{
+        // device or swap chain creation can throw as well
+        Cosmos::Application app{settings};
         app.run();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,98 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Cosmos {
+
+#ifdef _WIN32
+
+    MappedFile::MappedFile(const std::string& filePath)
+    {
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if(file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open file: " + filePath);
+        }
+
+        LARGE_INTEGER fileSize{};
+        if(!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("failed to query file size: " + filePath);
+        }
+        mappedSize = static_cast<size_t>(fileSize.QuadPart);
+        if(mappedSize == 0) {
+            // empty files cannot be mapped
+            CloseHandle(file);
+            return;
+        }
+
+        // the mapping keeps its own reference to the file
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if(mappingHandle == nullptr) {
+            throw std::runtime_error("failed to map file: " + filePath);
+        }
+
+        mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if(mappedData == nullptr) {
+            CloseHandle(mappingHandle);
+            throw std::runtime_error("failed to map file: " + filePath);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if(mappedData) UnmapViewOfFile(mappedData);
+        if(mappingHandle) CloseHandle(mappingHandle);
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::string& filePath)
+    {
+        int file = open(filePath.c_str(), O_RDONLY);
+        if(file < 0) {
+            throw std::runtime_error("failed to open file: " + filePath);
+        }
+
+        struct stat fileStat{};
+        if(fstat(file, &fileStat) != 0) {
+            close(file);
+            throw std::runtime_error("failed to query file size: " + filePath);
+        }
+        mappedSize = static_cast<size_t>(fileStat.st_size);
+        if(mappedSize == 0) {
+            // empty files cannot be mapped
+            close(file);
+            return;
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if(mapping == MAP_FAILED) {
+            throw std::runtime_error("failed to map file: " + filePath);
+        }
+        madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+        mappedData = static_cast<const char*>(mapping);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if(mappedData) munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+
+#endif
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Cosmos {
+
+    // Read only view of a whole file through the OS page cache (mmap / MapViewOfFile),
+    // pages are faulted in on access so nothing is copied up front
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return mappedData; }
+        size_t size() const { return mappedSize; }
+
+    private:
+        const char* mappedData = nullptr;
+        size_t mappedSize = 0;
+#ifdef _WIN32
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
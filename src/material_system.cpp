@@ -0,0 +1,186 @@
+#include "material_system.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    MaterialSystem::MaterialSystem(EngineDevice& device, DescriptorSetLayoutCache& layoutCache, uint32_t framesInFlight)
+        : engineDevice{device}
+    {
+        setLayout = DescriptorSetLayout::Builder(engineDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_TEXTURES,
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .build(layoutCache);
+
+        materialBuffers.resize(framesInFlight);
+        for(auto& buffer : materialBuffers) {
+            buffer = std::make_unique<Buffer>(
+                engineDevice,
+                sizeof(Material),
+                MAX_MATERIALS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            buffer->map();
+        }
+        pendingMaterialWrites.resize(framesInFlight);
+
+        createSampler();
+        createDescriptorSets(framesInFlight);
+
+        // defaults, so untextured models keep their vertex colors
+        Texture::Builder white{};
+        white.width = 1;
+        white.height = 1;
+        white.pixels = {255, 255, 255, 255};
+        white.generateMipmaps = false;
+        addTexture(std::make_shared<Texture>(engineDevice, white));
+        addMaterial(Material{});
+    }
+
+    MaterialSystem::~MaterialSystem()
+    {
+        vkDestroySampler(engineDevice.device(), sampler, nullptr);
+    }
+
+    uint32_t MaterialSystem::addTexture(std::shared_ptr<Texture> texture)
+    {
+        if(textures.size() >= MAX_TEXTURES) {
+            throw std::runtime_error("bindless texture array is full!");
+        }
+        uint32_t index = static_cast<uint32_t>(textures.size());
+        VkImageView imageView = texture->getImageView();
+        textures.push_back(std::move(texture));
+        textureViews.push_back(imageView);
+        // update-unused-while-pending: safe while the sets are in use by frames in flight, they never index this slot
+        for(auto set : descriptorSets) {
+            writeTextureDescriptor(set, index, imageView);
+        }
+        return index;
+    }
+
+    uint32_t MaterialSystem::reserveTextureSlot()
+    {
+        if(textures.size() >= MAX_TEXTURES) {
+            throw std::runtime_error("bindless texture array is full!");
+        }
+        uint32_t index = static_cast<uint32_t>(textures.size());
+        textures.push_back(nullptr);
+        textureViews.push_back(textureViews[0]);
+        for(auto set : descriptorSets) {
+            writeTextureDescriptor(set, index, textureViews[0]);
+        }
+        return index;
+    }
+
+    void MaterialSystem::setTextureView(uint32_t index, VkImageView imageView)
+    {
+        assert(index < textureViews.size() && "Texture index out of range");
+        textureViews[index] = imageView;
+        for(auto& pending : pendingTextureWrites) {
+            pending.emplace_back(index, imageView);
+        }
+    }
+
+    void MaterialSystem::beginFrame(int frameIndex)
+    {
+        auto& pending = pendingTextureWrites[frameIndex];
+        for(auto& [index, imageView] : pending) {
+            writeTextureDescriptor(descriptorSets[frameIndex], index, imageView);
+        }
+        pending.clear();
+
+        // host coherent, visible to this frame's submit
+        auto& pendingMaterials = pendingMaterialWrites[frameIndex];
+        for(uint32_t index : pendingMaterials) {
+            materialBuffers[frameIndex]->writeToIndex(&materials[index], index);
+        }
+        pendingMaterials.clear();
+    }
+
+    uint32_t MaterialSystem::addMaterial(const Material& material)
+    {
+        if(materials.size() >= MAX_MATERIALS) {
+            throw std::runtime_error("material buffer is full!");
+        }
+        assert(material.albedoTexture < textures.size() && "Material references a missing texture");
+        uint32_t index = static_cast<uint32_t>(materials.size());
+        materials.push_back(material);
+        // no frame in flight indexes a new material, every slot can be written right away
+        for(auto& buffer : materialBuffers) {
+            buffer->writeToIndex(&materials[index], index);
+        }
+        return index;
+    }
+
+    void MaterialSystem::updateMaterial(uint32_t index, const Material& material)
+    {
+        assert(index < materials.size() && "Material index out of range");
+        assert(material.albedoTexture < textures.size() && "Material references a missing texture");
+        materials[index] = material;
+        for(auto& pending : pendingMaterialWrites) {
+            pending.push_back(index);
+        }
+    }
+
+    void MaterialSystem::createSampler()
+    {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.anisotropyEnable = VK_TRUE;
+        samplerInfo.maxAnisotropy = engineDevice.properties.limits.maxSamplerAnisotropy;
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+        samplerInfo.mipLodBias = 0.0f;
+
+        if(vkCreateSampler(engineDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+    }
+
+    void MaterialSystem::createDescriptorSets(uint32_t setCount)
+    {
+        descriptorPool = DescriptorPool::Builder(engineDevice)
+            .setMaxSets(setCount)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES * setCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setCount)
+            .build();
+
+        descriptorSets.resize(setCount);
+        pendingTextureWrites.resize(setCount);
+        for(uint32_t i = 0; i < setCount; i++) {
+            auto bufferInfo = materialBuffers[i]->descriptorInfo();
+            if(!DescriptorWriter(*setLayout, *descriptorPool)
+                .writeBuffer(1, &bufferInfo)
+                .build(descriptorSets[i]))
+            {
+                throw std::runtime_error("failed to allocate bindless material descriptor set!");
+            }
+        }
+    }
+
+    void MaterialSystem::writeTextureDescriptor(VkDescriptorSet set, uint32_t index, VkImageView imageView)
+    {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = sampler;
+        imageInfo.imageView = imageView;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        DescriptorWriter(*setLayout, *descriptorPool)
+            .writeImage(0, &imageInfo, index)
+            .overwrite(set);
+    }
+}
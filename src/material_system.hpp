@@ -0,0 +1,91 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "buffer.hpp"
+#include "descriptors.hpp"
+#include "texture.hpp"
+#include "engine_swap_chain.hpp"
+
+namespace Cosmos {
+
+    // std430 layout, keep in sync with Material in simple_shader.frag
+    struct Material {
+        glm::vec4 baseColorFactor{1.f};
+        uint32_t albedoTexture = 0; // index into the bindless texture array
+        float specularStrength = 1.f;
+        float shininess = 32.f;
+        float padding = 0.f;
+    };
+
+    /*
+    Bindless materials: every texture lives in one large descriptor-indexed array of
+    combined image samplers and every material in one storage buffer, both in a single
+    descriptor set bound once per pass. Draws select their material by index, so switching
+    materials never rebinds descriptors.
+    Texture 0 is a 1x1 white texture and material 0 a plain white material.
+
+    There is one set and one material buffer per frame in flight so a slot can be repointed
+    at a new image view (streamed mips) or a material changed without touching what a pending
+    frame still reads: the write is queued and applied to each frame slot in beginFrame, once
+    its previous frame has finished.
+    */
+    class MaterialSystem {
+    public:
+        static constexpr uint32_t MAX_TEXTURES = 1024;
+        static constexpr uint32_t MAX_MATERIALS = 4096;
+
+        // one descriptor set per frame in flight
+        MaterialSystem(EngineDevice& device, DescriptorSetLayoutCache& layoutCache, uint32_t framesInFlight);
+        ~MaterialSystem();
+
+        MaterialSystem(const MaterialSystem&) = delete;
+        MaterialSystem& operator=(const MaterialSystem&) = delete;
+
+        uint32_t addTexture(std::shared_ptr<Texture> texture);
+        // Slot whose image is owned elsewhere (TextureStreamer), shows the white texture until set
+        uint32_t reserveTextureSlot();
+        void setTextureView(uint32_t index, VkImageView imageView);
+        uint32_t addMaterial(const Material& material);
+        // Reaches each frame slot in its next beginFrame
+        void updateMaterial(uint32_t index, const Material& material);
+
+        const Material& getMaterial(uint32_t index) const { return materials[index]; }
+        uint32_t getMaterialCount() const { return static_cast<uint32_t>(materials.size()); }
+        uint32_t getTextureCount() const { return static_cast<uint32_t>(textures.size()); }
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+        VkDescriptorSet getDescriptorSet(int frameIndex) const { return descriptorSets[frameIndex]; }
+
+        // Applies texture and material writes queued for this frame slot, call after its last submit completed
+        void beginFrame(int frameIndex);
+
+    private:
+        void createSampler();
+        void createDescriptorSets(uint32_t setCount);
+        void writeTextureDescriptor(VkDescriptorSet set, uint32_t index, VkImageView imageView);
+
+        EngineDevice& engineDevice;
+
+        std::shared_ptr<DescriptorSetLayout> setLayout;
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::vector<VkDescriptorSet> descriptorSets;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        std::vector<std::shared_ptr<Texture>> textures;
+        std::vector<VkImageView> textureViews;
+        // per frame slot: bindless index -> view still to be written into that slot's set
+        std::vector<std::vector<std::pair<uint32_t, VkImageView>>> pendingTextureWrites;
+        std::vector<Material> materials;
+        // per frame slot, host visible and persistently mapped
+        std::vector<std::unique_ptr<Buffer>> materialBuffers;
+        // per frame slot: material indices still to be copied into that slot's buffer
+        std::vector<std::vector<uint32_t>> pendingMaterialWrites;
+    };
+}
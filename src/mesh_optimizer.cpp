@@ -0,0 +1,598 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace Cosmos {
+
+    namespace MeshOptimizer {
+
+        namespace {
+
+            // Vertex -> triangles it belongs to, CSR layout
+            struct TriangleAdjacency {
+                std::vector<uint32_t> offsets;
+                std::vector<uint32_t> triangles;
+
+                TriangleAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+                    : offsets(vertexCount + 1, 0), triangles(indices.size())
+                {
+                    for(uint32_t index : indices) offsets[index + 1]++;
+                    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                    for(size_t i = 0; i < indices.size(); i++) {
+                        triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                    }
+                }
+            };
+
+            class FifoCache {
+            public:
+                FifoCache(size_t vertexCount, uint32_t cacheSize)
+                    : cacheSize{cacheSize}, timestamps(vertexCount, 0), time{cacheSize + 1} {}
+
+                // returns true on a miss
+                bool access(uint32_t vertex)
+                {
+                    if(time - timestamps[vertex] > cacheSize) {
+                        timestamps[vertex] = time++;
+                        return true;
+                    }
+                    return false;
+                }
+
+                void reset()
+                {
+                    time += cacheSize + 1;
+                }
+
+            private:
+                uint32_t cacheSize;
+                std::vector<uint32_t> timestamps;
+                uint32_t time;
+            };
+
+            struct Float3 {
+                float x = 0.f, y = 0.f, z = 0.f;
+            };
+
+            Float3 readPosition(const float* positions, size_t stride, uint32_t index)
+            {
+                const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + stride * index);
+                return {p[0], p[1], p[2]};
+            }
+
+            Float3 triangleNormal(const Float3& a, const Float3& b, const Float3& c)
+            {
+                const Float3 e1{b.x - a.x, b.y - a.y, b.z - a.z};
+                const Float3 e2{c.x - a.x, c.y - a.y, c.z - a.z};
+                return {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+            }
+
+            // Symmetric 4x4 plane quadric, weight is the accumulated triangle area
+            struct Quadric {
+                double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+                double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+                double weight = 0;
+
+                static Quadric fromPlane(double a, double b, double c, double d, double weight)
+                {
+                    Quadric q;
+                    q.a2 = a * a * weight; q.b2 = b * b * weight; q.c2 = c * c * weight; q.d2 = d * d * weight;
+                    q.ab = a * b * weight; q.ac = a * c * weight; q.ad = a * d * weight;
+                    q.bc = b * c * weight; q.bd = b * d * weight; q.cd = c * d * weight;
+                    q.weight = weight;
+                    return q;
+                }
+
+                void add(const Quadric& q)
+                {
+                    a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+                    ab += q.ab; ac += q.ac; ad += q.ad; bc += q.bc; bd += q.bd; cd += q.cd;
+                    weight += q.weight;
+                }
+
+                // area weighted mean squared distance to the planes, as a distance
+                float error(const Float3& p) const
+                {
+                    if(weight <= 0) return 0.f;
+                    const double x = p.x, y = p.y, z = p.z;
+                    const double r = a2 * x * x + b2 * y * y + c2 * z * z
+                        + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                        + 2 * (ad * x + bd * y + cd * z) + d2;
+                    return static_cast<float>(std::sqrt(std::max(r, 0.0) / weight));
+                }
+            };
+        }
+
+        VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+        {
+            VertexCacheStats stats{};
+            if(indices.empty()) return stats;
+
+            FifoCache cache{vertexCount, cacheSize};
+            std::vector<bool> referenced(vertexCount, false);
+            uint32_t misses = 0;
+            uint32_t uniqueVertices = 0;
+            for(uint32_t index : indices) {
+                if(cache.access(index)) misses++;
+                if(!referenced[index]) {
+                    referenced[index] = true;
+                    uniqueVertices++;
+                }
+            }
+            stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+            stats.atvr = static_cast<float>(misses) / uniqueVertices;
+            return stats;
+        }
+
+        std::vector<uint32_t> optimizeVertexCache(
+            const std::vector<uint32_t>& indices,
+            size_t vertexCount,
+            uint32_t cacheSize,
+            std::vector<uint32_t>* clusters)
+        {
+            assert(indices.size() % 3 == 0 && "Expected a triangle list");
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            if(clusters) clusters->clear();
+            if(indices.empty()) return result;
+
+            const TriangleAdjacency adjacency{indices, vertexCount};
+            std::vector<uint32_t> liveTriangles(vertexCount);
+            for(size_t v = 0; v < vertexCount; v++) {
+                liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+            }
+
+            std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+            uint32_t time = cacheSize + 1;
+            std::vector<bool> emitted(indices.size() / 3, false);
+            std::vector<uint32_t> deadEndStack;
+            std::vector<uint32_t> candidates;
+            uint32_t cursor = 0;
+
+            int64_t fanningVertex = indices[0];
+            bool hardBoundary = true;
+            while(fanningVertex >= 0)
+            {
+                if(hardBoundary && clusters) clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+                hardBoundary = false;
+
+                candidates.clear();
+                for(uint32_t i = adjacency.offsets[fanningVertex]; i < adjacency.offsets[fanningVertex + 1]; i++)
+                {
+                    const uint32_t triangle = adjacency.triangles[i];
+                    if(emitted[triangle]) continue;
+                    emitted[triangle] = true;
+
+                    for(uint32_t k = 0; k < 3; k++) {
+                        const uint32_t v = indices[triangle * 3 + k];
+                        result.push_back(v);
+                        deadEndStack.push_back(v);
+                        candidates.push_back(v);
+                        liveTriangles[v]--;
+                        if(time - cacheTimestamps[v] > cacheSize) {
+                            cacheTimestamps[v] = time++;
+                        }
+                    }
+                }
+
+                // next fanning vertex: the candidate that stays in the cache longest while fanning it
+                fanningVertex = -1;
+                int bestPriority = -1;
+                for(uint32_t v : candidates) {
+                    if(liveTriangles[v] == 0) continue;
+                    int priority = 0;
+                    if(time - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize) {
+                        priority = static_cast<int>(time - cacheTimestamps[v]);
+                    }
+                    if(priority > bestPriority) {
+                        bestPriority = priority;
+                        fanningVertex = v;
+                    }
+                }
+
+                if(fanningVertex < 0)
+                {
+                    // dead end, everything that follows starts from a cold cache
+                    hardBoundary = true;
+                    while(!deadEndStack.empty()) {
+                        uint32_t v = deadEndStack.back();
+                        deadEndStack.pop_back();
+                        if(liveTriangles[v] > 0) {
+                            fanningVertex = v;
+                            break;
+                        }
+                    }
+                    while(fanningVertex < 0 && cursor < vertexCount) {
+                        if(liveTriangles[cursor] > 0) fanningVertex = cursor;
+                        cursor++;
+                    }
+                }
+            }
+            return result;
+        }
+
+        std::vector<uint32_t> optimizeOverdraw(
+            const std::vector<uint32_t>& indices,
+            const std::vector<uint32_t>& clusters,
+            const float* positions,
+            size_t positionStride,
+            size_t vertexCount,
+            uint32_t cacheSize,
+            float threshold)
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+            if(triangleCount == 0 || clusters.empty()) return indices;
+
+            // soft boundaries: cut a hard cluster wherever the part so far is already close to the cluster's ACMR
+            std::vector<uint32_t> boundaries;
+            FifoCache cache{vertexCount, cacheSize};
+            for(size_t c = 0; c < clusters.size(); c++)
+            {
+                const uint32_t begin = clusters[c];
+                const uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+                cache.reset();
+                uint32_t clusterMisses = 0;
+                for(uint32_t t = begin; t < end; t++) {
+                    for(uint32_t k = 0; k < 3; k++) clusterMisses += cache.access(indices[t * 3 + k]);
+                }
+                const float clusterAcmr = static_cast<float>(clusterMisses) / (end - begin);
+
+                cache.reset();
+                uint32_t start = begin;
+                uint32_t misses = 0;
+                boundaries.push_back(begin);
+                for(uint32_t t = begin; t < end; t++) {
+                    for(uint32_t k = 0; k < 3; k++) misses += cache.access(indices[t * 3 + k]);
+                    const float acmr = static_cast<float>(misses) / (t - start + 1);
+                    if(t + 1 < end && acmr <= clusterAcmr * threshold) {
+                        boundaries.push_back(t + 1);
+                        start = t + 1;
+                        misses = 0;
+                        cache.reset();
+                    }
+                }
+            }
+
+            // area weighted centroid and normal per cluster
+            struct Cluster {
+                uint32_t begin, end;
+                float sortKey;
+            };
+            std::vector<Cluster> sorted(boundaries.size());
+            Float3 meshCentroid{};
+            float meshArea = 0.f;
+            std::vector<Float3> centroids(boundaries.size());
+            std::vector<Float3> normals(boundaries.size());
+            for(size_t c = 0; c < boundaries.size(); c++)
+            {
+                sorted[c].begin = boundaries[c];
+                sorted[c].end = c + 1 < boundaries.size() ? boundaries[c + 1] : triangleCount;
+
+                Float3 centroid{};
+                Float3 normal{};
+                float area = 0.f;
+                for(uint32_t t = sorted[c].begin; t < sorted[c].end; t++)
+                {
+                    const Float3 a = readPosition(positions, positionStride, indices[t * 3 + 0]);
+                    const Float3 b = readPosition(positions, positionStride, indices[t * 3 + 1]);
+                    const Float3 d = readPosition(positions, positionStride, indices[t * 3 + 2]);
+                    const Float3 e1{b.x - a.x, b.y - a.y, b.z - a.z};
+                    const Float3 e2{d.x - a.x, d.y - a.y, d.z - a.z};
+                    const Float3 n{e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+                    const float triangleArea = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z) * .5f;
+
+                    centroid.x += (a.x + b.x + d.x) / 3.f * triangleArea;
+                    centroid.y += (a.y + b.y + d.y) / 3.f * triangleArea;
+                    centroid.z += (a.z + b.z + d.z) / 3.f * triangleArea;
+                    normal.x += n.x;
+                    normal.y += n.y;
+                    normal.z += n.z;
+                    area += triangleArea;
+                }
+
+                meshCentroid.x += centroid.x;
+                meshCentroid.y += centroid.y;
+                meshCentroid.z += centroid.z;
+                meshArea += area;
+
+                const float inverseArea = area > 0.f ? 1.f / area : 0.f;
+                centroids[c] = {centroid.x * inverseArea, centroid.y * inverseArea, centroid.z * inverseArea};
+                const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+                const float inverseLength = length > 0.f ? 1.f / length : 0.f;
+                normals[c] = {normal.x * inverseLength, normal.y * inverseLength, normal.z * inverseLength};
+            }
+            if(meshArea > 0.f) {
+                meshCentroid = {meshCentroid.x / meshArea, meshCentroid.y / meshArea, meshCentroid.z / meshArea};
+            }
+
+            // clusters facing away from the center occlude the ones behind them from most directions
+            for(size_t c = 0; c < sorted.size(); c++) {
+                sorted[c].sortKey =
+                    (centroids[c].x - meshCentroid.x) * normals[c].x +
+                    (centroids[c].y - meshCentroid.y) * normals[c].y +
+                    (centroids[c].z - meshCentroid.z) * normals[c].z;
+            }
+            std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+                return a.sortKey > b.sortKey;
+            });
+
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for(const auto& cluster : sorted) {
+                result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+            }
+            return result;
+        }
+
+        std::vector<uint32_t> simplify(
+            const std::vector<uint32_t>& indices,
+            const float* positions,
+            size_t positionStride,
+            size_t vertexCount,
+            size_t targetIndexCount,
+            float maxError,
+            float* resultError)
+        {
+            assert(indices.size() % 3 == 0 && "Expected a triangle list");
+            std::vector<uint32_t> result = indices;
+            float introducedError = 0.f;
+
+            std::vector<Float3> vertexPositions(vertexCount);
+            for(uint32_t v = 0; v < vertexCount; v++) {
+                vertexPositions[v] = readPosition(positions, positionStride, v);
+            }
+
+            std::vector<Quadric> quadrics(vertexCount);
+            for(size_t t = 0; t < result.size(); t += 3) {
+                const Float3& a = vertexPositions[result[t + 0]];
+                const Float3& b = vertexPositions[result[t + 1]];
+                const Float3& c = vertexPositions[result[t + 2]];
+                const Float3 n = triangleNormal(a, b, c);
+                const double length = std::sqrt(double(n.x) * n.x + double(n.y) * n.y + double(n.z) * n.z);
+                if(length <= 0) continue;
+                const double nx = n.x / length, ny = n.y / length, nz = n.z / length;
+                const double d = -(nx * a.x + ny * a.y + nz * a.z);
+                const Quadric q = Quadric::fromPlane(nx, ny, nz, d, length * .5);
+                for(size_t k = 0; k < 3; k++) quadrics[result[t + k]].add(q);
+            }
+
+            // an edge used by one triangle (or more than two) is a border, its vertices stay in place
+            std::vector<bool> locked(vertexCount, false);
+            {
+                std::unordered_map<uint64_t, uint32_t> edgeUses;
+                edgeUses.reserve(result.size());
+                for(size_t t = 0; t < result.size(); t += 3) {
+                    for(size_t k = 0; k < 3; k++) {
+                        const uint64_t a = result[t + k];
+                        const uint64_t b = result[t + (k + 1) % 3];
+                        edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+                    }
+                }
+                for(const auto& [edge, uses] : edgeUses) {
+                    if(uses != 2) {
+                        locked[edge >> 32] = true;
+                        locked[edge & 0xffffffffu] = true;
+                    }
+                }
+            }
+
+            struct Collapse {
+                uint32_t from;
+                uint32_t to;
+                float error;
+            };
+            std::vector<Collapse> collapses;
+            std::vector<uint32_t> remap(vertexCount);
+            std::vector<bool> touched(vertexCount);
+
+            while(result.size() > targetIndexCount)
+            {
+                const TriangleAdjacency adjacency{result, vertexCount};
+
+                collapses.clear();
+                for(size_t t = 0; t < result.size(); t += 3) {
+                    for(size_t k = 0; k < 3; k++) {
+                        const uint32_t a = result[t + k];
+                        const uint32_t b = result[t + (k + 1) % 3];
+                        for(auto [from, to] : {std::pair<uint32_t, uint32_t>{a, b}, std::pair<uint32_t, uint32_t>{b, a}}) {
+                            if(locked[from]) continue;
+                            Quadric q = quadrics[from];
+                            q.add(quadrics[to]);
+                            collapses.push_back({from, to, q.error(vertexPositions[to])});
+                        }
+                    }
+                }
+                std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+                    return a.error < b.error;
+                });
+
+                // every collapse removes about two triangles
+                const size_t collapseBudget = (result.size() - targetIndexCount) / 6 + 1;
+                std::iota(remap.begin(), remap.end(), 0u);
+                std::fill(touched.begin(), touched.end(), false);
+                size_t collapseCount = 0;
+                for(const auto& collapse : collapses)
+                {
+                    if(collapse.error > maxError || collapseCount >= collapseBudget) break;
+                    if(touched[collapse.from] || touched[collapse.to]) continue;
+
+                    // reject collapses that flip a remaining triangle around `from`
+                    bool flips = false;
+                    for(uint32_t i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1] && !flips; i++) {
+                        const uint32_t t = adjacency.triangles[i] * 3;
+                        if(result[t] == collapse.to || result[t + 1] == collapse.to || result[t + 2] == collapse.to) continue;
+
+                        Float3 before[3], after[3];
+                        for(size_t k = 0; k < 3; k++) {
+                            before[k] = vertexPositions[result[t + k]];
+                            after[k] = result[t + k] == collapse.from ? vertexPositions[collapse.to] : before[k];
+                        }
+                        const Float3 n0 = triangleNormal(before[0], before[1], before[2]);
+                        const Float3 n1 = triangleNormal(after[0], after[1], after[2]);
+                        flips = n0.x * n1.x + n0.y * n1.y + n0.z * n1.z <= 0.f;
+                    }
+                    if(flips) continue;
+
+                    // the neighbourhood of `from` changes, keep other collapses of this pass out of it
+                    for(uint32_t i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1]; i++) {
+                        const uint32_t t = adjacency.triangles[i] * 3;
+                        for(size_t k = 0; k < 3; k++) touched[result[t + k]] = true;
+                    }
+                    remap[collapse.from] = collapse.to;
+                    quadrics[collapse.to].add(quadrics[collapse.from]);
+                    introducedError = std::max(introducedError, collapse.error);
+                    collapseCount++;
+                }
+                if(collapseCount == 0) break;
+
+                size_t write = 0;
+                for(size_t t = 0; t < result.size(); t += 3) {
+                    const uint32_t a = remap[result[t + 0]];
+                    const uint32_t b = remap[result[t + 1]];
+                    const uint32_t c = remap[result[t + 2]];
+                    if(a == b || b == c || a == c) continue;
+                    result[write++] = a;
+                    result[write++] = b;
+                    result[write++] = c;
+                }
+                result.resize(write);
+            }
+
+            if(resultError) *resultError = introducedError;
+            return result;
+        }
+
+        std::vector<Meshlet> buildMeshlets(
+            const std::vector<uint32_t>& indices,
+            size_t vertexCount,
+            std::vector<uint32_t>& meshletVertices,
+            std::vector<uint8_t>& meshletTriangles,
+            size_t maxVertices,
+            size_t maxTriangles)
+        {
+            assert(maxVertices >= 3 && maxVertices <= 256 && "Local meshlet indices are 8 bit");
+            assert(maxTriangles >= 1 && "A meshlet needs room for one triangle");
+
+            std::vector<Meshlet> meshlets;
+            meshletVertices.clear();
+            meshletTriangles.clear();
+
+            // mesh vertex -> local index, only valid while the owner is the current meshlet
+            std::vector<uint8_t> localIndex(vertexCount);
+            std::vector<uint32_t> localOwner(vertexCount, ~0u);
+
+            Meshlet meshlet{};
+            for(size_t t = 0; t + 2 < indices.size(); t += 3)
+            {
+                uint32_t owner = static_cast<uint32_t>(meshlets.size());
+                size_t newVertices = 0;
+                for(size_t k = 0; k < 3; k++) {
+                    newVertices += localOwner[indices[t + k]] != owner;
+                }
+                if(meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles) {
+                    meshlets.push_back(meshlet);
+                    owner++;
+                    meshlet = Meshlet{};
+                    meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+                    meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+                }
+
+                for(size_t k = 0; k < 3; k++) {
+                    const uint32_t vertex = indices[t + k];
+                    if(localOwner[vertex] != owner) {
+                        localOwner[vertex] = owner;
+                        localIndex[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+                        meshletVertices.push_back(vertex);
+                    }
+                    meshletTriangles.push_back(localIndex[vertex]);
+                }
+                meshlet.triangleCount++;
+            }
+            if(meshlet.triangleCount > 0) meshlets.push_back(meshlet);
+
+            return meshlets;
+        }
+
+        MeshletBounds computeMeshletBounds(
+            const Meshlet& meshlet,
+            const std::vector<uint32_t>& meshletVertices,
+            const std::vector<uint8_t>& meshletTriangles,
+            const float* positions,
+            size_t positionStride)
+        {
+            MeshletBounds bounds{};
+            if(meshlet.vertexCount == 0) return bounds;
+
+            // the centroid sphere is only slightly larger than the minimal one for clusters this small
+            Float3 center{};
+            for(uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                const Float3 p = readPosition(positions, positionStride, meshletVertices[meshlet.vertexOffset + i]);
+                center.x += p.x; center.y += p.y; center.z += p.z;
+            }
+            center.x /= meshlet.vertexCount; center.y /= meshlet.vertexCount; center.z /= meshlet.vertexCount;
+
+            float radius = 0.f;
+            for(uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                const Float3 p = readPosition(positions, positionStride, meshletVertices[meshlet.vertexOffset + i]);
+                const float dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+                radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+            }
+            bounds.center[0] = center.x;
+            bounds.center[1] = center.y;
+            bounds.center[2] = center.z;
+            bounds.radius = radius;
+
+            // cone axis is the mean unit normal, its half angle comes from the normal furthest away from it
+            std::vector<Float3> normals;
+            normals.reserve(meshlet.triangleCount);
+            Float3 axis{};
+            for(uint32_t t = 0; t < meshlet.triangleCount; t++) {
+                const uint8_t* triangle = &meshletTriangles[meshlet.triangleOffset + t * 3];
+                Float3 n = triangleNormal(
+                    readPosition(positions, positionStride, meshletVertices[meshlet.vertexOffset + triangle[0]]),
+                    readPosition(positions, positionStride, meshletVertices[meshlet.vertexOffset + triangle[1]]),
+                    readPosition(positions, positionStride, meshletVertices[meshlet.vertexOffset + triangle[2]]));
+                const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+                if(length == 0.f) continue;
+                n.x /= length; n.y /= length; n.z /= length;
+                normals.push_back(n);
+                axis.x += n.x; axis.y += n.y; axis.z += n.z;
+            }
+
+            bounds.coneCutoff = 2.f;
+            const float axisLength = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+            if(axisLength < 1e-6f) return bounds;
+            axis.x /= axisLength; axis.y /= axisLength; axis.z /= axisLength;
+            bounds.coneAxis[0] = axis.x;
+            bounds.coneAxis[1] = axis.y;
+            bounds.coneAxis[2] = axis.z;
+
+            float minDot = 1.f;
+            for(const auto& n : normals) {
+                minDot = std::min(minDot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+            }
+            // beyond a hemisphere some triangle faces every camera position
+            if(minDot > 0.f) {
+                bounds.coneCutoff = std::sqrt(1.f - minDot * minDot);
+            }
+            return bounds;
+        }
+
+        std::vector<uint32_t> optimizeVertexFetchRemap(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t& newVertexCount)
+        {
+            std::vector<uint32_t> remap(vertexCount, ~0u);
+            newVertexCount = 0;
+            for(auto& index : indices) {
+                if(remap[index] == ~0u) remap[index] = newVertexCount++;
+                index = remap[index];
+            }
+            return remap;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cosmos {
+
+    // Import time index/vertex reordering for triangle lists (CPU only)
+    namespace MeshOptimizer {
+
+        struct VertexCacheStats {
+            float acmr = 0.f; // average cache misses per triangle, 0.5 is ideal for large meshes, 3 is worst
+            float atvr = 0.f; // average transforms per vertex, 1 is ideal
+        };
+
+        // Simulates a FIFO post-transform cache
+        VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+        // Tipsify (Sander et al. 2007). Optionally returns the first triangle of every cluster
+        // the algorithm produced, they are the hard boundaries optimizeOverdraw may reorder.
+        std::vector<uint32_t> optimizeVertexCache(
+            const std::vector<uint32_t>& indices,
+            size_t vertexCount,
+            uint32_t cacheSize = 16,
+            std::vector<uint32_t>* clusters = nullptr);
+
+        // Splits the clusters further where that costs little cache efficiency (threshold, 1.05 = 5% worse ACMR)
+        // and sorts them so outward facing ones come first, which lowers overdraw from any view direction.
+        // positions: xyz floats, positionStride bytes apart.
+        std::vector<uint32_t> optimizeOverdraw(
+            const std::vector<uint32_t>& indices,
+            const std::vector<uint32_t>& clusters,
+            const float* positions,
+            size_t positionStride,
+            size_t vertexCount,
+            uint32_t cacheSize = 16,
+            float threshold = 1.05f);
+
+        // Quadric error metric edge collapse (Garland & Heckbert 1997). Vertices are only collapsed onto
+        // a neighbour, so the result indexes the same vertex buffer and LODs can share it. Border vertices
+        // (including attribute seams, which are borders in index space) are locked so no cracks open.
+        // Stops at targetIndexCount or before a collapse would move the surface by more than maxError
+        // (model space distance); resultError receives the largest error that was introduced.
+        std::vector<uint32_t> simplify(
+            const std::vector<uint32_t>& indices,
+            const float* positions,
+            size_t positionStride,
+            size_t vertexCount,
+            size_t targetIndexCount,
+            float maxError,
+            float* resultError = nullptr);
+
+        // Cluster of at most maxVertices unique vertices and maxTriangles triangles, see buildMeshlets
+        struct Meshlet {
+            uint32_t vertexOffset = 0;   // first entry in meshletVertices
+            uint32_t triangleOffset = 0; // first entry in meshletTriangles, 3 local indices per triangle
+            uint32_t vertexCount = 0;
+            uint32_t triangleCount = 0;
+        };
+
+        // Culling data of a meshlet. Every triangle of the cluster faces away from a camera at p when
+        // dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius
+        struct MeshletBounds {
+            float center[3];
+            float radius;
+            float coneAxis[3];
+            float coneCutoff; // > 1 when the normals spread too far to ever cull the cluster
+        };
+
+        // Groups the triangles greedily in index order, run optimizeVertexCache first so clusters stay compact.
+        // meshletVertices maps local to mesh vertex indices, meshletTriangles holds the 8 bit local indices.
+        std::vector<Meshlet> buildMeshlets(
+            const std::vector<uint32_t>& indices,
+            size_t vertexCount,
+            std::vector<uint32_t>& meshletVertices,
+            std::vector<uint8_t>& meshletTriangles,
+            size_t maxVertices = 64,
+            size_t maxTriangles = 124);
+
+        // Bounding sphere around the vertex centroid and normal cone from the counter clockwise triangle normals
+        MeshletBounds computeMeshletBounds(
+            const Meshlet& meshlet,
+            const std::vector<uint32_t>& meshletVertices,
+            const std::vector<uint8_t>& meshletTriangles,
+            const float* positions,
+            size_t positionStride);
+
+        // Renumbers vertices in order of first use so fetches walk memory linearly. Rewrites indices and
+        // returns old -> new index (~0u for unreferenced vertices) together with the new vertex count.
+        std::vector<uint32_t> optimizeVertexFetchRemap(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t& newVertexCount);
+
+        template<typename T>
+        std::vector<T> remapVertices(const std::vector<T>& vertices, const std::vector<uint32_t>& remap, uint32_t newVertexCount)
+        {
+            assert(remap.size() == vertices.size() && "Remap table does not match vertex count");
+            std::vector<T> result(newVertexCount);
+            for(size_t i = 0; i < vertices.size(); i++) {
+                if(remap[i] != ~0u) result[remap[i]] = vertices[i];
+            }
+            return result;
+        }
+    }
+}
@@ -1,31 +1,50 @@
 #include "model.hpp"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <../external/tinyobjloader/tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
 
-#include <engine_utils.hpp>
+#include "mesh_optimizer.hpp"
+#include "obj_parser.hpp"
+#include "dedup_table.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
 
 //#include <vulkan/vulkan_core.h>
 
-namespace std {
+namespace Cosmos {
+
+    namespace {
 
-    /*
-    With this we can take instance of Vertex struct and hash it to a single value of type size_t,
-    which then used by an unordered map as a key. The reason is Vulkan do not support multiple index buffers
-    */
-    template<>
-    struct hash<Cosmos::Model::Vertex> {
-        size_t operator()(Cosmos::Model::Vertex const &vertex) const {
-            size_t seed = 0;
-            Cosmos::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
+        // Octahedral mapping of a unit vector to [-1, 1]^2
+        glm::vec2 octahedralEncode(glm::vec3 n)
+        {
+            float sum = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+            if(sum == 0.f)
+                return glm::vec2(0.f);
+            glm::vec2 p = glm::vec2(n) / sum;
+            if(n.z < 0.f) {
+                glm::vec2 sign{p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f};
+                p = (1.f - glm::abs(glm::vec2(p.y, p.x))) * sign;
+            }
+            return p;
         }
-    };
-}
 
-namespace Cosmos {
+        int16_t toSnorm16(float value)
+        {
+            return static_cast<int16_t>(glm::round(glm::clamp(value, -1.f, 1.f) * 32767.f));
+        }
+
+        uint16_t toUnorm16(float value)
+        {
+            return static_cast<uint16_t>(glm::round(glm::clamp(value, 0.f, 1.f) * 65535.f));
+        }
+
+        uint8_t toUnorm8(float value)
+        {
+            return static_cast<uint8_t>(glm::round(glm::clamp(value, 0.f, 1.f) * 255.f));
+        }
+    }
 
     std::vector<VkVertexInputBindingDescription> Model::Vertex::getBindingDescriptions()
     {
@@ -49,20 +68,65 @@ namespace Cosmos {
         return attributeDescriptions;
     }
 
-        
-    Cosmos::Model::Model(EngineDevice &device, const Model::Builder& builder) : engineDevice{device}
+    static_assert(sizeof(Model::CompactVertex) == 20, "CompactVertex must match its attribute descriptions");
+    static_assert(sizeof(Model::MeshletData) == 48, "MeshletData must match the std430 layout in meshlet_cull.comp");
+
+    std::vector<VkVertexInputBindingDescription> Model::CompactVertex::getBindingDescriptions()
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(CompactVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::CompactVertex::getAttributeDescriptions()
     {
-        createVertexBuffers(builder.vertices);
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompactVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertex, uv)});
+
+        return attributeDescriptions;
+    }
+
+    Cosmos::Model::Model(EngineDevice &device, const Model::Builder& builder) : engineDevice{device}, vertexFormat{builder.vertexFormat}
+    {
+        computeBounds(builder.vertices);
+        if(vertexFormat == VertexFormat::Compact)
+            createCompactVertexBuffers(builder.vertices);
+        else
+            createVertexBuffers(builder.vertices);
         createIndexBuffer(builder.indices);
+
+        Lod base{};
+        base.submeshes = builder.submeshes;
+        if(base.submeshes.empty()) {
+            base.submeshes.push_back({0, static_cast<uint32_t>(builder.indices.size()), 0});
+        }
+        lods.push_back(std::move(base));
+        lods.insert(lods.end(), builder.lods.begin(), builder.lods.end());
+
+        if(!builder.meshlets.empty()) {
+            meshletCount = static_cast<uint32_t>(builder.meshlets.size());
+            meshletIndexCount = static_cast<uint32_t>(builder.meshletIndices.size());
+            meshletBuffer = createStorageBuffer(builder.meshlets.data(), sizeof(MeshletData), meshletCount);
+            meshletIndexBuffer = createStorageBuffer(builder.meshletIndices.data(), sizeof(uint32_t), meshletIndexCount);
+        }
     }
 
     Model::~Model()
     {
     }
 
-    std::unique_ptr<Model> Model::createModelFromFile(EngineDevice& device, const std::string& filepath)
+    std::unique_ptr<Model> Model::createModelFromFile(EngineDevice& device, const std::string& filepath,
+        VertexFormat vertexFormat)
     {
         Builder builder{};
+        builder.vertexFormat = vertexFormat;
         builder.loadModel(filepath);
         //std::cout << "Vertex count: " <<builder.vertices.size() << "\n"; 
         return std::make_unique<Model>(device, builder);
@@ -71,32 +135,118 @@ namespace Cosmos {
 
     void Model::bind(VkCommandBuffer commandBuffer)
     {
-        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        bindVertexBuffer(commandBuffer);
 
         if(hasIndexBuffer)
         {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
         }
     }
 
-    void Model::draw(VkCommandBuffer commandBuffer)
+    void Model::bindVertexBuffer(VkCommandBuffer commandBuffer)
+    {
+        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    }
+
+    void Model::draw(VkCommandBuffer commandBuffer, uint32_t lod)
     {
         if(hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0,0,0);
+            lod = std::min(lod, getLodCount() - 1);
+            for(const auto& submesh : lods[lod].submeshes) {
+                vkCmdDrawIndexed(commandBuffer, submesh.indexCount, 1, submesh.firstIndex, submesh.vertexOffset, 0);
+            }
         }
         else {
             vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
         }
     }
 
+    glm::mat4 Model::getDequantizeMatrix() const
+    {
+        if(vertexFormat != VertexFormat::Compact)
+            return glm::mat4{1.f};
+
+        return glm::mat4{
+            {boundsExtent.x, 0.f, 0.f, 0.f},
+            {0.f, boundsExtent.y, 0.f, 0.f},
+            {0.f, 0.f, boundsExtent.z, 0.f},
+            {boundsMin.x, boundsMin.y, boundsMin.z, 1.f}};
+    }
+
+    VkDeviceSize Model::getDeviceMemorySize() const
+    {
+        VkDeviceSize size = vertexBuffer->getBufferSize();
+        if(indexBuffer) size += indexBuffer->getBufferSize();
+        if(meshletBuffer) size += meshletBuffer->getBufferSize() + meshletIndexBuffer->getBufferSize();
+        return size;
+    }
+
+    void Model::computeBounds(const std::vector<Vertex> &vertices)
+    {
+        if(vertices.empty())
+            return;
+
+        glm::vec3 boundsMax{vertices[0].position};
+        boundsMin = vertices[0].position;
+        for(const auto& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+        // flat meshes (quad) have a zero extent on one axis
+        boundsExtent = glm::max(boundsMax - boundsMin, glm::vec3(1e-6f));
+
+        const glm::vec3 center = getBoundingCenter();
+        boundingRadius = 0.f;
+        for(const auto& vertex : vertices) {
+            boundingRadius = glm::max(boundingRadius, glm::length(vertex.position - center));
+        }
+    }
+
     void Model::createVertexBuffers(const std::vector<Vertex> &vertices)
     {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
+        uploadVertexBuffer(vertices.data(), sizeof(vertices[0]));
+    }
+
+    void Model::createCompactVertexBuffers(const std::vector<Vertex> &vertices)
+    {
+        vertexCount = static_cast<uint32_t>(vertices.size());
+        assert(vertexCount >= 3 && "Vertex count must be at least 3");
+
+        // positions are quantized relative to the bounds from computeBounds
+        std::vector<CompactVertex> compactVertices(vertexCount);
+        for(uint32_t i = 0; i < vertexCount; i++)
+        {
+            const auto& vertex = vertices[i];
+            auto& compact = compactVertices[i];
+
+            glm::vec3 position = (vertex.position - boundsMin) / boundsExtent;
+            compact.position[0] = toUnorm16(position.x);
+            compact.position[1] = toUnorm16(position.y);
+            compact.position[2] = toUnorm16(position.z);
+            compact.position[3] = 0;
+
+            compact.color[0] = toUnorm8(vertex.color.r);
+            compact.color[1] = toUnorm8(vertex.color.g);
+            compact.color[2] = toUnorm8(vertex.color.b);
+            compact.color[3] = 255;
+
+            glm::vec2 normal = octahedralEncode(vertex.normal);
+            compact.normal[0] = toSnorm16(normal.x);
+            compact.normal[1] = toSnorm16(normal.y);
+
+            compact.uv[0] = glm::packHalf1x16(vertex.uv.x);
+            compact.uv[1] = glm::packHalf1x16(vertex.uv.y);
+        }
+        uploadVertexBuffer(compactVertices.data(), sizeof(CompactVertex));
+    }
+
+    void Model::uploadVertexBuffer(const void* data, uint32_t vertexSize)
+    {
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
         // device local memory is faster, but CPU unable to acces it,
         // staging buffer is temporary location to copy data on the cpu to the gpu
         // and then transfer data to device local memory
@@ -108,7 +258,7 @@ namespace Cosmos {
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
         };
         stagingBuffer.map(); 
-        stagingBuffer.writeToBuffer((void*)vertices.data()); // cast to a void ptr
+        stagingBuffer.writeToBuffer(const_cast<void*>(data)); // cast to a void ptr
 
         vertexBuffer = std::make_unique<Buffer>(
             engineDevice,
@@ -129,8 +279,25 @@ namespace Cosmos {
         if(!hasIndexBuffer)
             return;
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
+        // indices are relative to their submesh, so chunked meshes fit in 16 bits too
+        uint32_t maxIndex = 0;
+        for(uint32_t index : indices) {
+            maxIndex = std::max(maxIndex, index);
+        }
+
+        if(maxIndex < MAX_UINT16_VERTICES) {
+            indexType = VK_INDEX_TYPE_UINT16;
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            uploadIndexBuffer(shortIndices.data(), sizeof(uint16_t));
+        } else {
+            indexType = VK_INDEX_TYPE_UINT32;
+            uploadIndexBuffer(indices.data(), sizeof(uint32_t));
+        }
+    }
+
+    void Model::uploadIndexBuffer(const void* data, uint32_t indexSize)
+    {
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
         
         Buffer stagingBuffer{
             engineDevice,
@@ -141,7 +308,7 @@ namespace Cosmos {
         };
 
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)indices.data());
+        stagingBuffer.writeToBuffer(const_cast<void*>(data));
 
         indexBuffer = std::make_unique<Buffer>(
             engineDevice,
@@ -155,64 +322,272 @@ namespace Cosmos {
         engineDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
     }
 
-    void Model::Builder::loadModel(const std::string& filepath)
+    std::unique_ptr<Buffer> Model::createStorageBuffer(const void* data, uint32_t instanceSize, uint32_t instanceCount)
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+        Buffer stagingBuffer{
+            engineDevice,
+            instanceSize,
+            instanceCount,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
 
-        if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
-        {
-            throw std::runtime_error(warn + err);
-        }
+        stagingBuffer.map();
+        stagingBuffer.writeToBuffer(const_cast<void*>(data));
+
+        auto buffer = std::make_unique<Buffer>(
+            engineDevice,
+            instanceSize,
+            instanceCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+
+        engineDevice.copyBuffer(stagingBuffer.getBuffer(), buffer->getBuffer(),
+            static_cast<VkDeviceSize>(instanceSize) * instanceCount);
+        return buffer;
+    }
+
+    void Model::Builder::loadModel(const std::string& filepath)
+    {
+        ObjParser parser{filepath};
         vertices.clear();
         indices.clear();
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        // OBJ faces index positions, texcoords and normals separately, Vulkan only supports one index buffer:
+        // every distinct index triple becomes one vertex. A unique triple costs at least one "v" line and its
+        // face references, so this is a low estimate of the final size, the table doubles if it is exceeded.
+        DedupTable<ObjParser::Corner> uniqueVertices{parser.getFileSize() / 64};
 
-        for(const auto &shape : shapes)
+        // vertices are built straight from the attribute pools, batch by batch while parsing
+        parser.parse([&](const ObjParser::Corner* corners, size_t count)
         {
-            for(const auto &index : shape.mesh.indices)
+            const auto& attributes = parser.getAttributes();
+            for(size_t i = 0; i < count; i++)
             {
-                Vertex vertex{};
-
-                if(index.vertex_index >= 0) {
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
-                    };
-
-                    vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2]
-                    };
-                    
-                }
-                if(index.normal_index >= 0) {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
+                const auto& corner = corners[i];
+                bool inserted = false;
+                const uint32_t index = uniqueVertices.findOrInsert(corner, static_cast<uint32_t>(vertices.size()), inserted);
+                if(inserted)
+                {
+                    Vertex vertex{};
+                    const float* position = &attributes.positions[3 * corner.position];
+                    const float* color = &attributes.colors[3 * corner.position];
+                    vertex.position = {position[0], position[1], position[2]};
+                    vertex.color = {color[0], color[1], color[2]};
+                    if(corner.normal != ObjParser::NO_INDEX) {
+                        const float* normal = &attributes.normals[3 * corner.normal];
+                        vertex.normal = {normal[0], normal[1], normal[2]};
+                    }
+                    if(corner.texcoord != ObjParser::NO_INDEX) {
+                        const float* uv = &attributes.texcoords[2 * corner.texcoord];
+                        vertex.uv = {uv[0], uv[1]};
+                    }
+                    vertices.push_back(vertex);
                 }
-                if(index.texcoord_index >= 0) {
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1],                  
-                    };
+                indices.push_back(index);
+            }
+        }, importThreads);
+
+        optimize(filepath);
+        if(splitForUint16Indices && vertices.size() > MAX_UINT16_VERTICES)
+            splitIntoSubmeshes();
+        generateLods(lodCount);
+        if(meshletCulling) {
+            buildMeshlets();
+            if(printStats)
+                std::cout << filepath << ": " << meshlets.size() << " meshlets" << std::endl;
+        }
+
+        if(!printStats)
+            return;
+        for(size_t level = 0; level < lods.size(); level++) {
+            uint32_t triangles = 0;
+            for(const auto& submesh : lods[level].submeshes) triangles += submesh.indexCount / 3;
+            std::cout << filepath << ": LOD" << level + 1 << " " << triangles << " triangles, error " << lods[level].error << std::endl;
+        }
+    }
+
+    void Model::Builder::generateLods(uint32_t lodCount, float reduction)
+    {
+        lods.clear();
+        if(indices.empty() || lodCount < 2)
+            return;
+
+        const std::vector<Submesh> base = submeshes.empty()
+            ? std::vector<Submesh>{{0, static_cast<uint32_t>(indices.size()), 0}}
+            : submeshes;
+
+        // keep LODs recognizable, an error beyond a tenth of the mesh size is never worth drawing
+        glm::vec3 boundsMin{vertices[0].position};
+        glm::vec3 boundsMax{vertices[0].position};
+        for(const auto& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+        const float maxError = glm::length(boundsMax - boundsMin) * .1f;
+
+        size_t previousIndexCount = indices.size();
+        float targetRatio = 1.f;
+        for(uint32_t level = 1; level < lodCount; level++)
+        {
+            targetRatio *= reduction;
+            Lod lod{};
+            size_t lodIndexCount = 0;
+            // always simplified from full resolution so errors do not accumulate
+            for(const auto& submesh : base)
+            {
+                std::vector<uint32_t> source(indices.begin() + submesh.firstIndex,
+                    indices.begin() + submesh.firstIndex + submesh.indexCount);
+                const uint32_t submeshVertexCount = *std::max_element(source.begin(), source.end()) + 1;
+                const Vertex* submeshVertices = &vertices[submesh.vertexOffset];
+
+                float error = 0.f;
+                auto simplified = MeshOptimizer::simplify(source, &submeshVertices->position.x, sizeof(Vertex),
+                    submeshVertexCount, static_cast<size_t>(source.size() * targetRatio) / 3 * 3, maxError, &error);
+                simplified = MeshOptimizer::optimizeVertexCache(simplified, submeshVertexCount);
+
+                lod.submeshes.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()),
+                    submesh.vertexOffset});
+                lod.error = glm::max(lod.error, error);
+                lodIndexCount += simplified.size();
+                indices.insert(indices.end(), simplified.begin(), simplified.end());
+            }
+
+            // the simplifier is stuck on locked borders or the error limit, another level would not save anything
+            if(lodIndexCount == 0 || lodIndexCount > previousIndexCount * 9 / 10) {
+                indices.resize(lod.submeshes.front().firstIndex);
+                break;
+            }
+            previousIndexCount = lodIndexCount;
+            lods.push_back(std::move(lod));
+        }
+    }
+
+    void Model::Builder::buildMeshlets(uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        meshlets.clear();
+        meshletIndices.clear();
+        if(indices.empty())
+            return;
+
+        const std::vector<Submesh> base = submeshes.empty()
+            ? std::vector<Submesh>{{0, static_cast<uint32_t>(indices.size()), 0}}
+            : submeshes;
+
+        for(const auto& submesh : base)
+        {
+            std::vector<uint32_t> source(indices.begin() + submesh.firstIndex,
+                indices.begin() + submesh.firstIndex + submesh.indexCount);
+            const uint32_t submeshVertexCount = *std::max_element(source.begin(), source.end()) + 1;
+            const Vertex* submeshVertices = &vertices[submesh.vertexOffset];
+
+            std::vector<uint32_t> meshletVertices;
+            std::vector<uint8_t> meshletTriangles;
+            auto clusters = MeshOptimizer::buildMeshlets(source, submeshVertexCount, meshletVertices, meshletTriangles,
+                maxVertices, maxTriangles);
+
+            for(const auto& cluster : clusters)
+            {
+                auto bounds = MeshOptimizer::computeMeshletBounds(cluster, meshletVertices, meshletTriangles,
+                    &submeshVertices->position.x, sizeof(Vertex));
+
+                MeshletData meshlet{};
+                meshlet.boundingSphere = {bounds.center[0], bounds.center[1], bounds.center[2], bounds.radius};
+                meshlet.cone = {bounds.coneAxis[0], bounds.coneAxis[1], bounds.coneAxis[2],
+                    meshletBackfaceCulling ? bounds.coneCutoff : 2.f};
+                meshlet.firstIndex = static_cast<uint32_t>(meshletIndices.size());
+                meshlet.triangleCount = cluster.triangleCount;
+
+                // the culling pass writes a plain index list, so local indices are resolved here
+                for(uint32_t i = 0; i < cluster.triangleCount * 3; i++) {
+                    const uint8_t local = meshletTriangles[cluster.triangleOffset + i];
+                    meshletIndices.push_back(meshletVertices[cluster.vertexOffset + local] + submesh.vertexOffset);
                 }
+                meshlets.push_back(meshlet);
+            }
+        }
+    }
 
-                if(uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
+    void Model::Builder::splitIntoSubmeshes(uint32_t maxVertices)
+    {
+        assert(maxVertices >= 3 && "A submesh needs room for one triangle");
+        submeshes.clear();
+        if(indices.empty())
+            return;
+
+        std::vector<Vertex> chunkedVertices;
+        std::vector<uint32_t> chunkedIndices;
+        chunkedVertices.reserve(vertices.size());
+        chunkedIndices.reserve(indices.size());
+
+        // global vertex -> index local to the current submesh, tagged with the submesh it belongs to
+        std::vector<uint32_t> localIndex(vertices.size());
+        std::vector<uint32_t> localOwner(vertices.size(), ~0u);
+
+        Submesh submesh{};
+        uint32_t submeshVertexCount = 0;
+        for(size_t t = 0; t < indices.size(); t += 3)
+        {
+            const uint32_t submeshIndex = static_cast<uint32_t>(submeshes.size());
+            uint32_t newVertices = 0;
+            for(size_t k = 0; k < 3; k++) {
+                newVertices += localOwner[indices[t + k]] != submeshIndex;
+            }
+            if(submeshVertexCount + newVertices > maxVertices) {
+                // start a new submesh, every vertex of this triangle becomes new again
+                submeshes.push_back(submesh);
+                submesh = Submesh{};
+                submesh.firstIndex = static_cast<uint32_t>(chunkedIndices.size());
+                submesh.vertexOffset = static_cast<int32_t>(chunkedVertices.size());
+                submeshVertexCount = 0;
+            }
+
+            const uint32_t owner = static_cast<uint32_t>(submeshes.size());
+            for(size_t k = 0; k < 3; k++) {
+                const uint32_t vertex = indices[t + k];
+                if(localOwner[vertex] != owner) {
+                    localOwner[vertex] = owner;
+                    localIndex[vertex] = submeshVertexCount++;
+                    chunkedVertices.push_back(vertices[vertex]);
                 }
-                indices.push_back(uniqueVertices[vertex]);
+                chunkedIndices.push_back(localIndex[vertex]);
             }
+            submesh.indexCount += 3;
         }
+        submeshes.push_back(submesh);
+
+        vertices = std::move(chunkedVertices);
+        indices = std::move(chunkedIndices);
+    }
+
+    void Model::Builder::optimize(const std::string &name)
+    {
+        if(indices.empty())
+            return;
+
+        // the cache simulation is only run for the statistics
+        MeshOptimizer::VertexCacheStats before{};
+        if(printStats)
+            before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+
+        std::vector<uint32_t> clusters;
+        indices = MeshOptimizer::optimizeVertexCache(indices, vertices.size(), 16, &clusters);
+        indices = MeshOptimizer::optimizeOverdraw(indices, clusters,
+            &vertices[0].position.x, sizeof(Vertex), vertices.size());
+
+        uint32_t newVertexCount = 0;
+        auto remap = MeshOptimizer::optimizeVertexFetchRemap(indices, vertices.size(), newVertexCount);
+        vertices = MeshOptimizer::remapVertices(vertices, remap, newVertexCount);
+
+        if(!printStats)
+            return;
+        const auto after = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+        std::cout << std::fixed << std::setprecision(3)
+            << name << ": " << indices.size() / 3 << " triangles, "
+            << "ACMR " << before.acmr << " -> " << after.acmr << ", "
+            << "ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        std::cout.unsetf(std::ios::fixed);
     }
 
     // namespace Cosmos
@@ -30,11 +30,75 @@ namespace Cosmos {
             }
         };
 
+        enum class VertexFormat {
+            Standard, // Vertex, 44 bytes of float32
+            Compact,  // CompactVertex, 20 bytes
+        };
+
+        // Quantized layout, decoded in simple_shader_compact.vert:
+        // position is 16 bit unorm relative to the mesh bounds (the bounds are folded into the model matrix,
+        // see getDequantizeMatrix), normal is octahedral encoded 2x16 bit snorm, uv half float, color rgba8
+        struct CompactVertex {
+            uint16_t position[4]; // w unused, keeps the attribute 8 byte aligned
+            uint8_t color[4];
+            int16_t normal[2];
+            uint16_t uv[2];
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+
+        // Range of the index buffer drawn with its own vertexOffset, indices are relative to it
+        struct Submesh {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            int32_t vertexOffset = 0;
+        };
+
+        // Simplified version of the whole mesh, indexing the same vertex buffer
+        struct Lod {
+            std::vector<Submesh> submeshes{};
+            float error = 0.f; // model space distance to the full resolution surface
+        };
+
+        // GPU layout of a meshlet, std430 in meshlet_cull.comp
+        struct MeshletData {
+            glm::vec4 boundingSphere{}; // xyz center, w radius, model space
+            glm::vec4 cone{};           // xyz axis, w cutoff, above 1 the meshlet is never backface culled
+            uint32_t firstIndex = 0;    // into the meshlet index buffer
+            uint32_t triangleCount = 0;
+            uint32_t padding[2]{};
+        };
+
+        // largest vertex count addressable by uint16 indices (primitive restart is never enabled)
+        static constexpr uint32_t MAX_UINT16_VERTICES = 65536;
+
         struct Builder {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            std::vector<Submesh> submeshes{}; // empty: one submesh covering all indices
+            std::vector<Lod> lods{}; // levels after the full resolution one, coarsest last
+            VertexFormat vertexFormat = VertexFormat::Standard; // layout on the GPU, vertices stay full precision
+            bool splitForUint16Indices = false; // meshes above MAX_UINT16_VERTICES are chunked so they can use uint16 indices
+            uint32_t lodCount = 4; // generated by loadModel including full resolution, 1 disables LODs
+            std::vector<MeshletData> meshlets{}; // clusters of the full resolution level
+            std::vector<uint32_t> meshletIndices{}; // triangles of every meshlet, absolute vertex indices
+            bool meshletCulling = false; // loadModel builds meshlets for MeshletCullSystem
+            bool meshletBackfaceCulling = true; // only valid for closed meshes, the pipelines draw back faces
+            unsigned importThreads = 0; // OBJ parsing threads, 0 = hardware concurrency (large files only)
+            bool printStats = false; // import statistics to std::cout, off for streamed models
             
             void loadModel(const std::string &filepath);
+            // vertex cache, overdraw and vertex fetch reordering, prints ACMR/ATVR before and after with printStats
+            void optimize(const std::string &name);
+            // Splits the triangles in order into submeshes of at most maxVertices vertices each,
+            // shared vertices on chunk borders are duplicated
+            void splitIntoSubmeshes(uint32_t maxVertices = MAX_UINT16_VERTICES);
+            // Appends up to lodCount - 1 simplified index ranges, each aiming for `reduction` of the previous
+            // triangle count. Stops early once the simplifier cannot make progress.
+            void generateLods(uint32_t lodCount, float reduction = .5f);
+            // Clusters the full resolution triangles of every submesh and computes their culling bounds
+            void buildMeshlets(uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
         };
 
         Model(EngineDevice &device, const Model::Builder &builder);
@@ -43,22 +107,62 @@ namespace Cosmos {
         Model(const Model&) = delete;
         Model& operator=(const Model&) = delete;  
 
-        static std::unique_ptr<Model> createModelFromFile(EngineDevice& device, const std::string& filepath);
+        static std::unique_ptr<Model> createModelFromFile(EngineDevice& device, const std::string& filepath,
+            VertexFormat vertexFormat = VertexFormat::Standard);
 
         void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer); 
+        // vertex buffer only, for draws from an index buffer owned by someone else
+        void bindVertexBuffer(VkCommandBuffer commandBuffer);
+        void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0); 
+
+        uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+        float getLodError(uint32_t lod) const { return lods[lod].error; }
+        // bounding sphere in model space
+        glm::vec3 getBoundingCenter() const { return boundsMin + boundsExtent * .5f; }
+        float getBoundingRadius() const { return boundingRadius; }
+
+        // vertex, index and meshlet buffers
+        VkDeviceSize getDeviceMemorySize() const;
+
+        VertexFormat getVertexFormat() const { return vertexFormat; }
+        VkIndexType getIndexType() const { return indexType; }
+        // Maps quantized positions back to model space, identity for the standard format
+        glm::mat4 getDequantizeMatrix() const;
+
+        bool hasMeshlets() const { return meshletCount > 0; }
+        uint32_t getMeshletCount() const { return meshletCount; }
+        uint32_t getMeshletIndexCount() const { return meshletIndexCount; }
+        Buffer& getMeshletBuffer() { return *meshletBuffer; }
+        Buffer& getMeshletIndexBuffer() { return *meshletIndexBuffer; }
 
     private:
+        void computeBounds(const std::vector<Vertex> &vertices);
         void createVertexBuffers(const std::vector<Vertex> &vertices);
+        void createCompactVertexBuffers(const std::vector<Vertex> &vertices);
+        void uploadVertexBuffer(const void* data, uint32_t vertexSize);
         void createIndexBuffer(const std::vector<uint32_t> &indices);
+        void uploadIndexBuffer(const void* data, uint32_t indexSize);
+        std::unique_ptr<Buffer> createStorageBuffer(const void* data, uint32_t instanceSize, uint32_t instanceCount);
 
         EngineDevice& engineDevice;
 
         std::unique_ptr<Buffer> vertexBuffer;
         uint32_t vertexCount;
+        VertexFormat vertexFormat;
+        glm::vec3 boundsMin{0.f};
+        glm::vec3 boundsExtent{1.f};
+        float boundingRadius = 0.f;
         
         bool hasIndexBuffer = false;
         std::unique_ptr<Buffer> indexBuffer;
         uint32_t indexCount;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        std::vector<Lod> lods; // lods[0] is full resolution
+
+        // culled by MeshletCullSystem, only read by compute
+        std::unique_ptr<Buffer> meshletBuffer;
+        std::unique_ptr<Buffer> meshletIndexBuffer;
+        uint32_t meshletCount = 0;
+        uint32_t meshletIndexCount = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "obj_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Cosmos {
+
+    namespace {
+
+        // lines handed to one parse call, small enough to keep the corner batches in cache sized pieces
+        constexpr size_t SERIAL_CHUNK_SIZE = 1 << 20;
+        constexpr size_t PARALLEL_CHUNK_SIZE = 4 << 20;
+
+        bool isDigit(char c) { return c >= '0' && c <= '9'; }
+        bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        const char* skipBlanks(const char* p, const char* end)
+        {
+            while(p < end && isBlank(*p)) p++;
+            return p;
+        }
+
+        const char* parseInt(const char* p, const char* end, int64_t& value)
+        {
+            bool negative = false;
+            if(p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                p++;
+            }
+            if(p >= end || !isDigit(*p)) return nullptr;
+            int64_t result = 0;
+            while(p < end && isDigit(*p)) {
+                result = result * 10 + (*p - '0');
+                p++;
+            }
+            value = negative ? -result : result;
+            return p;
+        }
+
+        // Runs task(i) for i in [0, count) on up to threadCount threads, rethrows the first failure
+        template<typename Task>
+        void runParallel(size_t count, unsigned threadCount, const Task& task)
+        {
+            std::atomic<size_t> next{0};
+            std::exception_ptr failure;
+            std::mutex failureMutex;
+            auto worker = [&]() {
+                for(size_t i = next++; i < count; i = next++) {
+                    try {
+                        task(i);
+                    } catch(...) {
+                        std::lock_guard<std::mutex> lock{failureMutex};
+                        if(!failure) failure = std::current_exception();
+                        next = count;
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            const size_t extraThreads = std::min<size_t>(threadCount, count) - 1;
+            for(size_t t = 0; t < extraThreads; t++) threads.emplace_back(worker);
+            worker();
+            for(auto& thread : threads) thread.join();
+            if(failure) std::rethrow_exception(failure);
+        }
+    }
+
+    ObjParser::ObjParser(const std::string& filePath) : filePath{filePath}, file{AssetArchive::load(filePath)}
+    {
+    }
+
+    const char* ObjParser::parseFloat(const char* p, const char* end, float& value)
+    {
+        static const double powersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            p++;
+        }
+
+        // up to 19 significant digits fit the mantissa, more cannot change a float
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+        while(p < end && isDigit(*p)) {
+            if(digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa != 0) digits++;
+            } else {
+                exponent++;
+            }
+            anyDigit = true;
+            p++;
+        }
+        if(p < end && *p == '.') {
+            p++;
+            while(p < end && isDigit(*p)) {
+                if(digits < 19) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if(mantissa != 0) digits++;
+                    exponent--;
+                }
+                anyDigit = true;
+                p++;
+            }
+        }
+        if(!anyDigit) return nullptr;
+
+        if(p < end && (*p == 'e' || *p == 'E')) {
+            int64_t exponentValue = 0;
+            const char* exponentEnd = parseInt(p + 1, end, exponentValue);
+            if(exponentEnd) {
+                exponent += static_cast<int>(std::max<int64_t>(-1000, std::min<int64_t>(1000, exponentValue)));
+                p = exponentEnd;
+            }
+        }
+
+        double result = static_cast<double>(mantissa);
+        if(mantissa != 0 && exponent != 0) {
+            const int magnitude = exponent < 0 ? -exponent : exponent;
+            const double scale = magnitude <= 22 ? powersOfTen[magnitude] : std::pow(10.0, magnitude);
+            result = exponent < 0 ? result / scale : result * scale;
+        }
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
+    void ObjParser::parse(const CornerCallback& onCorners, unsigned threadCount)
+    {
+        attributes = Attributes{};
+        if(threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        if(threadCount > 1 && file.size() >= PARALLEL_THRESHOLD)
+            parseParallel(onCorners, threadCount);
+        else
+            parseSerial(onCorners);
+    }
+
+    void ObjParser::parseSerial(const CornerCallback& onCorners)
+    {
+        std::vector<Chunk> chunks;
+        splitChunks(chunks, SERIAL_CHUNK_SIZE);
+        for(auto& chunk : chunks) {
+            parseChunk(chunk, true);
+            onCorners(chunk.corners.data(), chunk.corners.size());
+            chunk.corners = {};
+        }
+    }
+
+    /*
+    Face indices are global (or relative to the attributes defined so far), so every chunk needs to know
+    how many attributes precede it: a cheap counting pass runs first, its prefix sums presize the pools
+    and each chunk writes its attributes into its own range. Chunks are parsed in waves of threadCount
+    and their corners are handed out in order after every wave, which bounds the corner memory.
+    */
+    void ObjParser::parseParallel(const CornerCallback& onCorners, unsigned threadCount)
+    {
+        std::vector<Chunk> chunks;
+        splitChunks(chunks, PARALLEL_CHUNK_SIZE);
+
+        runParallel(chunks.size(), threadCount, [&](size_t i) { countAttributes(chunks[i]); });
+
+        uint32_t positionCount = 0, texcoordCount = 0, normalCount = 0;
+        for(auto& chunk : chunks) {
+            chunk.positionBase = positionCount;
+            chunk.texcoordBase = texcoordCount;
+            chunk.normalBase = normalCount;
+            positionCount += chunk.positionCount;
+            texcoordCount += chunk.texcoordCount;
+            normalCount += chunk.normalCount;
+        }
+        attributes.positions.resize(static_cast<size_t>(positionCount) * 3);
+        attributes.colors.resize(static_cast<size_t>(positionCount) * 3);
+        attributes.normals.resize(static_cast<size_t>(normalCount) * 3);
+        attributes.texcoords.resize(static_cast<size_t>(texcoordCount) * 2);
+
+        for(size_t first = 0; first < chunks.size(); first += threadCount)
+        {
+            const size_t waveSize = std::min<size_t>(threadCount, chunks.size() - first);
+            runParallel(waveSize, threadCount, [&](size_t i) { parseChunk(chunks[first + i], false); });
+            for(size_t i = first; i < first + waveSize; i++) {
+                onCorners(chunks[i].corners.data(), chunks[i].corners.size());
+                chunks[i].corners = {};
+            }
+        }
+    }
+
+    // Ranges of about chunkSize bytes, every range ends after a newline (or at the end of the file)
+    void ObjParser::splitChunks(std::vector<Chunk>& chunks, size_t chunkSize) const
+    {
+        const char* data = file.data();
+        const char* end = data + file.size();
+        const char* begin = data;
+        while(begin < end) {
+            const char* split = end - begin > static_cast<ptrdiff_t>(chunkSize) ? begin + chunkSize : end;
+            if(split < end) {
+                const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+                split = newline ? newline + 1 : end;
+            }
+            Chunk chunk{};
+            chunk.begin = begin;
+            chunk.end = split;
+            chunks.push_back(std::move(chunk));
+            begin = split;
+        }
+    }
+
+    void ObjParser::countAttributes(Chunk& chunk)
+    {
+        const char* p = chunk.begin;
+        while(p < chunk.end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+            if(!lineEnd) lineEnd = chunk.end;
+
+            p = skipBlanks(p, lineEnd);
+            if(lineEnd - p >= 2 && p[0] == 'v') {
+                if(isBlank(p[1])) chunk.positionCount++;
+                else if(lineEnd - p >= 3 && isBlank(p[2])) {
+                    if(p[1] == 't') chunk.texcoordCount++;
+                    else if(p[1] == 'n') chunk.normalCount++;
+                }
+            }
+            p = lineEnd + 1;
+        }
+    }
+
+    void ObjParser::parseChunk(Chunk& chunk, bool appendAttributes)
+    {
+        if(appendAttributes) {
+            chunk.positionBase = static_cast<uint32_t>(attributes.positions.size() / 3);
+            chunk.texcoordBase = static_cast<uint32_t>(attributes.texcoords.size() / 2);
+            chunk.normalBase = static_cast<uint32_t>(attributes.normals.size() / 3);
+        }
+        uint32_t positionCount = 0, texcoordCount = 0, normalCount = 0;
+
+        auto store = [&](std::vector<float>& pool, size_t index, const float* values, size_t count) {
+            if(appendAttributes) pool.insert(pool.end(), values, values + count);
+            else std::memcpy(&pool[index * count], values, count * sizeof(float));
+        };
+        // OBJ indices are 1 based, negative ones count back from the last attribute defined so far
+        auto resolve = [&](int64_t index, uint32_t definedCount) {
+            const int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(definedCount) + index;
+            if(index == 0 || resolved < 0 || resolved >= definedCount) {
+                throw std::runtime_error("invalid face index in " + filePath);
+            }
+            return static_cast<uint32_t>(resolved);
+        };
+
+        std::vector<Corner> polygon;
+        chunk.corners.clear();
+        chunk.corners.reserve((chunk.end - chunk.begin) / 16);
+
+        const char* p = chunk.begin;
+        while(p < chunk.end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+            if(!lineEnd) lineEnd = chunk.end;
+            p = skipBlanks(p, lineEnd);
+
+            if(lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1]))
+            {
+                // v x y z [r g b], a 4th value alone is the rarely used w
+                float values[6] = {0.f, 0.f, 0.f, 1.f, 1.f, 1.f};
+                size_t count = 0;
+                const char* q = p + 2;
+                while(count < 6) {
+                    q = skipBlanks(q, lineEnd);
+                    const char* next = parseFloat(q, lineEnd, values[count]);
+                    if(!next) break;
+                    q = next;
+                    count++;
+                }
+                if(count < 3) throw std::runtime_error("invalid vertex position in " + filePath);
+                if(count < 6) values[3] = values[4] = values[5] = 1.f;
+
+                const size_t index = chunk.positionBase + positionCount++;
+                store(attributes.positions, index, values, 3);
+                store(attributes.colors, index, values + 3, 3);
+            }
+            else if(lineEnd - p >= 3 && p[0] == 'v' && (p[1] == 't' || p[1] == 'n') && isBlank(p[2]))
+            {
+                const bool normal = p[1] == 'n';
+                float values[3] = {0.f, 0.f, 0.f};
+                const size_t wanted = normal ? 3 : 2;
+                const char* q = p + 3;
+                for(size_t i = 0; i < wanted; i++) {
+                    q = skipBlanks(q, lineEnd);
+                    const char* next = parseFloat(q, lineEnd, values[i]);
+                    if(!next) break;
+                    q = next;
+                }
+
+                if(normal) store(attributes.normals, chunk.normalBase + normalCount++, values, 3);
+                else store(attributes.texcoords, chunk.texcoordBase + texcoordCount++, values, 2);
+            }
+            else if(lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1]))
+            {
+                // f v, f v/vt, f v//vn or f v/vt/vn
+                polygon.clear();
+                const char* q = skipBlanks(p + 2, lineEnd);
+                while(q < lineEnd) {
+                    Corner corner{};
+                    int64_t index = 0;
+                    q = parseInt(q, lineEnd, index);
+                    if(!q) throw std::runtime_error("invalid face in " + filePath);
+                    corner.position = resolve(index, chunk.positionBase + positionCount);
+
+                    if(q < lineEnd && *q == '/') {
+                        q++;
+                        if(q < lineEnd && *q != '/') {
+                            q = parseInt(q, lineEnd, index);
+                            if(!q) throw std::runtime_error("invalid face in " + filePath);
+                            corner.texcoord = resolve(index, chunk.texcoordBase + texcoordCount);
+                        }
+                        if(q < lineEnd && *q == '/') {
+                            q = parseInt(q + 1, lineEnd, index);
+                            if(!q) throw std::runtime_error("invalid face in " + filePath);
+                            corner.normal = resolve(index, chunk.normalBase + normalCount);
+                        }
+                    }
+                    polygon.push_back(corner);
+                    q = skipBlanks(q, lineEnd);
+                }
+
+                for(size_t i = 1; i + 1 < polygon.size(); i++) {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i]);
+                    chunk.corners.push_back(polygon[i + 1]);
+                }
+            }
+            // comments, groups, smoothing groups and materials are ignored
+
+            p = lineEnd + 1;
+        }
+    }
+}
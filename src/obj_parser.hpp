@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "asset_archive.hpp"
+
+namespace Cosmos {
+
+    /*
+    Streaming Wavefront OBJ reader working directly on the mapped file (or archive entry). Only the attribute pools
+    (v, vt, vn) are kept, faces are fan triangulated and handed out as index triples in file order,
+    so the caller builds its deduplicated vertices without intermediate shape arrays.
+    Large files are split into ranges of whole lines and parsed by several threads.
+    */
+    class ObjParser {
+    public:
+        static constexpr uint32_t NO_INDEX = ~0u;
+        // smaller files are not worth the thread start up and the extra counting pass
+        static constexpr size_t PARALLEL_THRESHOLD = 8 << 20;
+
+        // One triangle corner, indices into the attribute pools, NO_INDEX when the face omits it
+        struct Corner {
+            uint32_t position = NO_INDEX;
+            uint32_t texcoord = NO_INDEX;
+            uint32_t normal = NO_INDEX;
+
+            bool operator==(const Corner& other) const {
+                return position == other.position && texcoord == other.texcoord && normal == other.normal;
+            }
+        };
+
+        struct Attributes {
+            std::vector<float> positions{}; // xyz
+            std::vector<float> colors{};    // rgb per position, white when the file has none
+            std::vector<float> normals{};   // xyz
+            std::vector<float> texcoords{}; // uv
+        };
+
+        // Called in file order, the pools already hold every attribute the corners reference
+        using CornerCallback = std::function<void(const Corner* corners, size_t count)>;
+
+        explicit ObjParser(const std::string& filePath);
+
+        ObjParser(const ObjParser&) = delete;
+        ObjParser& operator=(const ObjParser&) = delete;
+
+        // threadCount 0 uses the hardware concurrency, files below PARALLEL_THRESHOLD are parsed on this thread
+        void parse(const CornerCallback& onCorners, unsigned threadCount = 0);
+        const Attributes& getAttributes() const { return attributes; }
+        size_t getFileSize() const { return file.size(); }
+
+        // Locale independent decimal float parser in the spirit of std::from_chars,
+        // returns the first character after the number or nullptr if there is none
+        static const char* parseFloat(const char* begin, const char* end, float& value);
+
+    private:
+        struct Chunk {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            // attributes defined before this chunk
+            uint32_t positionBase = 0;
+            uint32_t texcoordBase = 0;
+            uint32_t normalBase = 0;
+            // attributes defined inside this chunk
+            uint32_t positionCount = 0;
+            uint32_t texcoordCount = 0;
+            uint32_t normalCount = 0;
+            std::vector<Corner> corners{};
+        };
+
+        void parseSerial(const CornerCallback& onCorners);
+        void parseParallel(const CornerCallback& onCorners, unsigned threadCount);
+        void splitChunks(std::vector<Chunk>& chunks, size_t chunkSize) const;
+        static void countAttributes(Chunk& chunk);
+        // appendAttributes: push to the pools, otherwise the pools are presized and written at the chunk bases
+        void parseChunk(Chunk& chunk, bool appendAttributes);
+
+        std::string filePath;
+        AssetData file;
+        Attributes attributes{};
+    };
+}
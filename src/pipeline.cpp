@@ -1,11 +1,11 @@
 #include "pipeline.hpp"
 
-#include <fstream>
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
 
 #include "model.hpp"
+#include "asset_archive.hpp"
 
 namespace Cosmos {
 
@@ -18,6 +18,9 @@ namespace Cosmos {
     Pipeline::~Pipeline() {
         vkDestroyShaderModule(engineDevice.device(), vertShaderModule, nullptr);
         vkDestroyShaderModule(engineDevice.device(), fragShaderModule, nullptr);
+        engineDevice.retire([device = engineDevice.device(), pipeline = graphicsPipeline]() {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
     }
 
     void Pipeline::bind(VkCommandBuffer commandBuffer)
@@ -115,22 +118,24 @@ namespace Cosmos {
         configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;         
     }
 
-    std::vector<char> Pipeline::readFile(const std::string& filePath) {
-        // ate -> when file is opened, seeked the end immediately
-        // binary -> read file as binary
-        std::ifstream file(filePath, std::ios::ate | std::ios::binary);
-        if(!file.is_open()) {
-            throw std::runtime_error("failed to open file: " + filePath);
-        }
+    void Pipeline::disableColorWrites(PipelineConfigInfo& configInfo)
+    {
+        configInfo.colorBlendAttachment.blendEnable = VK_FALSE;
+        configInfo.colorBlendAttachment.colorWriteMask = 0;
+    }
 
-        size_t fileSize = static_cast<size_t>(file.tellg()); //tellg -> last position
-        
-        std::vector<char> buffer(fileSize);
+    void Pipeline::enableDepthEqualTest(PipelineConfigInfo& configInfo)
+    {
+        // invariant gl_Position in both vertex shaders makes the depths of the two passes bit identical
+        configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+    }
 
-        file.seekg(0); //go back to beginning
-        file.read(buffer.data(), fileSize);
-        file.close();
-        return buffer;
+    std::vector<char> Pipeline::readFile(const std::string& filePath) {
+        // from a mounted archive if it has the shader, copied since SPIR-V must be 4 byte aligned
+        // and archive entries may be compressed
+        AssetData file = AssetArchive::load(filePath);
+        return std::vector<char>(file.data(), file.data() + file.size());
     }
     
     void Pipeline::createGraphicsPipeline(const std::string& vertPath, 
@@ -139,16 +144,21 @@ namespace Cosmos {
     {
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE &&
         "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
-        assert(configInfo.renderPass != VK_NULL_HANDLE &&
+        const RenderTarget& target = configInfo.renderTarget;
+        assert((target.renderPass != VK_NULL_HANDLE || engineDevice.supportsDynamicRendering()) &&
         "Cannot create graphcis pipeline: no renderPass provided in configInfo");
 
         auto vertCode = readFile(vertPath);
-        auto fragCode = readFile(fragPath);
 
         //std::cout << "Vertex Shader Code Size: " << vertCode.size() << " bytes\n";
-        //std::cout << "Fragment Shader Code Size: " << fragCode.size() << " bytes\n";
         createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+        // depth only pipelines have no fragment stage
+        fragShaderModule = VK_NULL_HANDLE;
+        if(!fragPath.empty())
+        {
+            auto fragCode = readFile(fragPath);
+            createShaderModule(fragCode, &fragShaderModule);
+        }
         
         VkPipelineShaderStageCreateInfo shaderStages[2];
         // Vertex shader
@@ -180,7 +190,7 @@ namespace Cosmos {
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
+        pipelineInfo.stageCount = fragShaderModule == VK_NULL_HANDLE ? 1 : 2;
         pipelineInfo.pStages = shaderStages;
         pipelineInfo.pVertexInputState = &vertexInputInfo;
         pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -192,8 +202,19 @@ namespace Cosmos {
         pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
 
         pipelineInfo.layout = configInfo.pipelineLayout;
-        pipelineInfo.renderPass = configInfo.renderPass;
-        pipelineInfo.subpass = configInfo.subpass;
+        pipelineInfo.renderPass = target.renderPass;
+        pipelineInfo.subpass = target.subpass;
+
+        // dynamic rendering: the attachment formats take the place of the render pass
+        VkPipelineRenderingCreateInfoKHR renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(target.colorFormats.size());
+        renderingInfo.pColorAttachmentFormats = target.colorFormats.data();
+        renderingInfo.depthAttachmentFormat = target.depthFormat;
+        if(target.renderPass == VK_NULL_HANDLE)
+        {
+            pipelineInfo.pNext = &renderingInfo;
+        }
 
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
@@ -216,4 +237,48 @@ namespace Cosmos {
         }
     }
 
+    ComputePipeline::ComputePipeline(EngineDevice& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout)
+        : engineDevice{device}
+    {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        auto compCode = Pipeline::readFile(compFilePath);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = compCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+        if(vkCreateShaderModule(engineDevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = compShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if(vkCreateComputePipelines(engineDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+    }
+
+    ComputePipeline::~ComputePipeline()
+    {
+        vkDestroyShaderModule(engineDevice.device(), compShaderModule, nullptr);
+        engineDevice.retire([device = engineDevice.device(), pipeline = computePipeline]() {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        });
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
 } // namespace Cosmos
\ No newline at end of file
@@ -7,6 +7,15 @@
 
 namespace Cosmos {
 
+    // What a graphics pipeline draws into. Without a render pass (dynamic rendering) only the attachment
+    // formats count, the pipeline works with any attachments of these formats in any rendering
+    struct RenderTarget {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+        std::vector<VkFormat> colorFormats{};
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    };
+
     struct PipelineConfigInfo {
         // to match C++ 20
         PipelineConfigInfo() = default;
@@ -27,13 +36,13 @@ namespace Cosmos {
         std::vector<VkDynamicState> dynamicStateEnables;
         VkPipelineDynamicStateCreateInfo dynamicStateInfo;
         VkPipelineLayout pipelineLayout = nullptr;
-        VkRenderPass renderPass = nullptr;
-        uint32_t subpass = 0;
+        RenderTarget renderTarget{};
     };
 
 
     class Pipeline {
     public:
+        // fragFilePath may be empty: no fragment stage, depth only
         Pipeline(EngineDevice& device, const std::string& vertFilePath, const std::string& fragFilePath,
                  const PipelineConfigInfo& configInfo);
         ~Pipeline();
@@ -45,8 +54,13 @@ namespace Cosmos {
         
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
         static void enableAlphaBlending(PipelineConfigInfo& configInfo);
+        // For depth only pipelines, their fragment shader path is empty
+        static void disableColorWrites(PipelineConfigInfo& configInfo);
+        // Shades only the surfaces a depth prepass with the same geometry left in the depth buffer
+        static void enableDepthEqualTest(PipelineConfigInfo& configInfo);
 
         private:
+        friend class ComputePipeline;
         static std::vector<char> readFile(const std::string& filePath);
 
         void createGraphicsPipeline(const std::string& vertPath, const std::string& fragPath,
@@ -60,4 +74,21 @@ namespace Cosmos {
         VkShaderModule fragShaderModule;
     };
 
+    // Single compute stage, the layout is owned by the system using it
+    class ComputePipeline {
+    public:
+        ComputePipeline(EngineDevice& device, const std::string& compFilePath, VkPipelineLayout pipelineLayout);
+        ~ComputePipeline();
+
+        ComputePipeline(const ComputePipeline&) = delete;
+        ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        EngineDevice& engineDevice;
+        VkPipeline computePipeline;
+        VkShaderModule compShaderModule;
+    };
+
 } // namespace Cosmos
\ No newline at end of file
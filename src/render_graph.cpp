@@ -0,0 +1,656 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace Cosmos {
+
+    namespace {
+        constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT
+            | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        VkImageUsageFlags usageForLayout(VkImageLayout layout)
+        {
+            switch(layout) {
+                case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return VK_IMAGE_USAGE_SAMPLED_BIT;
+                case VK_IMAGE_LAYOUT_GENERAL: return VK_IMAGE_USAGE_STORAGE_BIT;
+                case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                default: return 0;
+            }
+        }
+    }
+
+    void RenderGraph::PassBuilder::read(ImageHandle image, const ImageAccess& access)
+    {
+        assert(image.index < graph.images.size() && "RenderGraph: image handle of another frame");
+        graph.passes[pass].images.push_back({image.index, access, false});
+    }
+
+    void RenderGraph::PassBuilder::write(ImageHandle image, const ImageAccess& access)
+    {
+        assert(image.index < graph.images.size() && "RenderGraph: image handle of another frame");
+        graph.passes[pass].images.push_back({image.index, access, true});
+    }
+
+    void RenderGraph::PassBuilder::read(BufferHandle buffer, const BufferAccess& access)
+    {
+        assert(buffer.index < graph.buffers.size() && "RenderGraph: buffer handle of another frame");
+        graph.passes[pass].buffers.push_back({buffer.index, access, false});
+    }
+
+    void RenderGraph::PassBuilder::write(BufferHandle buffer, const BufferAccess& access)
+    {
+        assert(buffer.index < graph.buffers.size() && "RenderGraph: buffer handle of another frame");
+        graph.passes[pass].buffers.push_back({buffer.index, access, true});
+    }
+
+    void RenderGraph::PassBuilder::setSideEffects()
+    {
+        graph.passes[pass].sideEffects = true;
+    }
+
+    VkImage RenderGraph::PassResources::getImage(ImageHandle image) const
+    {
+        return graph.images[image.index].image;
+    }
+
+    VkImageView RenderGraph::PassResources::getImageView(ImageHandle image) const
+    {
+        return graph.images[image.index].view;
+    }
+
+    VkExtent2D RenderGraph::PassResources::getExtent(ImageHandle image) const
+    {
+        return graph.images[image.index].desc.extent;
+    }
+
+    VkBuffer RenderGraph::PassResources::getBuffer(BufferHandle buffer) const
+    {
+        return graph.buffers[buffer.index].buffer;
+    }
+
+    RenderGraph::RenderGraph(EngineDevice& device, uint32_t framesInFlight) : engineDevice{device}
+    {
+        transientAllocations.resize(framesInFlight);
+    }
+
+    RenderGraph::~RenderGraph()
+    {
+        for(auto& allocation : transientAllocations) {
+            releaseTransientImages(allocation);
+        }
+    }
+
+    void RenderGraph::reset()
+    {
+        images.clear();
+        buffers.clear();
+        passes.clear();
+        order.clear();
+        finalBarriers.clear();
+        finalSrcStages = 0;
+    }
+
+    RenderGraph::ImageHandle RenderGraph::importImage(const std::string& name, VkImage image, VkImageView view,
+        VkExtent2D extent, VkImageAspectFlags aspect, const ImageAccess& current)
+    {
+        ImageResource resource{};
+        resource.name = name;
+        resource.desc.extent = extent;
+        resource.desc.aspect = aspect;
+        resource.image = image;
+        resource.view = view;
+        resource.current = current;
+        images.push_back(resource);
+        return {static_cast<uint32_t>(images.size() - 1)};
+    }
+
+    RenderGraph::BufferHandle RenderGraph::importBuffer(const std::string& name, VkBuffer buffer)
+    {
+        return importBuffer(name, buffer, BufferAccess{});
+    }
+
+    RenderGraph::BufferHandle RenderGraph::importBuffer(const std::string& name, VkBuffer buffer,
+        const BufferAccess& current)
+    {
+        buffers.push_back({name, buffer, current});
+        return {static_cast<uint32_t>(buffers.size() - 1)};
+    }
+
+    RenderGraph::ImageHandle RenderGraph::createImage(const std::string& name, const ImageDesc& desc)
+    {
+        ImageResource resource{};
+        resource.name = name;
+        resource.transient = true;
+        resource.desc = desc;
+        images.push_back(resource);
+        return {static_cast<uint32_t>(images.size() - 1)};
+    }
+
+    void RenderGraph::exportImage(ImageHandle image, VkImageLayout finalLayout)
+    {
+        images[image.index].exported = true;
+        images[image.index].finalLayout = finalLayout;
+    }
+
+    void RenderGraph::addPass(const std::string& name, const SetupFunction& setup, ExecuteFunction execute)
+    {
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+
+        PassBuilder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+        setup(builder);
+    }
+
+    void RenderGraph::execute(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        compile(frameIndex);
+
+        const PassResources resources{*this};
+        for(uint32_t index : order)
+        {
+            auto& pass = passes[index];
+            if(pass.culled) continue;
+
+            const bool memoryBarrier = pass.memoryBarrier.srcAccessMask != 0 || pass.memoryBarrier.dstAccessMask != 0;
+            if(pass.srcStages != 0 || !pass.imageBarriers.empty())
+            {
+                // a pure layout transition of something nothing used before waits for nothing
+                const VkPipelineStageFlags srcStages = pass.srcStages != 0 ? pass.srcStages
+                    : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                vkCmdPipelineBarrier(commandBuffer,
+                    srcStages, pass.dstStages, 0,
+                    memoryBarrier ? 1 : 0, &pass.memoryBarrier,
+                    0, nullptr,
+                    static_cast<uint32_t>(pass.imageBarriers.size()), pass.imageBarriers.data());
+            }
+            pass.execute(commandBuffer, resources);
+        }
+
+        if(!finalBarriers.empty())
+        {
+            const VkPipelineStageFlags srcStages = finalSrcStages != 0 ? finalSrcStages
+                : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            vkCmdPipelineBarrier(commandBuffer,
+                srcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                0, nullptr, 0, nullptr,
+                static_cast<uint32_t>(finalBarriers.size()), finalBarriers.data());
+        }
+    }
+
+    void RenderGraph::compile(int frameIndex)
+    {
+        sortPasses();
+        cullPasses();
+        computeLifetimes();
+        allocateTransientImages(frameIndex);
+        buildBarriers();
+    }
+
+    void RenderGraph::sortPasses()
+    {
+        // edges follow the order the passes were added in. Per resource, a reader comes after the last writer
+        // added before it (read after write), a writer after that writer and the readers added since (write
+        // after write, write after read). A reader added before any writer sees the imported contents
+        std::vector<std::vector<uint32_t>> successors(passes.size());
+        std::vector<uint32_t> incoming(passes.size(), 0);
+        auto addEdge = [&](uint32_t from, uint32_t to) {
+            if(from == to) return;
+            successors[from].push_back(to);
+            incoming[to]++;
+        };
+
+        struct ResourceUsers {
+            uint32_t lastWriter = UINT32_MAX;
+            std::vector<uint32_t> readers{}; // added since lastWriter
+        };
+        auto addUse = [&](ResourceUsers& users, uint32_t pass, bool write) {
+            if(users.lastWriter != UINT32_MAX) addEdge(users.lastWriter, pass);
+            if(!write) {
+                users.readers.push_back(pass);
+                return;
+            }
+            for(uint32_t reader : users.readers) addEdge(reader, pass);
+            users.readers.clear();
+            users.lastWriter = pass;
+        };
+        // one use per resource and pass, a pass reading and writing the same resource is a writer
+        auto mergeUse = [](std::vector<std::pair<uint32_t, bool>>& uses, uint32_t resource, bool write) {
+            for(auto& use : uses) {
+                if(use.first == resource) {
+                    use.second = use.second || write;
+                    return;
+                }
+            }
+            uses.emplace_back(resource, write);
+        };
+
+        std::vector<ResourceUsers> imageUsers(images.size());
+        std::vector<ResourceUsers> bufferUsers(buffers.size());
+        std::vector<std::pair<uint32_t, bool>> uses;
+        for(uint32_t p = 0; p < passes.size(); p++)
+        {
+            uses.clear();
+            for(const auto& use : passes[p].images) mergeUse(uses, use.image, use.write);
+            for(const auto& use : uses) addUse(imageUsers[use.first], p, use.second);
+
+            uses.clear();
+            for(const auto& use : passes[p].buffers) mergeUse(uses, use.buffer, use.write);
+            for(const auto& use : uses) addUse(bufferUsers[use.first], p, use.second);
+        }
+
+        // Kahn, among the passes that are ready the one added first goes first
+        std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+        for(uint32_t p = 0; p < passes.size(); p++) {
+            if(incoming[p] == 0) ready.push(p);
+        }
+        order.clear();
+        while(!ready.empty())
+        {
+            const uint32_t p = ready.top();
+            ready.pop();
+            order.push_back(p);
+            for(uint32_t next : successors[p]) {
+                if(--incoming[next] == 0) ready.push(next);
+            }
+        }
+        if(order.size() != passes.size()) {
+            throw std::runtime_error("render graph has a dependency cycle between its passes!");
+        }
+    }
+
+    void RenderGraph::cullPasses()
+    {
+        // walking backwards: a pass is needed if a later needed pass uses something it writes
+        std::vector<bool> imageNeeded(images.size(), false);
+        std::vector<bool> bufferNeeded(buffers.size(), false);
+        for(size_t i = 0; i < images.size(); i++) imageNeeded[i] = images[i].exported;
+
+        for(auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            auto& pass = passes[*it];
+            bool needed = pass.sideEffects;
+            for(const auto& use : pass.images) needed = needed || (use.write && imageNeeded[use.image]);
+            for(const auto& use : pass.buffers) needed = needed || (use.write && bufferNeeded[use.buffer]);
+
+            pass.culled = !needed;
+            if(pass.culled) continue;
+            // earlier writers of what it writes are kept too, it may not overwrite everything
+            for(const auto& use : pass.images) imageNeeded[use.image] = true;
+            for(const auto& use : pass.buffers) bufferNeeded[use.buffer] = true;
+        }
+    }
+
+    void RenderGraph::computeLifetimes()
+    {
+        uint32_t position = 0;
+        for(uint32_t index : order)
+        {
+            const auto& pass = passes[index];
+            if(pass.culled) continue;
+            for(const auto& use : pass.images) {
+                auto& image = images[use.image];
+                image.firstUse = std::min(image.firstUse, position);
+                image.lastUse = std::max(image.lastUse, position);
+                image.usage |= usageForLayout(use.access.layout);
+            }
+            position++;
+        }
+    }
+
+    std::vector<uint64_t> RenderGraph::transientKey() const
+    {
+        std::vector<uint64_t> key;
+        for(const auto& image : images)
+        {
+            if(!image.transient || image.firstUse == UINT32_MAX) continue;
+            key.push_back(static_cast<uint64_t>(image.desc.extent.width) << 32 | image.desc.extent.height);
+            key.push_back(static_cast<uint64_t>(image.desc.format) << 32 | image.desc.aspect);
+            key.push_back(static_cast<uint64_t>(image.usage) << 32 | image.finalLayout);
+            key.push_back(static_cast<uint64_t>(image.firstUse) << 32 | image.lastUse);
+        }
+        return key;
+    }
+
+    void RenderGraph::allocateTransientImages(int frameIndex)
+    {
+        std::vector<uint32_t> used;
+        for(uint32_t i = 0; i < images.size(); i++) {
+            if(images[i].transient && images[i].firstUse != UINT32_MAX) used.push_back(i);
+        }
+
+        auto& allocation = transientAllocations[frameIndex];
+        auto key = transientKey();
+        if(key != allocation.key)
+        {
+            // the frame changed shape, e.g. a resize: new images, the old ones wait for the frames using them
+            releaseTransientImages(allocation);
+            allocation.key = std::move(key);
+
+            const VkDevice device = engineDevice.device();
+            std::vector<VkMemoryRequirements> requirements(used.size());
+            allocation.images.resize(used.size());
+            allocation.views.resize(used.size());
+            allocation.aliasedAfter.assign(used.size(), UINT32_MAX);
+            for(size_t i = 0; i < used.size(); i++)
+            {
+                const auto& image = images[used[i]];
+                VkImageCreateInfo imageInfo{};
+                imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                imageInfo.imageType = VK_IMAGE_TYPE_2D;
+                imageInfo.extent = {image.desc.extent.width, image.desc.extent.height, 1};
+                imageInfo.mipLevels = 1;
+                imageInfo.arrayLayers = 1;
+                imageInfo.format = image.desc.format;
+                imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+                imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                imageInfo.usage = image.usage | usageForLayout(image.finalLayout);
+                imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+                imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                if(vkCreateImage(device, &imageInfo, nullptr, &allocation.images[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create render graph image " + image.name + "!");
+                }
+                vkGetImageMemoryRequirements(device, allocation.images[i], &requirements[i]);
+                allocation.unaliasedBytes += requirements[i].size;
+            }
+
+            // biggest first, each image goes to the first memory block whose images are all dead
+            // before it starts or born after it ends; a block is as large as its largest image
+            struct Block {
+                VkDeviceSize size = 0;
+                VkDeviceSize alignment = 1;
+                uint32_t memoryTypeBits = ~0u;
+                std::vector<uint32_t> members{}; // positions in used
+            };
+            std::vector<uint32_t> bySize(used.size());
+            for(uint32_t i = 0; i < bySize.size(); i++) bySize[i] = i;
+            std::stable_sort(bySize.begin(), bySize.end(), [&](uint32_t a, uint32_t b) {
+                return requirements[a].size > requirements[b].size;
+            });
+
+            std::vector<Block> blocks;
+            for(uint32_t i : bySize)
+            {
+                const auto& image = images[used[i]];
+                Block* target = nullptr;
+                for(auto& block : blocks) {
+                    if((block.memoryTypeBits & requirements[i].memoryTypeBits) == 0) continue;
+                    const bool overlaps = std::any_of(block.members.begin(), block.members.end(), [&](uint32_t m) {
+                        const auto& other = images[used[m]];
+                        return image.firstUse <= other.lastUse && other.firstUse <= image.lastUse;
+                    });
+                    if(!overlaps) {
+                        target = &block;
+                        break;
+                    }
+                }
+                if(target == nullptr) {
+                    blocks.emplace_back();
+                    target = &blocks.back();
+                }
+                target->size = std::max(target->size, requirements[i].size);
+                target->alignment = std::max(target->alignment, requirements[i].alignment);
+                target->memoryTypeBits &= requirements[i].memoryTypeBits;
+                target->members.push_back(i);
+            }
+
+            for(const auto& block : blocks)
+            {
+                VkMemoryAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+                allocInfo.allocationSize = block.size;
+                allocInfo.memoryTypeIndex = engineDevice.findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                VkDeviceMemory memory;
+                if(vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate render graph memory!");
+                }
+                allocation.memory.push_back(memory);
+                allocation.bytes += block.size;
+
+                for(uint32_t member : block.members)
+                {
+                    vkBindImageMemory(device, allocation.images[member], memory, 0);
+
+                    // the image that last used the memory before this one starts, if any
+                    const auto& image = images[used[member]];
+                    uint32_t previousEnd = 0;
+                    for(uint32_t other : block.members) {
+                        const auto& candidate = images[used[other]];
+                        if(candidate.lastUse < image.firstUse && (allocation.aliasedAfter[member] == UINT32_MAX
+                            || candidate.lastUse >= previousEnd)) {
+                            allocation.aliasedAfter[member] = other;
+                            previousEnd = candidate.lastUse;
+                        }
+                    }
+                }
+            }
+
+            for(size_t i = 0; i < used.size(); i++)
+            {
+                const auto& image = images[used[i]];
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = allocation.images[i];
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = image.desc.format;
+                viewInfo.subresourceRange.aspectMask = image.desc.aspect;
+                viewInfo.subresourceRange.baseMipLevel = 0;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.baseArrayLayer = 0;
+                viewInfo.subresourceRange.layerCount = 1;
+                if(vkCreateImageView(device, &viewInfo, nullptr, &allocation.views[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create render graph image view!");
+                }
+            }
+        }
+
+        for(size_t i = 0; i < used.size(); i++)
+        {
+            auto& image = images[used[i]];
+            image.image = allocation.images[i];
+            image.view = allocation.views[i];
+            const uint32_t previous = allocation.aliasedAfter[i];
+            image.aliasedAfter = previous == UINT32_MAX ? UINT32_MAX : used[previous];
+        }
+    }
+
+    void RenderGraph::releaseTransientImages(TransientAllocation& allocation)
+    {
+        if(!allocation.images.empty() || !allocation.memory.empty())
+        {
+            engineDevice.retire([device = engineDevice.device(), images = allocation.images, views = allocation.views,
+                                 memory = allocation.memory]() {
+                for(auto view : views) vkDestroyImageView(device, view, nullptr);
+                for(auto image : images) vkDestroyImage(device, image, nullptr);
+                for(auto block : memory) vkFreeMemory(device, block, nullptr);
+            });
+        }
+        allocation = TransientAllocation{};
+    }
+
+    void RenderGraph::buildBarriers()
+    {
+        auto initialState = [](VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout) {
+            SyncState state{};
+            state.layout = layout;
+            // a previous read only orders later writes, a previous write has to be made visible as well
+            if(access & WRITE_ACCESS) {
+                state.writeStages = stages;
+                state.writeAccess = access & WRITE_ACCESS;
+            } else {
+                state.readStages = stages;
+            }
+            return state;
+        };
+
+        std::vector<SyncState> imageStates(images.size());
+        std::vector<SyncState> bufferStates(buffers.size());
+        for(size_t i = 0; i < images.size(); i++) {
+            // transient contents never survive a frame, the previous user of aliased memory is handled below
+            imageStates[i] = images[i].transient ? SyncState{}
+                : initialState(images[i].current.stages, images[i].current.access, images[i].current.layout);
+        }
+        for(size_t i = 0; i < buffers.size(); i++) {
+            bufferStates[i] = initialState(buffers[i].current.stages, buffers[i].current.access, VK_IMAGE_LAYOUT_UNDEFINED);
+        }
+
+        // Adds what use needs to the barrier in front of pass, updates the state. Returns true if
+        // the use has to wait for srcStages/srcAccess or change the layout
+        auto synchronize = [](SyncState& state, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout,
+            bool write, VkPipelineStageFlags& srcStages, VkAccessFlags& srcAccess) {
+            srcStages = 0;
+            srcAccess = 0;
+            const bool layoutChange = layout != state.layout;
+            if(write || layoutChange)
+            {
+                // write after write and write after read, a layout transition is a write as well
+                srcStages = state.writeStages | state.readStages;
+                srcAccess = state.writeAccess;
+                state.layout = layout;
+                state.writeStages = stages;
+                state.writeAccess = write ? access & WRITE_ACCESS : 0;
+                state.readStages = 0;
+                state.visibleStages = stages;
+                state.visibleAccess = access;
+                return srcStages != 0 || layoutChange;
+            }
+
+            state.readStages |= stages;
+            // read after write (or after a transition): once per stage and access, read after read needs nothing
+            if(state.writeStages != 0 && ((stages & ~state.visibleStages) != 0 || (access & ~state.visibleAccess) != 0))
+            {
+                srcStages = state.writeStages;
+                srcAccess = state.writeAccess;
+                state.visibleStages |= stages;
+                state.visibleAccess |= access;
+                return true;
+            }
+            return false;
+        };
+
+        auto imageBarrier = [](const ImageResource& image, VkImageLayout oldLayout, VkImageLayout newLayout,
+            VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image.image;
+            barrier.subresourceRange.aspectMask = image.desc.aspect;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+            return barrier;
+        };
+
+        std::vector<bool> imageTouched(images.size(), false);
+        for(uint32_t index : order)
+        {
+            auto& pass = passes[index];
+            pass.srcStages = 0;
+            pass.dstStages = 0;
+            pass.imageBarriers.clear();
+            pass.memoryBarrier = VkMemoryBarrier{};
+            pass.memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            if(pass.culled) continue;
+
+            for(const auto& use : pass.images)
+            {
+                auto& image = images[use.image];
+                auto& state = imageStates[use.image];
+                if(!imageTouched[use.image] && image.aliasedAfter != UINT32_MAX)
+                {
+                    // first use of aliased memory: the previous image in it has to be done, its writes included
+                    const auto& previous = imageStates[image.aliasedAfter];
+                    state.readStages = previous.writeStages | previous.readStages;
+                    state.writeAccess = previous.writeAccess;
+                }
+                imageTouched[use.image] = true;
+
+                const VkImageLayout oldLayout = state.layout;
+                VkPipelineStageFlags srcStages;
+                VkAccessFlags srcAccess;
+                if(!synchronize(state, use.access.stages, use.access.access, use.access.layout, use.write, srcStages, srcAccess))
+                    continue;
+                pass.srcStages |= srcStages;
+                pass.dstStages |= use.access.stages;
+                pass.imageBarriers.push_back(imageBarrier(image, oldLayout, use.access.layout, srcAccess, use.access.access));
+            }
+
+            for(const auto& use : pass.buffers)
+            {
+                VkPipelineStageFlags srcStages;
+                VkAccessFlags srcAccess;
+                if(!synchronize(bufferStates[use.buffer], use.access.stages, use.access.access, VK_IMAGE_LAYOUT_UNDEFINED,
+                    use.write, srcStages, srcAccess))
+                    continue;
+                // buffers share one global memory barrier, an execution dependency alone needs no access bits
+                pass.srcStages |= srcStages;
+                pass.dstStages |= use.access.stages;
+                if(srcAccess != 0) {
+                    pass.memoryBarrier.srcAccessMask |= srcAccess;
+                    pass.memoryBarrier.dstAccessMask |= use.access.access;
+                }
+            }
+        }
+
+        for(size_t i = 0; i < images.size(); i++)
+        {
+            const auto& image = images[i];
+            const auto& state = imageStates[i];
+            if(!image.exported || image.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || image.finalLayout == state.layout)
+                continue;
+            finalSrcStages |= state.writeStages | state.readStages;
+            finalBarriers.push_back(imageBarrier(image, state.layout, image.finalLayout, state.writeAccess, 0));
+        }
+    }
+
+    void RenderGraph::print(std::ostream& out) const
+    {
+        out << "Render graph:\n";
+        for(uint32_t index : order)
+        {
+            const auto& pass = passes[index];
+            out << "  " << pass.name;
+            if(pass.culled) {
+                out << " (culled)\n";
+                continue;
+            }
+            const bool barrier = pass.srcStages != 0 || !pass.imageBarriers.empty();
+            out << ": " << (barrier ? 1 : 0) << " barrier, " << pass.imageBarriers.size() << " image transitions"
+                << (pass.memoryBarrier.srcAccessMask != 0 ? ", buffer memory" : "") << '\n';
+        }
+        for(const auto& image : images)
+        {
+            if(!image.transient || image.firstUse == UINT32_MAX) continue;
+            out << "  transient " << image.name << ": passes " << image.firstUse << '-' << image.lastUse;
+            if(image.aliasedAfter != UINT32_MAX) out << ", aliases " << images[image.aliasedAfter].name;
+            out << '\n';
+        }
+    }
+
+    VkDeviceSize RenderGraph::getTransientMemorySize(int frameIndex) const
+    {
+        return transientAllocations[frameIndex].bytes;
+    }
+
+    VkDeviceSize RenderGraph::getUnaliasedTransientMemorySize(int frameIndex) const
+    {
+        return transientAllocations[frameIndex].unaliasedBytes;
+    }
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "engine_device.hpp"
+
+namespace Cosmos {
+
+    /*
+    Frame graph rebuilt every frame: passes declare which images and buffers they read and write,
+    the graph then
+    - orders the passes by the order they were added in: a pass reading a resource runs after the last
+      pass added before it that writes it, and before the next one that does. Adding W1, R, W2 on the
+      same resource lets R see what W1 wrote,
+    - culls passes whose results nobody reads (exported resources and side effects count as read),
+    - records one vkCmdPipelineBarrier before each pass with the layout transitions and the memory
+      dependencies its accesses need, nothing for read after read,
+    - places transient images whose lifetimes don't overlap in the same device memory.
+    Passes record their own commands, render passes included, the graph only synchronizes between them.
+    Transient images stay allocated per frame slot for as long as the frames keep the same shape.
+    */
+    class RenderGraph {
+    public:
+        struct ImageHandle {
+            uint32_t index = UINT32_MAX;
+            bool valid() const { return index != UINT32_MAX; }
+        };
+        struct BufferHandle {
+            uint32_t index = UINT32_MAX;
+            bool valid() const { return index != UINT32_MAX; }
+        };
+
+        // Stages and accesses of one use, for an imported resource the last use before the graph
+        struct ImageAccess {
+            VkPipelineStageFlags stages = 0; // 0: not used before
+            VkAccessFlags access = 0;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        };
+        struct BufferAccess {
+            VkPipelineStageFlags stages = 0; // 0: not used before
+            VkAccessFlags access = 0;
+        };
+
+        static constexpr ImageAccess COLOR_ATTACHMENT{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        static constexpr ImageAccess DEPTH_ATTACHMENT{
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+        static constexpr ImageAccess FRAGMENT_SAMPLED{VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        static constexpr ImageAccess COMPUTE_SAMPLED{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        static constexpr ImageAccess COMPUTE_IMAGE_WRITE{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+        static constexpr BufferAccess COMPUTE_BUFFER_READ{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT};
+        static constexpr BufferAccess COMPUTE_BUFFER_WRITE{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT};
+        static constexpr BufferAccess INDIRECT_DRAW{
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT};
+
+        // Transient image, the usage follows from the accesses declared on it
+        struct ImageDesc {
+            VkExtent2D extent{};
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        };
+
+        // One access per resource and pass, a pass reading and writing something declares the write with both accesses
+        class PassBuilder {
+        public:
+            void read(ImageHandle image, const ImageAccess& access);
+            void write(ImageHandle image, const ImageAccess& access);
+            void read(BufferHandle buffer, const BufferAccess& access);
+            void write(BufferHandle buffer, const BufferAccess& access);
+            // Kept even if nothing reads what it writes (uploads, readbacks)
+            void setSideEffects();
+
+        private:
+            friend class RenderGraph;
+            PassBuilder(RenderGraph& graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+            RenderGraph& graph;
+            const uint32_t pass;
+        };
+
+        // What the execute function of a pass can look up
+        class PassResources {
+        public:
+            VkImage getImage(ImageHandle image) const;
+            VkImageView getImageView(ImageHandle image) const;
+            VkExtent2D getExtent(ImageHandle image) const;
+            VkBuffer getBuffer(BufferHandle buffer) const;
+
+        private:
+            friend class RenderGraph;
+            explicit PassResources(const RenderGraph& graph) : graph{graph} {}
+
+            const RenderGraph& graph;
+        };
+
+        using SetupFunction = std::function<void(PassBuilder& builder)>;
+        using ExecuteFunction = std::function<void(VkCommandBuffer commandBuffer, const PassResources& resources)>;
+
+        RenderGraph(EngineDevice& device, uint32_t framesInFlight);
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // Drops the passes and resources of the previous frame, handles of it are invalid afterwards
+        void reset();
+
+        // current: the last use before this frame, layout UNDEFINED discards the contents
+        ImageHandle importImage(const std::string& name, VkImage image, VkImageView view, VkExtent2D extent,
+            VkImageAspectFlags aspect, const ImageAccess& current);
+        // buffer may be VK_NULL_HANDLE, buffers are synchronized with global memory barriers
+        BufferHandle importBuffer(const std::string& name, VkBuffer buffer);
+        BufferHandle importBuffer(const std::string& name, VkBuffer buffer, const BufferAccess& current);
+        ImageHandle createImage(const std::string& name, const ImageDesc& desc);
+        // Passes writing it are never culled, after the last pass the image is transitioned to finalLayout
+        void exportImage(ImageHandle image, VkImageLayout finalLayout);
+
+        void addPass(const std::string& name, const SetupFunction& setup, ExecuteFunction execute);
+
+        // Compiles and records all passes, frameIndex selects the transient images
+        void execute(VkCommandBuffer commandBuffer, int frameIndex);
+
+        // Order, culled passes and barriers of the last execute
+        void print(std::ostream& out) const;
+        // Device memory of this frame slot's transient images, and what they would take without aliasing
+        VkDeviceSize getTransientMemorySize(int frameIndex) const;
+        VkDeviceSize getUnaliasedTransientMemorySize(int frameIndex) const;
+
+    private:
+        struct ImageResource {
+            std::string name;
+            bool transient = false;
+            ImageDesc desc{};
+            VkImageUsageFlags usage = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            ImageAccess current{};
+            bool exported = false;
+            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // compile results
+            uint32_t firstUse = UINT32_MAX; // positions in the execution order
+            uint32_t lastUse = 0;
+            uint32_t aliasedAfter = UINT32_MAX; // transient image that used the memory before this one
+        };
+
+        struct BufferResource {
+            std::string name;
+            VkBuffer buffer = VK_NULL_HANDLE;
+            BufferAccess current{};
+        };
+
+        struct ImageUse {
+            uint32_t image;
+            ImageAccess access;
+            bool write;
+        };
+        struct BufferUse {
+            uint32_t buffer;
+            BufferAccess access;
+            bool write;
+        };
+
+        struct Pass {
+            std::string name;
+            ExecuteFunction execute;
+            std::vector<ImageUse> images{};
+            std::vector<BufferUse> buffers{};
+            bool sideEffects = false;
+            bool culled = false;
+            // the barrier recorded before it
+            VkPipelineStageFlags srcStages = 0;
+            VkPipelineStageFlags dstStages = 0;
+            std::vector<VkImageMemoryBarrier> imageBarriers{};
+            VkMemoryBarrier memoryBarrier{};
+        };
+
+        // Synchronization state of one resource while the passes are walked in order
+        struct SyncState {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags writeStages = 0; // last write or layout transition
+            VkAccessFlags writeAccess = 0;
+            VkPipelineStageFlags readStages = 0;  // reads since then
+            VkPipelineStageFlags visibleStages = 0; // stages the last write is already available to
+            VkAccessFlags visibleAccess = 0;
+        };
+
+        // Transient images of one frame slot, rebuilt when the frame's transient images change
+        struct TransientAllocation {
+            std::vector<uint64_t> key{};
+            std::vector<VkImage> images{};
+            std::vector<VkImageView> views{};
+            std::vector<VkDeviceMemory> memory{};
+            std::vector<uint32_t> aliasedAfter{};
+            VkDeviceSize bytes = 0;
+            VkDeviceSize unaliasedBytes = 0;
+        };
+
+        void compile(int frameIndex);
+        void sortPasses();
+        void cullPasses();
+        void computeLifetimes();
+        void allocateTransientImages(int frameIndex);
+        void buildBarriers();
+        std::vector<uint64_t> transientKey() const;
+        void releaseTransientImages(TransientAllocation& allocation);
+
+        EngineDevice& engineDevice;
+
+        std::vector<ImageResource> images{};
+        std::vector<BufferResource> buffers{};
+        std::vector<Pass> passes{};
+        std::vector<uint32_t> order{}; // pass indices, culled ones included
+        std::vector<VkImageMemoryBarrier> finalBarriers{};
+        VkPipelineStageFlags finalSrcStages = 0;
+
+        std::vector<TransientAllocation> transientAllocations; // per frame slot
+    };
+}
@@ -0,0 +1,145 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace Cosmos {
+
+    namespace {
+
+        constexpr unsigned DEPTH_BITS = 20;
+        constexpr unsigned STATE_BITS = 40; // pipeline 8, material 16, mesh 16
+        constexpr uint64_t DEPTH_MASK = (uint64_t{1} << DEPTH_BITS) - 1;
+        constexpr unsigned RADIX = 256;
+
+        // The radix passes of all threads advance together, C++17 has no std::barrier
+        class Barrier {
+        public:
+            explicit Barrier(unsigned count) : count{count} {}
+
+            void arriveAndWait()
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                const uint64_t arrivedIn = generation;
+                if(++arrived == count)
+                {
+                    arrived = 0;
+                    generation++;
+                    condition.notify_all();
+                    return;
+                }
+                condition.wait(lock, [&]() { return generation != arrivedIn; });
+            }
+
+        private:
+            const unsigned count;
+            std::mutex mutex;
+            std::condition_variable condition;
+            unsigned arrived = 0;
+            uint64_t generation = 0;
+        };
+    }
+
+    RenderQueue::RenderQueue(unsigned threadCount)
+        : threadCount{std::max(threadCount == 0 ? std::thread::hardware_concurrency() : threadCount, 1u)}
+    {
+    }
+
+    uint32_t RenderQueue::quantizeDepth(float depth)
+    {
+        // non negative floats compare like their bit patterns, negative depths and NaN count as 0
+        if(!(depth > 0.f)) return 0;
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - 1 - DEPTH_BITS); // the sign bit is 0
+    }
+
+    uint64_t RenderQueue::makeKey(Pass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+    {
+        const uint64_t passBits = static_cast<uint64_t>(pass) & 0xF;
+        const uint64_t state = static_cast<uint64_t>(pipeline & 0xFF) << 32
+            | static_cast<uint64_t>(material & 0xFFFF) << 16
+            | static_cast<uint64_t>(mesh & 0xFFFF);
+        const uint64_t quantized = quantizeDepth(depth);
+
+        if(pass == Pass::Transparent)
+        {
+            // inverted, the farthest draw gets the smallest key
+            return passBits << 60 | (quantized ^ DEPTH_MASK) << STATE_BITS | state;
+        }
+        return passBits << 60 | state << DEPTH_BITS | quantized;
+    }
+
+    /*
+    Least significant byte first, each pass is a stable counting sort. Every thread histograms and scatters
+    its own contiguous range; it writes a digit after all smaller digits and after the same digit of the
+    threads before it, so the order of equal keys survives. Bytes equal in all keys are skipped, with a
+    single pass and pipeline that is most of the upper half.
+    */
+    void RenderQueue::sort()
+    {
+        const size_t count = draws.size();
+        if(count < 2) return;
+
+        uint64_t varying = 0;
+        for(const auto& draw : draws) varying |= draw.key ^ draws[0].key;
+        unsigned shifts[8];
+        unsigned passCount = 0;
+        for(unsigned shift = 0; shift < 64; shift += 8)
+        {
+            if((varying >> shift) & (RADIX - 1)) shifts[passCount++] = shift;
+        }
+        if(passCount == 0) return;
+
+        const unsigned threads = count < PARALLEL_THRESHOLD ? 1 : threadCount;
+        scratch.resize(count);
+        histograms.resize(static_cast<size_t>(threads) * RADIX);
+        Barrier barrier{threads};
+
+        auto worker = [&](unsigned thread) {
+            const size_t begin = count * thread / threads;
+            const size_t end = count * (thread + 1) / threads;
+            uint32_t* histogram = &histograms[static_cast<size_t>(thread) * RADIX];
+            Draw* source = draws.data();
+            Draw* destination = scratch.data();
+
+            for(unsigned pass = 0; pass < passCount; pass++)
+            {
+                const unsigned shift = shifts[pass];
+                std::fill(histogram, histogram + RADIX, 0u);
+                for(size_t i = begin; i < end; i++) histogram[(source[i].key >> shift) & (RADIX - 1)]++;
+                barrier.arriveAndWait();
+
+                uint32_t offsets[RADIX];
+                uint32_t offset = 0;
+                for(unsigned digit = 0; digit < RADIX; digit++)
+                {
+                    for(unsigned other = 0; other < threads; other++)
+                    {
+                        if(other == thread) offsets[digit] = offset;
+                        offset += histograms[static_cast<size_t>(other) * RADIX + digit];
+                    }
+                }
+                for(size_t i = begin; i < end; i++)
+                {
+                    destination[offsets[(source[i].key >> shift) & (RADIX - 1)]++] = source[i];
+                }
+                // the next pass reads what the others scattered, and overwrites the histograms just read
+                barrier.arriveAndWait();
+                std::swap(source, destination);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned thread = 1; thread < threads; thread++) workers.emplace_back(worker, thread);
+        worker(0);
+        for(auto& thread : workers) thread.join();
+
+        // an odd number of passes ended in the scratch buffer
+        if(passCount % 2 == 1) draws.swap(scratch);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cosmos {
+
+    /*
+    Draws of one frame as 64 bit sort keys, sorted with an LSD radix sort. Bits from the top:
+    - opaque:      pass 4 | pipeline 8 | material 16 | mesh 16 | depth 20, front to back
+    - transparent: pass 4 | depth 20 | pipeline 8 | material 16 | mesh 16, back to front
+    Opaque draws are grouped by state first, depth only orders draws sharing all of it. Transparent
+    draws must blend in depth order, state only breaks ties. Fields wider than their bits are masked,
+    which merges groups but never breaks the depth order.
+    Draws with equal keys keep the order they were added in, nothing is dropped.
+    */
+    class RenderQueue {
+    public:
+        // radix passes are worth threads only for many draws
+        static constexpr size_t PARALLEL_THRESHOLD = 1 << 15;
+
+        enum class Pass : uint32_t {
+            Opaque = 0,
+            Transparent = 1,
+        };
+
+        struct Draw {
+            uint64_t key;
+            uint32_t item; // caller's index, e.g. into FrameInfo::objects
+        };
+
+        // threadCount 0 uses the hardware concurrency, queues below PARALLEL_THRESHOLD are sorted on this thread
+        explicit RenderQueue(unsigned threadCount = 0);
+
+        // Keeps the storage for the next frame
+        void clear() { draws.clear(); }
+        // depth: any non negative measure growing with the distance to the camera, e.g. the squared distance
+        void add(Pass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth, uint32_t item) {
+            draws.push_back({makeKey(pass, pipeline, material, mesh, depth), item});
+        }
+        void sort();
+
+        const std::vector<Draw>& getDraws() const { return draws; }
+        size_t size() const { return draws.size(); }
+
+        static uint64_t makeKey(Pass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+        // 20 bits keeping the order of non negative floats: exponent and the top mantissa bits
+        static uint32_t quantizeDepth(float depth);
+
+    private:
+        const unsigned threadCount;
+        std::vector<Draw> draws{};
+        std::vector<Draw> scratch{}; // the other buffer of each radix pass
+        std::vector<uint32_t> histograms{}; // one digit histogram per sorting thread
+    };
+}
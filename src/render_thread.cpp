@@ -0,0 +1,91 @@
+#include "render_thread.hpp"
+
+#include <utility>
+
+namespace Cosmos {
+
+    RenderThread::RenderThread(RenderFunction renderFunction) : renderFunction{std::move(renderFunction)}
+    {
+        thread = std::thread(&RenderThread::run, this);
+    }
+
+    RenderThread::~RenderThread()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            running = false;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    FramePacket RenderThread::acquirePacket()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        FramePacket packet{};
+        packet.objects = std::move(recycled.objects);
+        packet.objects.clear();
+        return packet;
+    }
+
+    void RenderThread::submit(FramePacket&& packet)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this]() { return !hasPending || error; });
+        rethrowError();
+        pending = std::move(packet);
+        hasPending = true;
+        lock.unlock();
+        condition.notify_all();
+    }
+
+    void RenderThread::waitIdle()
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this]() { return (!hasPending && !rendering) || error; });
+        rethrowError();
+    }
+
+    void RenderThread::rethrowError()
+    {
+        // stays set, the thread is gone and every later call has to fail as well
+        if(error) std::rethrow_exception(error);
+    }
+
+    void RenderThread::run()
+    {
+        FramePacket packet{};
+        std::unique_lock<std::mutex> lock{mutex};
+        while(true)
+        {
+            // pending packets are still recorded on shutdown, the owner waits for the device afterwards
+            condition.wait(lock, [this]() { return hasPending || !running; });
+            if(!hasPending) break;
+
+            packet = std::move(pending);
+            hasPending = false;
+            rendering = true;
+            lock.unlock();
+            // the main thread may fill the mailbox again while this frame is recorded
+            condition.notify_all();
+
+            std::exception_ptr thrown{};
+            try {
+                renderFunction(packet);
+            } catch(...) {
+                thrown = std::current_exception();
+            }
+
+            lock.lock();
+            rendering = false;
+            recycled = std::move(packet);
+            if(thrown) {
+                error = thrown;
+                hasPending = false;
+                condition.notify_all();
+                break;
+            }
+            condition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "frame_info.hpp"
+
+namespace Cosmos {
+
+    /*
+    Records and submits frames on a dedicated thread. The main thread builds the FramePacket of
+    frame N+1 while frame N is recorded here, a CPU frame costs max(update, render) instead of both.
+    The mailbox holds a single packet: submit only blocks while the previous packet has not been
+    picked up, so the main thread never runs more than one frame ahead of the render thread, and
+    the render thread itself waits for its frame slot inside Renderer::beginFrame.
+    An exception thrown by the render function stops the thread and is rethrown by every following
+    submit or waitIdle on the main thread.
+    */
+    class RenderThread {
+    public:
+        using RenderFunction = std::function<void(FramePacket& packet)>;
+
+        explicit RenderThread(RenderFunction renderFunction);
+        ~RenderThread();
+
+        RenderThread(const RenderThread&) = delete;
+        RenderThread& operator=(const RenderThread&) = delete;
+
+        // Empty packet reusing the storage of a recorded one, avoids reallocating the object list every frame
+        FramePacket acquirePacket();
+        // Hands the packet over, waits while the mailbox is still full
+        void submit(FramePacket&& packet);
+        // Returns once every submitted packet has been recorded and submitted
+        void waitIdle();
+
+    private:
+        void run();
+        void rethrowError();
+
+        const RenderFunction renderFunction;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        FramePacket pending{};
+        bool hasPending = false;
+        bool rendering = false;
+        FramePacket recycled{}; // last recorded packet, its vector capacity is handed back by acquirePacket
+        std::exception_ptr error{};
+        bool running = true;
+
+        std::thread thread{}; // last, it starts once everything else is initialized
+    };
+}
@@ -4,10 +4,16 @@
 #include <array>
 
 #include <iostream>
+#include <thread>
+#include <chrono>
 
 namespace Cosmos {
 
-    Renderer::Renderer(Window& window, EngineDevice& device) : window{window}, engineDevice{device}
+    Renderer::Renderer(Window& window, EngineDevice& device)
+        : Renderer{window, device, EngineSwapChain::Settings{}} {}
+
+    Renderer::Renderer(Window& window, EngineDevice& device, const EngineSwapChain::Settings& settings)
+        : window{window}, engineDevice{device}, settings{settings}
     {
         recreateSwapChain();
         createCommandBuffers();
@@ -21,19 +27,41 @@ namespace Cosmos {
     VkCommandBuffer Renderer::beginFrame()
     {
         assert(!isFrameStarted && "Cant call beginFrame while already in progress");
+        if(swapChainOutdated)
+        {
+            recreateSwapChain();
+            if(swapChainOutdated)
+            {
+                // minimized, nothing to draw until the window has an area again
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                return nullptr;
+            }
+        }
+
         auto result = engineSwapChain->acquireNextImage(&currentImageIndex);
-        // surface has changed in such a way that it is no longer compatible with the swapchain
+        // surface has changed in such a way that it is no longer compatible with the swapchain,
+        // recreating doesn't wait for the device, so this frame is still drawn into the new one
         if (result == VK_ERROR_OUT_OF_DATE_KHR) 
         {
             recreateSwapChain();
-            return nullptr;
+            if(swapChainOutdated) return nullptr;
+            result = engineSwapChain->acquireNextImage(&currentImageIndex);
+            if(result == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                swapChainOutdated = true;
+                return nullptr;
+            }
         }
+        lastFrameTimestamps.acquire = FrameTimestamps::Clock::now();
 
         if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         {
             throw std::runtime_error("failed to acquire swap chain image!");
         }
 
+        // acquiring waited for this frame slot, the GPU may have passed more retired objects meanwhile
+        engineDevice.collectRetired();
+
         isFrameStarted = true;
         auto commandBuffer = getCurrentCommandBuffer();
         
@@ -57,7 +85,11 @@ namespace Cosmos {
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        auto result  = engineSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        lastFrameTimestamps.submit = FrameTimestamps::Clock::now();
+        lastFrameTimestamps.swapChainGeneration = swapChainGeneration;
+        auto result  = engineSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex,
+            &lastFrameTimestamps.presentId);
+        lastFrameTimestamps.present = FrameTimestamps::Clock::now();
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasWindowResized())
         {
@@ -69,7 +101,31 @@ namespace Cosmos {
             throw std::runtime_error("failed to present swap chain image!");
         }
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % EngineSwapChain::MAX_FRAMES_IN_FLIGHT;
+        currentFrameIndex = (currentFrameIndex + 1) % settings.framesInFlight;
+    }
+
+    bool Renderer::waitForPresent(uint64_t generation, uint64_t presentId, uint64_t timeout)
+    {
+        std::shared_ptr<EngineSwapChain> swapChain;
+        {
+            std::lock_guard<std::mutex> lock{presentWaitMutex};
+            if(presentId == 0 || generation != swapChainGeneration || engineSwapChain == nullptr)
+                return false;
+            swapChain = engineSwapChain;
+        }
+        // without the lock, recreation never waits behind a present wait. The reference keeps a replaced
+        // swap chain alive until the wait returned, its destructor then retires it from this thread
+        return swapChain->waitForPresent(presentId, timeout) == VK_SUCCESS;
+    }
+
+    RenderTarget Renderer::getSwapChainRenderTarget() const
+    {
+        // recreation throws if a format changes, the render pass is only replaced by a compatible one
+        RenderTarget target{};
+        target.renderPass = engineSwapChain->getRenderPass();
+        target.colorFormats = {engineSwapChain->getSwapChainImageFormat()};
+        target.depthFormat = engineSwapChain->getSwapChainDepthFormat();
+        return target;
     }
 
     void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -78,21 +134,54 @@ namespace Cosmos {
         assert(commandBuffer == getCurrentCommandBuffer() 
         && "Cant begin render pass on command buffer from a different frame");
 
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = engineSwapChain->getRenderPass();
-        renderPassInfo.framebuffer = engineSwapChain->getFrameBuffer(currentImageIndex);
-
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = engineSwapChain->getSwapChainExtent();
-
         std::array<VkClearValue, 2> clearValues{};
         clearValues[0].color = {0.1f, 0.1f, 0.1f, 1.0f};
         clearValues[1].depthStencil = {1.0f, 0}; // 0, not 0.0f
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-        
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        if(engineSwapChain->usesDynamicRendering())
+        {
+            // same loads and stores as the render pass, the attachments are already in their layouts
+            VkRenderingAttachmentInfoKHR colorAttachment{};
+            colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            colorAttachment.imageView = engineSwapChain->getImageView(currentImageIndex);
+            colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.clearValue = clearValues[0];
+
+            VkRenderingAttachmentInfoKHR depthAttachment{};
+            depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            depthAttachment.imageView = engineSwapChain->getDepthImageView(currentImageIndex);
+            depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.clearValue = clearValues[1];
+
+            VkRenderingInfoKHR renderingInfo{};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+            renderingInfo.renderArea.offset = {0, 0};
+            renderingInfo.renderArea.extent = engineSwapChain->getSwapChainExtent();
+            renderingInfo.layerCount = 1;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachments = &colorAttachment;
+            renderingInfo.pDepthAttachment = &depthAttachment;
+            engineDevice.cmdBeginRendering(commandBuffer, renderingInfo);
+        }
+        else
+        {
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = engineSwapChain->getRenderPass();
+            renderPassInfo.framebuffer = engineSwapChain->getFrameBuffer(currentImageIndex);
+
+            renderPassInfo.renderArea.offset = {0, 0};
+            renderPassInfo.renderArea.extent = engineSwapChain->getSwapChainExtent();
+
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassInfo.pClearValues = clearValues.data();
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        }
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -113,13 +202,20 @@ namespace Cosmos {
         assert(commandBuffer == getCurrentCommandBuffer() 
         && "Cant end render pass on command buffer from a different frame");
 
-        vkCmdEndRenderPass(commandBuffer);
+        if(engineSwapChain->usesDynamicRendering())
+        {
+            engineDevice.cmdEndRendering(commandBuffer);
+        }
+        else
+        {
+            vkCmdEndRenderPass(commandBuffer);
+        }
     }
 
     // Allocates command buffer
     void Renderer::createCommandBuffers()
     {
-        commandBuffers.resize(EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        commandBuffers.resize(settings.framesInFlight);
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -146,29 +242,36 @@ namespace Cosmos {
 
     void Renderer::recreateSwapChain()
     {
+        // may run on the render thread, which can't wait for window events: a minimized window
+        // only marks the swap chain outdated and beginFrame tries again
         auto _extent = window.getExtent();
-        while(_extent.width == 0 || _extent.height == 0)
+        swapChainOutdated = _extent.width == 0 || _extent.height == 0;
+        if(swapChainOutdated && engineSwapChain != nullptr)
         {
-            glfwWaitEvents();
-            _extent = window.getExtent();
+            return;
         }
-        vkDeviceWaitIdle(engineDevice.device());
 
+        // no vkDeviceWaitIdle: frames in flight keep running, the old swap chain retires what the new one
+        // doesn't take over (see EngineSwapChain) once the last reference to it is gone
+        std::shared_ptr<EngineSwapChain> newSwapChain;
         //engineSwapChain.reset(); // can fix VK_ERROR_OUT_OF_HOST_MEMORY
         // Fixing memory management 
         if(engineSwapChain == nullptr) 
         {
-            engineSwapChain = std::make_unique<EngineSwapChain>(engineDevice, _extent);
+            newSwapChain = std::make_shared<EngineSwapChain>(engineDevice, _extent, settings);
         }
         else
         {
-            std::shared_ptr<EngineSwapChain> oldSwapChain = std::move(engineSwapChain);
-            engineSwapChain = std::make_unique<EngineSwapChain>(engineDevice, _extent, oldSwapChain);
-            if(!oldSwapChain->compareSwapFormats(*engineSwapChain.get()))
+            newSwapChain = std::make_shared<EngineSwapChain>(engineDevice, _extent, settings, engineSwapChain);
+            if(!engineSwapChain->compareSwapFormats(*newSwapChain))
             {
                 throw std::runtime_error("Swap chain image (or depth) format has changed!");
             }
         }
 
+        // only the swap over is guarded, waitForPresent copies the pointer and waits without the lock
+        std::lock_guard<std::mutex> lock{presentWaitMutex};
+        engineSwapChain = std::move(newSwapChain);
+        swapChainGeneration++;
     }
 }
\ No newline at end of file
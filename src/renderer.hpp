@@ -3,11 +3,14 @@
 #include <vector>
 #include <memory>
 #include <cassert>
+#include <mutex>
 
 #include "window.hpp"
 #include "engine_swap_chain.hpp"
 #include "engine_device.hpp"
 #include "model.hpp"
+#include "pipeline.hpp"
+#include "frame_pacer.hpp"
 
 namespace Cosmos {
 
@@ -16,6 +19,7 @@ namespace Cosmos {
     public:
 
         Renderer(Window& window, EngineDevice& device);
+        Renderer(Window& window, EngineDevice& device, const EngineSwapChain::Settings& settings);
         ~Renderer();
 
         Renderer(const Renderer&) = delete;
@@ -27,14 +31,30 @@ namespace Cosmos {
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
         VkRenderPass getSwapChainRenderPass() const {return engineSwapChain->getRenderPass(); }
+        // For pipelines drawing between begin- and endSwapChainRenderPass, stays valid across recreations
+        RenderTarget getSwapChainRenderTarget() const;
         float getAspectRatio() const {return engineSwapChain->extentAspectRatio();}
+        VkExtent2D getSwapChainExtent() const {return engineSwapChain->getSwapChainExtent();}
+        // Attachments of the current frame, they enter the render graph in UNDEFINED layout
+        VkImage getSwapChainImage() const {return engineSwapChain->getImage(currentImageIndex);}
+        VkImageView getSwapChainImageView() const {return engineSwapChain->getImageView(currentImageIndex);}
+        VkImage getDepthImage() const {return engineSwapChain->getDepthImage(currentImageIndex);}
+        VkImageView getDepthImageView() const {return engineSwapChain->getDepthImageView(currentImageIndex);}
         bool isFrameInProgress() const {return isFrameStarted;}
+        // every per frame resource is sized by this, frame indices are below it
+        uint32_t getFramesInFlight() const {return settings.framesInFlight;}
 
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "Renderer -> isFrameInProgress(): Cannot get command buffer when frame not in progress");
             return commandBuffers[currentFrameIndex];
         }
 
+        // acquire, submit and present of the last frame ended, for the FramePacer
+        const FrameTimestamps& getLastFrameTimestamps() const {return lastFrameTimestamps;}
+        // Any thread: blocks until that present reached the display, false without present wait, on timeout
+        // or when the swap chain has been replaced since. Never holds off swap chain recreation
+        bool waitForPresent(uint64_t swapChainGeneration, uint64_t presentId, uint64_t timeout);
+
         int getFrameIndex() const {
             assert(isFrameStarted && "Cant call beginSwapChainRenderPass while already in progress");
             return currentFrameIndex;
@@ -47,12 +67,18 @@ namespace Cosmos {
 
         Window& window;
         EngineDevice& engineDevice;
-        std::unique_ptr<EngineSwapChain> engineSwapChain;
+        const EngineSwapChain::Settings settings;
+        std::shared_ptr<EngineSwapChain> engineSwapChain; // shared with waitForPresent while it waits
         std::vector<VkCommandBuffer> commandBuffers;
 
         uint32_t currentImageIndex;
         int currentFrameIndex = 0;
         bool isFrameStarted = false;
+        bool swapChainOutdated = false; // window had no area when it was last recreated
+
+        FrameTimestamps lastFrameTimestamps{};
+        std::mutex presentWaitMutex; // guards replacing engineSwapChain against waitForPresent copying it
+        uint64_t swapChainGeneration = 0;
     };
 
 } 
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "scene_file.hpp"
+
+#include "asset_archive.hpp"
+#include "obj_parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Cosmos {
+
+    namespace {
+
+        // Whitespace separated words of one line, comments stripped
+        class LineTokens {
+        public:
+            LineTokens(const char* begin, const char* end, const std::string& location) : location{location}
+            {
+                const char* p = begin;
+                while(p < end) {
+                    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+                    if(p == end || *p == '#') break;
+                    const char* wordBegin = p;
+                    while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') p++;
+                    words.emplace_back(wordBegin, p - wordBegin);
+                }
+            }
+
+            bool empty() const { return words.empty(); }
+            bool done() const { return next == words.size(); }
+
+            const std::string& word()
+            {
+                if(done()) fail("unexpected end of line");
+                return words[next++];
+            }
+
+            float number()
+            {
+                const std::string& text = word();
+                float value = 0.f;
+                if(!parseNumber(text, value)) fail("expected a number, got '" + text + "'");
+                return value;
+            }
+
+            // decimal digits only, below limit
+            uint32_t index(uint32_t limit)
+            {
+                const std::string& text = word();
+                uint64_t value = 0;
+                bool valid = !text.empty() && text.size() <= 10;
+                for(size_t i = 0; valid && i < text.size(); i++) {
+                    valid = text[i] >= '0' && text[i] <= '9';
+                    value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+                }
+                if(!valid || value >= limit) {
+                    fail("expected an integer below " + std::to_string(limit) + ", got '" + text + "'");
+                }
+                return static_cast<uint32_t>(value);
+            }
+
+            bool nextIsNumber() const
+            {
+                float value;
+                return !done() && parseNumber(words[next], value);
+            }
+
+            void numbers(float* values, int count)
+            {
+                for(int i = 0; i < count; i++) values[i] = number();
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::runtime_error(location + ": " + message);
+            }
+
+        private:
+            static bool parseNumber(const std::string& text, float& value)
+            {
+                return ObjParser::parseFloat(text.data(), text.data() + text.size(), value) == text.data() + text.size();
+            }
+
+            std::string location;
+            std::vector<std::string> words{};
+            size_t next = 0;
+        };
+
+        constexpr float DEGREES_TO_RADIANS = 3.14159265358979f / 180.f;
+
+        // not an error, a streamed scene can spread many lights out. Only the nearest shade each frame
+        void warnAboutLightCount(const SceneFile& scene, const std::string& filepath)
+        {
+            const auto lights = static_cast<size_t>(std::count_if(scene.entities.begin(), scene.entities.end(),
+                [](const SceneEntity& entity) { return (entity.flags & SceneEntity::POINT_LIGHT) != 0; }));
+            if(lights > SceneEntity::MAX_SHADING_LIGHTS) {
+                std::cerr << filepath << ": " << lights << " point lights, only the nearest "
+                          << SceneEntity::MAX_SHADING_LIGHTS << " light each frame\n";
+            }
+        }
+
+        void parseModel(LineTokens& tokens, SceneModel& model)
+        {
+            model.path = tokens.word();
+            while(!tokens.done()) {
+                const std::string option = tokens.word();
+                const size_t separator = option.find('=');
+                const std::string key = option.substr(0, separator);
+                const std::string value = separator == std::string::npos ? "" : option.substr(separator + 1);
+                if(key == "format" && (value == "standard" || value == "compact")) {
+                    model.vertexFormat = value == "compact" ? SceneVertexFormat::Compact : SceneVertexFormat::Standard;
+                } else if(key == "lods" && !value.empty() && value.find_first_not_of("0123456789") == std::string::npos) {
+                    model.lodCount = std::max(1, std::stoi(value));
+                } else if(key == "culling" && (value == "none" || value == "frustum" || value == "cone")) {
+                    model.meshletCulling = value != "none";
+                    model.meshletBackfaceCulling = value == "cone";
+                } else {
+                    tokens.fail("unknown model option '" + option + "'");
+                }
+            }
+        }
+
+        void parseEntity(LineTokens& tokens, SceneEntity& entity)
+        {
+            while(!tokens.done()) {
+                const std::string property = tokens.word();
+                if(property == "position") {
+                    tokens.numbers(entity.translation, 3);
+                } else if(property == "rotation") {
+                    tokens.numbers(entity.rotation, 3);
+                    for(float& angle : entity.rotation) angle *= DEGREES_TO_RADIANS;
+                } else if(property == "scale") {
+                    entity.scale[0] = tokens.number();
+                    // uniform unless three values follow
+                    if(tokens.nextIsNumber()) {
+                        tokens.numbers(entity.scale + 1, 2);
+                    } else {
+                        entity.scale[1] = entity.scale[2] = entity.scale[0];
+                    }
+                } else if(property == "color") {
+                    tokens.numbers(entity.color, 3);
+                } else if(property == "material" && !entity.flags) {
+                    entity.materialIndex = tokens.index(SceneEntity::MAX_MATERIALS);
+                } else if(property == "intensity" && entity.flags & SceneEntity::POINT_LIGHT) {
+                    entity.lightIntensity = tokens.number();
+                } else if(property == "radius" && entity.flags & SceneEntity::POINT_LIGHT) {
+                    entity.scale[0] = tokens.number();
+                } else {
+                    tokens.fail("unknown property '" + property + "'");
+                }
+            }
+        }
+    }
+
+    SceneFile SceneFile::load(const std::string& filepath)
+    {
+        AssetData file = AssetArchive::load(filepath);
+        uint32_t magic = 0;
+        if(file.size() >= sizeof(magic)) std::memcpy(&magic, file.data(), sizeof(magic));
+        if(magic == SceneHeader::MAGIC) {
+            return parseBinary(file.data(), file.size(), filepath);
+        }
+        return parseText(file.data(), file.size(), filepath);
+    }
+
+    SceneFile SceneFile::parseText(const char* text, size_t size, const std::string& filepath)
+    {
+        SceneFile scene{};
+        std::unordered_map<std::string, uint32_t> modelIndices;
+
+        const char* end = text + size;
+        int lineNumber = 0;
+        for(const char* line = text; line < end;) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if(lineEnd == nullptr) lineEnd = end;
+            lineNumber++;
+
+            LineTokens tokens{line, lineEnd, filepath + ":" + std::to_string(lineNumber)};
+            line = lineEnd + 1;
+            if(tokens.empty()) continue;
+
+            const std::string statement = tokens.word();
+            if(statement == "model") {
+                const std::string name = tokens.word();
+                if(!modelIndices.emplace(name, static_cast<uint32_t>(scene.models.size())).second) {
+                    tokens.fail("model '" + name + "' defined twice");
+                }
+                scene.models.emplace_back();
+                parseModel(tokens, scene.models.back());
+            } else if(statement == "entity") {
+                SceneEntity entity{};
+                const std::string name = tokens.word();
+                if(name != "-") {
+                    auto it = modelIndices.find(name);
+                    if(it == modelIndices.end()) tokens.fail("unknown model '" + name + "'");
+                    entity.model = it->second;
+                }
+                parseEntity(tokens, entity);
+                scene.entities.push_back(entity);
+            } else if(statement == "light") {
+                // GameObject::makePointLight defaults
+                SceneEntity light{};
+                light.flags = SceneEntity::POINT_LIGHT;
+                light.lightIntensity = 10.f;
+                light.scale[0] = .1f;
+                light.color[0] = light.color[1] = light.color[2] = 1.f;
+                parseEntity(tokens, light);
+                scene.entities.push_back(light);
+            } else {
+                tokens.fail("unknown statement '" + statement + "'");
+            }
+        }
+        warnAboutLightCount(scene, filepath);
+        return scene;
+    }
+
+    SceneFile SceneFile::parseBinary(const char* data, size_t size, const std::string& filepath)
+    {
+        SceneHeader header{};
+        if(size < sizeof(header)) {
+            throw std::runtime_error("not a binary scene: " + filepath);
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if(header.magic != SceneHeader::MAGIC) {
+            throw std::runtime_error("not a binary scene: " + filepath);
+        }
+        if(header.version != SceneHeader::VERSION) {
+            throw std::runtime_error("unsupported binary scene version: " + filepath);
+        }
+        const size_t modelsOffset = sizeof(SceneHeader);
+        const size_t entitiesOffset = modelsOffset + sizeof(SceneModelRecord) * header.modelCount;
+        const size_t pathsOffset = entitiesOffset + sizeof(SceneEntity) * header.entityCount;
+        if(pathsOffset + header.pathsSize > size) {
+            throw std::runtime_error("truncated binary scene: " + filepath);
+        }
+
+        SceneFile scene{};
+        scene.models.resize(header.modelCount);
+        for(uint32_t i = 0; i < header.modelCount; i++) {
+            SceneModelRecord record{};
+            std::memcpy(&record, data + modelsOffset + sizeof(record) * i, sizeof(record));
+            if(static_cast<uint64_t>(record.pathOffset) + record.pathLength > header.pathsSize) {
+                throw std::runtime_error("corrupt model path in binary scene: " + filepath);
+            }
+            if(record.vertexFormat != SceneVertexFormat::Standard && record.vertexFormat != SceneVertexFormat::Compact) {
+                throw std::runtime_error("unknown vertex format in binary scene: " + filepath);
+            }
+            if(record.lodCount < 1) {
+                throw std::runtime_error("model without lods in binary scene: " + filepath);
+            }
+            SceneModel& model = scene.models[i];
+            model.path.assign(data + pathsOffset + record.pathOffset, record.pathLength);
+            model.vertexFormat = record.vertexFormat;
+            model.lodCount = record.lodCount;
+            model.meshletCulling = record.flags & SceneModelRecord::MESHLET_CULLING;
+            model.meshletBackfaceCulling = record.flags & SceneModelRecord::MESHLET_BACKFACE_CULLING;
+        }
+
+        scene.entities.resize(header.entityCount);
+        std::memcpy(scene.entities.data(), data + entitiesOffset, sizeof(SceneEntity) * header.entityCount);
+        for(const SceneEntity& entity : scene.entities) {
+            if(entity.model != SceneEntity::NO_MODEL && entity.model >= header.modelCount) {
+                throw std::runtime_error("entity with an invalid model in binary scene: " + filepath);
+            }
+            if(entity.materialIndex >= SceneEntity::MAX_MATERIALS) {
+                throw std::runtime_error("entity with an invalid material in binary scene: " + filepath);
+            }
+        }
+        warnAboutLightCount(scene, filepath);
+        return scene;
+    }
+
+    void SceneFile::writeBinary(const std::string& filepath) const
+    {
+        SceneHeader header{};
+        header.modelCount = static_cast<uint32_t>(models.size());
+        header.entityCount = static_cast<uint32_t>(entities.size());
+
+        std::vector<SceneModelRecord> records(models.size());
+        std::string paths;
+        for(size_t i = 0; i < models.size(); i++) {
+            records[i].pathOffset = static_cast<uint32_t>(paths.size());
+            records[i].pathLength = static_cast<uint32_t>(models[i].path.size());
+            records[i].vertexFormat = models[i].vertexFormat;
+            records[i].lodCount = models[i].lodCount;
+            records[i].flags = (models[i].meshletCulling ? SceneModelRecord::MESHLET_CULLING : 0) |
+                (models[i].meshletBackfaceCulling ? SceneModelRecord::MESHLET_BACKFACE_CULLING : 0);
+            paths += models[i].path;
+        }
+        header.pathsSize = static_cast<uint32_t>(paths.size());
+
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open()) {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()), sizeof(SceneModelRecord) * records.size());
+        file.write(reinterpret_cast<const char*>(entities.data()), sizeof(SceneEntity) * entities.size());
+        file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+        if(!file) {
+            throw std::runtime_error("failed to write binary scene: " + filepath);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Cosmos {
+
+    enum class SceneVertexFormat : uint32_t {
+        Standard = 0, // Model::VertexFormat::Standard
+        Compact = 1,
+    };
+
+    // Import settings of one model, entities refer to it by index
+    struct SceneModel {
+        std::string path{};
+        SceneVertexFormat vertexFormat = SceneVertexFormat::Standard;
+        uint32_t lodCount = 4;
+        bool meshletCulling = false;
+        bool meshletBackfaceCulling = true;
+    };
+
+    // Same layout in memory and in binary scenes, which are loaded with one copy
+    struct SceneEntity {
+        static constexpr uint32_t NO_MODEL = ~0u;
+        static constexpr uint32_t POINT_LIGHT = 1u << 0;
+        static constexpr uint32_t MAX_MATERIALS = 4096; // MaterialSystem::MAX_MATERIALS
+        static constexpr uint32_t MAX_SHADING_LIGHTS = 10; // MAX_LIGHTS in frame_info.hpp
+
+        float translation[3] = {0.f, 0.f, 0.f};
+        float rotation[3] = {0.f, 0.f, 0.f}; // radians, see TransformComponent
+        float scale[3] = {1.f, 1.f, 1.f};    // scale[0] is the radius of point lights
+        float color[3] = {0.f, 0.f, 0.f};
+        uint32_t model = NO_MODEL;
+        uint32_t materialIndex = 0; // below MAX_MATERIALS, instantiateEntity falls back to 0 if it does not exist
+        float lightIntensity = 0.f;
+        uint32_t flags = 0;
+    };
+    static_assert(sizeof(SceneEntity) == 64, "SceneEntity is stored as is in binary scenes");
+
+    /*
+    Binary scene (.cscene), written by SceneCooker from the text format:
+        SceneHeader
+        SceneModelRecord[modelCount]
+        SceneEntity[entityCount]
+        model paths, not terminated
+    All values are little endian.
+    */
+    struct SceneHeader {
+        static constexpr uint32_t MAGIC = 0x4E435343; // "CSCN"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        uint32_t modelCount = 0;
+        uint32_t entityCount = 0;
+        uint32_t pathsSize = 0;
+        uint32_t reserved[3]{};
+    };
+
+    struct SceneModelRecord {
+        static constexpr uint32_t MESHLET_CULLING = 1u << 0;
+        static constexpr uint32_t MESHLET_BACKFACE_CULLING = 1u << 1;
+
+        uint32_t pathOffset = 0;
+        uint32_t pathLength = 0;
+        SceneVertexFormat vertexFormat = SceneVertexFormat::Standard;
+        uint32_t lodCount = 4;
+        uint32_t flags = 0;
+        uint32_t reserved = 0;
+    };
+
+    /*
+    Entities, point lights and the models they use. Text scenes (.scene) are meant for authoring,
+    one statement per line, '#' starts a comment:
+        model <name> <path> [format=standard|compact] [lods=<n>] [culling=none|frustum|cone]
+        entity <model name|-> [position x y z] [rotation x y z] [scale x y z|scale s] [color r g b] [material n]
+        light [position x y z] [color r g b] [intensity i] [radius r]
+    Rotations are in degrees in text and radians everywhere else.
+    */
+    class SceneFile {
+    public:
+        // Binary or text, told apart by the magic. Loaded through AssetArchive, so packed scenes work too
+        static SceneFile load(const std::string& filepath);
+        static SceneFile parseText(const char* text, size_t size, const std::string& filepath);
+        static SceneFile parseBinary(const char* data, size_t size, const std::string& filepath);
+
+        void writeBinary(const std::string& filepath) const;
+
+        std::vector<SceneModel> models{};
+        std::vector<SceneEntity> entities{};
+    };
+}
@@ -0,0 +1,66 @@
+#include "scene_loader.hpp"
+
+#include "frame_info.hpp"
+#include "material_system.hpp"
+
+#include <future>
+#include <vector>
+
+namespace Cosmos {
+
+    static_assert(SceneEntity::MAX_MATERIALS == MaterialSystem::MAX_MATERIALS, "Scenes may index every material");
+    static_assert(SceneEntity::MAX_SHADING_LIGHTS == MAX_LIGHTS, "Scenes warn about lights beyond the ubo");
+
+    size_t loadScene(const std::string& filepath, AssetManager& assetManager, GameObject::Map& gameObjects,
+        uint32_t materialCount)
+    {
+        const SceneFile scene = SceneFile::load(filepath);
+
+        std::vector<std::shared_future<std::shared_ptr<Model>>> models;
+        models.reserve(scene.models.size());
+        for(const SceneModel& sceneModel : scene.models) {
+            models.push_back(assetManager.loadModelAsync(sceneModel.path, getImportSettings(sceneModel)));
+        }
+
+        // the entities are built while the models import
+        gameObjects.reserve(gameObjects.size() + scene.entities.size());
+        std::vector<GameObject::id_t> ids(scene.entities.size());
+        for(size_t i = 0; i < scene.entities.size(); i++) {
+            GameObject gameObject = instantiateEntity(scene.entities[i], materialCount);
+            ids[i] = gameObject.getId();
+            gameObjects.emplace(ids[i], std::move(gameObject));
+        }
+
+        for(size_t i = 0; i < scene.entities.size(); i++) {
+            const uint32_t model = scene.entities[i].model;
+            if(model != SceneEntity::NO_MODEL) gameObjects.at(ids[i]).model = models[model].get();
+        }
+        return scene.entities.size();
+    }
+
+    Model::Builder getImportSettings(const SceneModel& sceneModel)
+    {
+        Model::Builder importSettings{};
+        importSettings.vertexFormat = sceneModel.vertexFormat == SceneVertexFormat::Compact
+            ? Model::VertexFormat::Compact : Model::VertexFormat::Standard;
+        importSettings.lodCount = sceneModel.lodCount;
+        importSettings.meshletCulling = sceneModel.meshletCulling;
+        importSettings.meshletBackfaceCulling = sceneModel.meshletBackfaceCulling;
+        return importSettings;
+    }
+
+    GameObject instantiateEntity(const SceneEntity& entity, uint32_t materialCount)
+    {
+        GameObject gameObject = GameObject::createGameObject();
+        if(entity.flags & SceneEntity::POINT_LIGHT) {
+            gameObject.pointLight = std::make_unique<PointLightComponent>();
+            gameObject.pointLight->lightIntensity = entity.lightIntensity;
+        }
+        gameObject.transform.translation = {entity.translation[0], entity.translation[1], entity.translation[2]};
+        gameObject.transform.rotation = {entity.rotation[0], entity.rotation[1], entity.rotation[2]};
+        gameObject.transform.scale = {entity.scale[0], entity.scale[1], entity.scale[2]};
+        gameObject.color = {entity.color[0], entity.color[1], entity.color[2]};
+        gameObject.materialIndex = entity.materialIndex < materialCount ? entity.materialIndex : 0;
+        return gameObject;
+    }
+}
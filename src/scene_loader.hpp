@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "asset_manager.hpp"
+#include "game_object.hpp"
+#include "scene_file.hpp"
+
+namespace Cosmos {
+
+    // Instantiates every entity of a scene file (see SceneFile) into gameObjects. All model loads are
+    // queued on the asset manager before any is waited on, so they import in parallel.
+    // materialCount is MaterialSystem::getMaterialCount(). Returns the number of game objects created.
+    size_t loadScene(const std::string& filepath, AssetManager& assetManager, GameObject::Map& gameObjects,
+        uint32_t materialCount);
+
+    Model::Builder getImportSettings(const SceneModel& sceneModel);
+    // Everything but the model, which the caller resolves from entity.model. Material indices not below
+    // materialCount fall back to material 0
+    GameObject instantiateEntity(const SceneEntity& entity, uint32_t materialCount);
+}
@@ -0,0 +1,131 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include <glm/gtc/constants.hpp>
+
+namespace Cosmos {
+
+    Simulation::Simulation(const TransformComponent& viewer, const KeyboardMovementController& viewerController)
+        : Simulation{viewer, viewerController, Settings{}} {}
+
+    Simulation::Simulation(const TransformComponent& viewer, const KeyboardMovementController& viewerController,
+        const Settings& settings)
+        : settings{settings}, tickDuration{static_cast<float>(1.0 / settings.tickRate)}, viewerController{viewerController}
+    {
+        current.viewer = viewer;
+        previous = current;
+        startTime = Clock::now();
+        thread = std::thread(&Simulation::run, this);
+    }
+
+    Simulation::~Simulation()
+    {
+        running = false;
+        thread.join();
+    }
+
+    void Simulation::setInput(const KeyboardMovementController::Input& newInput)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        input = newInput;
+    }
+
+    void Simulation::syncLights(const GameObject::Map& gameObjects)
+    {
+        std::vector<Body> lights;
+        for(const auto& kv : gameObjects) {
+            if(kv.second.pointLight != nullptr) lights.push_back({kv.first, kv.second.transform});
+        }
+        std::sort(lights.begin(), lights.end(), [](const Body& a, const Body& b) { return a.id < b.id; });
+
+        std::lock_guard<std::mutex> lock{mutex};
+        const bool unchanged = std::equal(lights.begin(), lights.end(), current.lights.begin(), current.lights.end(),
+            [](const Body& a, const Body& b) { return a.id == b.id; });
+        if(unchanged) return;
+
+        // known lights keep their simulated transform, new ones start where the game object is
+        for(State* state : {&previous, &current}) {
+            std::vector<Body> synced = lights;
+            auto known = state->lights.begin();
+            for(Body& body : synced) {
+                while(known != state->lights.end() && known->id < body.id) ++known;
+                if(known != state->lights.end() && known->id == body.id) body.transform = known->transform;
+            }
+            state->lights = std::move(synced);
+        }
+    }
+
+    Simulation::State Simulation::interpolate() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        // one tick behind, so the render time normally lies between previous and current. Kept in clock
+        // ticks until the ratio, seconds since start as float lose the sub tick precision after some hours
+        const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.tickRate));
+        const Clock::duration sincePrevious = Clock::now() - startTime - tick * static_cast<int64_t>(previous.tick + 1);
+        const float alpha = static_cast<float>(glm::clamp(
+            std::chrono::duration<double>(sincePrevious) / std::chrono::duration<double>(tick), 0.0, 1.0));
+
+        State state{};
+        state.tick = current.tick;
+        state.viewer = interpolate(previous.viewer, current.viewer, alpha);
+        assert(previous.lights.size() == current.lights.size() && "Light snapshots out of sync");
+        state.lights.resize(current.lights.size());
+        for(size_t i = 0; i < current.lights.size(); i++) {
+            state.lights[i].id = current.lights[i].id;
+            state.lights[i].transform = interpolate(previous.lights[i].transform, current.lights[i].transform, alpha);
+        }
+        return state;
+    }
+
+    void Simulation::run()
+    {
+        const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.tickRate));
+        while(running) {
+            Clock::time_point nextTickTime;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                nextTickTime = startTime + tick * static_cast<int64_t>(current.tick + 1);
+                const auto now = Clock::now();
+                if(now > nextTickTime + tick * settings.maxCatchUpTicks) {
+                    // stalled (debugger, sleep), continue from now instead of replaying every missed tick
+                    startTime += now - nextTickTime;
+                    nextTickTime = now;
+                }
+            }
+            std::this_thread::sleep_until(nextTickTime);
+
+            // stepped under the lock so lights synced meanwhile are part of this tick
+            std::lock_guard<std::mutex> lock{mutex};
+            State next = current;
+            next.tick++;
+            step(next, input);
+            previous = std::move(current);
+            current = std::move(next);
+        }
+    }
+
+    // One fixed step, the same input and state always give the same result
+    void Simulation::step(State& state, const KeyboardMovementController::Input& stepInput) const
+    {
+        viewerController.apply(stepInput, tickDuration, state.viewer);
+
+        const glm::mat4 rotateLights = glm::rotate(glm::mat4(1.f), settings.lightOrbitSpeed * tickDuration, {0.f, -1.f, 0.f});
+        for(Body& light : state.lights) {
+            light.transform.translation = glm::vec3(rotateLights * glm::vec4(light.transform.translation, 1.f));
+        }
+    }
+
+    TransformComponent Simulation::interpolate(const TransformComponent& a, const TransformComponent& b, float alpha)
+    {
+        TransformComponent result{};
+        result.translation = glm::mix(a.translation, b.translation, alpha);
+        result.scale = glm::mix(a.scale, b.scale, alpha);
+        // the shortest way around, yaw wraps at 2 pi
+        glm::vec3 delta = b.rotation - a.rotation;
+        delta -= glm::two_pi<float>() * glm::floor((delta + glm::pi<float>()) / glm::two_pi<float>());
+        result.rotation = a.rotation + delta * alpha;
+        return result;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game_object.hpp"
+#include "keyboard_movement_controller.hpp"
+
+namespace Cosmos {
+
+    /*
+    Fixed timestep simulation on its own thread: the viewer driven by the sampled input and the
+    orbiting point lights advance tickRate times per second regardless of the frame rate, so the
+    result only depends on the input. Every tick publishes a snapshot, the render side interpolates
+    between the last two, one tick behind the simulation, so motion stays smooth at any frame rate.
+    Game objects are only ever touched by the main thread, it copies the interpolated transforms in.
+    */
+    class Simulation {
+    public:
+        struct Settings {
+            double tickRate = 60.0;      // Hz
+            float lightOrbitSpeed = 1.f; // radians per second around -Y
+            uint32_t maxCatchUpTicks = 8; // a longer stall is skipped instead of replayed
+        };
+
+        struct Body {
+            GameObject::id_t id = 0;
+            TransformComponent transform{};
+        };
+
+        struct State {
+            uint64_t tick = 0;
+            TransformComponent viewer{};
+            std::vector<Body> lights{}; // sorted by id
+        };
+
+        Simulation(const TransformComponent& viewer, const KeyboardMovementController& viewerController);
+        Simulation(const TransformComponent& viewer, const KeyboardMovementController& viewerController,
+            const Settings& settings);
+        ~Simulation();
+
+        Simulation(const Simulation&) = delete;
+        Simulation& operator=(const Simulation&) = delete;
+
+        // Used by every tick until the next call
+        void setInput(const KeyboardMovementController::Input& input);
+        // Starts simulating point lights added to gameObjects since the last call, drops removed ones
+        void syncLights(const GameObject::Map& gameObjects);
+        // Snapshot for the current time, interpolated between the last two ticks
+        State interpolate() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void run();
+        void step(State& state, const KeyboardMovementController::Input& input) const;
+        static TransformComponent interpolate(const TransformComponent& a, const TransformComponent& b, float alpha);
+
+        const Settings settings;
+        const float tickDuration;
+        const KeyboardMovementController viewerController;
+
+        mutable std::mutex mutex;
+        State previous{};
+        State current{};
+        KeyboardMovementController::Input input{};
+        Clock::time_point startTime{}; // wall time of tick 0, moves forward when a stall is skipped
+
+        std::atomic<bool> running{true};
+        std::thread thread{}; // last, it starts once everything else is initialized
+    };
+}
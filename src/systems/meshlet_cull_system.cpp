@@ -0,0 +1,219 @@
+#include "meshlet_cull_system.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Cosmos {
+
+    struct MeshletCullData {
+        glm::vec4 frustumPlanes[6]; // world space, normals point inside
+        glm::vec4 cameraPosition{};
+    };
+
+    struct MeshletCullPushConstantData {
+        glm::mat4 modelMatrix{1.f}; // object transform only, meshlet bounds are unquantized
+        uint32_t meshletCount = 0;
+        uint32_t commandIndex = 0;
+        uint32_t outputOffset = 0;
+        float maxScale = 1.f;
+    };
+
+    MeshletCullSystem::MeshletCullSystem(EngineDevice& device, DescriptorSetLayoutCache& layoutCache,
+        uint32_t framesInFlight)
+        : engineDevice{device}
+    {
+        createPipelineLayout(layoutCache);
+        createPipeline();
+
+        frames.resize(framesInFlight);
+        for(auto& frame : frames) {
+            frame.cullDataBuffer = std::make_unique<Buffer>(
+                engineDevice,
+                sizeof(MeshletCullData),
+                1,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            frame.cullDataBuffer->map();
+        }
+    }
+
+    MeshletCullSystem::~MeshletCullSystem()
+    {
+        vkDestroyPipelineLayout(engineDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void MeshletCullSystem::createPipelineLayout(DescriptorSetLayoutCache& layoutCache)
+    {
+        cullSetLayout = DescriptorSetLayout::Builder(engineDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build(layoutCache);
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(MeshletCullPushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = cullSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if(vkCreatePipelineLayout(engineDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void MeshletCullSystem::createPipeline()
+    {
+        assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+        ptr_Pipeline = std::make_unique<ComputePipeline>(
+            engineDevice,
+            "../shaders/meshlet_cull.comp.spv",
+            pipelineLayout);
+    }
+
+    // Grows the buffers of a frame slot whose last submit completed, so they are not in use
+    void MeshletCullSystem::reserveFrameResources(FrameResources& frame, uint32_t indexCount, uint32_t drawCount)
+    {
+        if(!frame.outputIndexBuffer || frame.outputIndexBuffer->getInstanceCount() < indexCount) {
+            uint32_t capacity = frame.outputIndexBuffer ? frame.outputIndexBuffer->getInstanceCount() : 0;
+            frame.outputIndexBuffer = std::make_unique<Buffer>(
+                engineDevice,
+                sizeof(uint32_t),
+                std::max(indexCount, capacity * 2),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        if(!frame.drawCommandBuffer || frame.drawCommandBuffer->getInstanceCount() < drawCount) {
+            uint32_t capacity = frame.drawCommandBuffer ? frame.drawCommandBuffer->getInstanceCount() : 0;
+            // written by the CPU every frame, the compute pass only adds to indexCount
+            frame.drawCommandBuffer = std::make_unique<Buffer>(
+                engineDevice,
+                sizeof(VkDrawIndexedIndirectCommand),
+                std::max(drawCount, capacity * 2),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            frame.drawCommandBuffer->map();
+        }
+    }
+
+    void MeshletCullSystem::cull(FrameInfo& frameInfo)
+    {
+        drawCommands.clear();
+
+        uint32_t indexCount = 0;
+        uint32_t drawCount = 0;
+        for(const auto& obj : frameInfo.objects)
+        {
+            if(obj.model == nullptr || !obj.model->hasMeshlets()) continue;
+            indexCount += obj.model->getMeshletIndexCount();
+            drawCount++;
+        }
+        if(drawCount == 0)
+            return;
+
+        auto& frame = frames[frameInfo.frameIndex];
+        reserveFrameResources(frame, indexCount, drawCount);
+
+        MeshletCullData cullData{};
+        const Frustum frustum = frameInfo.camera.getFrustum();
+        std::copy(std::begin(frustum.planes), std::end(frustum.planes), cullData.frustumPlanes);
+        cullData.cameraPosition = glm::vec4(frameInfo.camera.getPosition(), 1.f);
+        frame.cullDataBuffer->writeToBuffer(&cullData);
+
+        auto cullDataInfo = frame.cullDataBuffer->descriptorInfo();
+        auto outputIndexInfo = frame.outputIndexBuffer->descriptorInfo();
+        auto drawCommandInfo = frame.drawCommandBuffer->descriptorInfo();
+        auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(frame.drawCommandBuffer->getMappedMemory());
+
+        ptr_Pipeline->bind(frameInfo.commandBuffer);
+
+        uint32_t outputOffset = 0;
+        for(const auto& obj : frameInfo.objects)
+        {
+            if(obj.model == nullptr || !obj.model->hasMeshlets()) continue;
+            auto& model = *obj.model;
+
+            const uint32_t commandIndex = static_cast<uint32_t>(drawCommands.size());
+            drawCommands[obj.id] = commandIndex;
+            commands[commandIndex] = {0, 1, outputOffset, 0, 0};
+
+            MeshletCullPushConstantData push{};
+            push.modelMatrix = obj.modelMatrix;
+            push.meshletCount = model.getMeshletCount();
+            push.commandIndex = commandIndex;
+            push.outputOffset = outputOffset;
+            push.maxScale = obj.maxScale;
+            outputOffset += model.getMeshletIndexCount();
+
+            // whole object outside: its command keeps indexCount 0, no dispatch needed
+            const glm::vec3 center = glm::vec3(push.modelMatrix * glm::vec4(model.getBoundingCenter(), 1.f));
+            if(!frustum.intersectsSphere(center, model.getBoundingRadius() * push.maxScale)) continue;
+
+            auto meshletInfo = model.getMeshletBuffer().descriptorInfo();
+            auto meshletIndexInfo = model.getMeshletIndexBuffer().descriptorInfo();
+            VkDescriptorSet descriptorSet;
+            if(!DescriptorWriter(*cullSetLayout, frameInfo.frameDescriptorAllocator)
+                .writeBuffer(0, &cullDataInfo)
+                .writeBuffer(1, &meshletInfo)
+                .writeBuffer(2, &meshletIndexInfo)
+                .writeBuffer(3, &outputIndexInfo)
+                .writeBuffer(4, &drawCommandInfo)
+                .build(descriptorSet))
+            {
+                throw std::runtime_error("failed to allocate meshlet cull descriptor set!");
+            }
+
+            vkCmdBindDescriptorSets(
+                frameInfo.commandBuffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipelineLayout,
+                0,
+                1,
+                &descriptorSet,
+                0,
+                nullptr);
+            vkCmdPushConstants(frameInfo.commandBuffer,
+                pipelineLayout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(MeshletCullPushConstantData),
+                &push);
+            vkCmdDispatch(frameInfo.commandBuffer, model.getMeshletCount(), 1, 1);
+        }
+    }
+
+    bool MeshletCullSystem::drawCulled(FrameInfo& frameInfo, const RenderObject& obj)
+    {
+        auto command = drawCommands.find(obj.id);
+        if(command == drawCommands.end())
+            return false;
+
+        auto& frame = frames[frameInfo.frameIndex];
+        obj.model->bindVertexBuffer(frameInfo.commandBuffer);
+        vkCmdBindIndexBuffer(frameInfo.commandBuffer, frame.outputIndexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexedIndirect(
+            frameInfo.commandBuffer,
+            frame.drawCommandBuffer->getBuffer(),
+            command->second * sizeof(VkDrawIndexedIndirectCommand),
+            1,
+            sizeof(VkDrawIndexedIndirectCommand));
+        return true;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "pipeline.hpp"
+#include "engine_device.hpp"
+#include "game_object.hpp"
+#include "buffer.hpp"
+#include "descriptors.hpp"
+#include "frame_info.hpp"
+
+namespace Cosmos {
+
+    /*
+    Per meshlet frustum and backface cone culling in a compute pass. Every visible meshlet of a
+    model with meshlets appends its triangles to a per frame index buffer, the object is then drawn
+    with one vkCmdDrawIndexedIndirect by the regular vertex pipelines, no mesh shaders needed.
+    */
+    class MeshletCullSystem
+    {
+    public:
+        MeshletCullSystem(EngineDevice& device, DescriptorSetLayoutCache& layoutCache, uint32_t framesInFlight);
+        ~MeshletCullSystem();
+
+        MeshletCullSystem(const MeshletCullSystem&) = delete;
+        MeshletCullSystem& operator=(const MeshletCullSystem&) = delete;
+
+        // Records the culling dispatches, must be called outside of the render pass. The indirect draws
+        // wait for them through the render graph: COMPUTE_BUFFER_WRITE here, INDIRECT_DRAW where they are drawn
+        void cull(FrameInfo& frameInfo);
+        // Draws the triangles of obj that survived this frame's cull, false if obj was not culled.
+        // The graphics pipeline and push constants of obj have to be bound already.
+        bool drawCulled(FrameInfo& frameInfo, const RenderObject& obj);
+
+    private:
+        struct FrameResources {
+            std::unique_ptr<Buffer> cullDataBuffer;
+            std::unique_ptr<Buffer> outputIndexBuffer; // uint32, storage + index
+            std::unique_ptr<Buffer> drawCommandBuffer; // VkDrawIndexedIndirectCommand, one per object
+        };
+
+        void createPipelineLayout(DescriptorSetLayoutCache& layoutCache);
+        void createPipeline();
+        void reserveFrameResources(FrameResources& frame, uint32_t indexCount, uint32_t drawCount);
+
+        EngineDevice& engineDevice;
+        std::shared_ptr<DescriptorSetLayout> cullSetLayout;
+        VkPipelineLayout pipelineLayout;
+        std::unique_ptr<ComputePipeline> ptr_Pipeline;
+
+        std::vector<FrameResources> frames;
+        // object -> draw command written by the last cull
+        std::unordered_map<GameObject::id_t, uint32_t> drawCommands;
+    };
+
+}
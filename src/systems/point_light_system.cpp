@@ -5,9 +5,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <array>
-#include <map>
 
 #include <iostream>
 
@@ -20,10 +20,10 @@ namespace Cosmos {
     };
 
     PointLightSystem::PointLightSystem(EngineDevice& device, 
-        VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device}
+        const RenderTarget& renderTarget, VkDescriptorSetLayout globalSetLayout) : engineDevice{device}
     {
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(renderTarget);
     }
 
     PointLightSystem::~PointLightSystem()
@@ -51,7 +51,7 @@ namespace Cosmos {
             throw std::runtime_error("failed to create pipeline layout!");
         }
     }
-    void PointLightSystem::createPipeline(VkRenderPass renderPass)
+    void PointLightSystem::createPipeline(const RenderTarget& renderTarget)
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
@@ -62,7 +62,7 @@ namespace Cosmos {
         pipelineConfig.attributeDescriptions.clear();
         pipelineConfig.bindindDescriptions.clear();
 
-        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.renderTarget = renderTarget;
         pipelineConfig.pipelineLayout = pipelineLayout;
         ptr_Pipeline = std::make_unique<Pipeline>(
             engineDevice, 
@@ -71,48 +71,54 @@ namespace Cosmos {
             pipelineConfig);
     }
 
-    void PointLightSystem::update(FrameInfo &frameInfo, GlobalUbo &ubo)
+    void PointLightSystem::update(const std::vector<RenderObject>& objects, GlobalUbo &ubo)
     {
-        auto rotateLight = glm::rotate(
-                glm::mat4(1.f),
-                frameInfo.frameTime,
-                {0.f, -1.f, 0.f}
-            );
+        // the lights are moved by the Simulation, this only copies where they are this frame
+        std::vector<const RenderObject*> lights;
+        for(const auto& obj : objects)
+        {
+            if(obj.pointLight) lights.push_back(&obj);
+        }
 
-        int lightIndex = 0;
-        for(auto& kv : frameInfo.gameObjects)
+        // scenes may hold more lights than the ubo, the nearest ones shade
+        if(lights.size() > MAX_LIGHTS)
         {
-            auto& obj = kv.second;
-            if(obj.pointLight == nullptr) continue;
+            const glm::vec3 cameraPosition{ubo.inverseView[3]};
+            auto distance2 = [&cameraPosition](const RenderObject* light) {
+                const glm::vec3 offset = light->position - cameraPosition;
+                return glm::dot(offset, offset);
+            };
+            std::nth_element(lights.begin(), lights.begin() + MAX_LIGHTS, lights.end(),
+                [&](const RenderObject* a, const RenderObject* b) { return distance2(a) < distance2(b); });
+            lights.resize(MAX_LIGHTS);
+        }
 
-            assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum of the limit");
-            
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-            
+        for(size_t i = 0; i < lights.size(); i++)
+        {
             // copy light to ubo
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            lightIndex += 1;
+            ubo.pointLights[i].position = glm::vec4(lights[i]->position, 1.f);
+            ubo.pointLights[i].color = glm::vec4(lights[i]->color, lights[i]->lightIntensity);
         }
-        ubo.numLights = lightIndex;
+        ubo.numLights = static_cast<int>(lights.size());
     }
 
     void PointLightSystem::render(
         FrameInfo &frameInfo)
     // VkCommandBuffer commandBuffer, std::vector<GameObject> &gameObjects, const Camera& camera)
     {
-        // sort lights
-        std::map<float, GameObject::id_t> sorted;
-        for(auto& kv : frameInfo.gameObjects)
+        // sort lights, keyed by distance instead of a map keyed by it, equal distances don't collapse
+        renderQueue.clear();
+        for(uint32_t i = 0; i < static_cast<uint32_t>(frameInfo.objects.size()); i++)
         {
-            auto& obj = kv.second;
-            if(obj.pointLight == nullptr) continue;
+            const auto& obj = frameInfo.objects[i];
+            if(!obj.pointLight) continue;
 
             // calculate distance
-            auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
+            auto offset = frameInfo.camera.getPosition() - obj.position;
             float disSquared = glm::dot(offset, offset);
-            sorted[disSquared] = obj.getId();
+            renderQueue.add(RenderQueue::Pass::Transparent, 0, 0, 0, disSquared, i);
         }
+        renderQueue.sort();
 
         ptr_Pipeline->bind(frameInfo.commandBuffer);
 
@@ -126,15 +132,15 @@ namespace Cosmos {
             0, 
             nullptr);
 
-        // interate through sorted lights in reverse order
-        for(auto it = sorted.rbegin(); it != sorted.rend(); ++it)
+        // farthest light first
+        for(const auto& draw : renderQueue.getDraws())
         {
-            auto& obj = frameInfo.gameObjects.at(it->second);
+            const auto& obj = frameInfo.objects[draw.item];
             
             PointLightPushConstants push{};
-            push.position =  glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
+            push.position =  glm::vec4(obj.position, 1.f);
+            push.color = glm::vec4(obj.color, obj.lightIntensity);
+            push.radius = obj.lightRadius;
 
             vkCmdPushConstants(
                 frameInfo.commandBuffer, 
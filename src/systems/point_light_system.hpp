@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "pipeline.hpp"
+#include "render_queue.hpp"
 #include "engine_device.hpp"
 #include "game_object.hpp"
 #include "camera.hpp"
@@ -13,7 +14,7 @@ namespace Cosmos {
     class PointLightSystem
     {
     public:
-        PointLightSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        PointLightSystem(EngineDevice& device, const RenderTarget& renderTarget, VkDescriptorSetLayout globalSetLayout);
         ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem&) = delete;
@@ -21,16 +22,20 @@ namespace Cosmos {
 
         void run();
 
-        void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+        // fills the ubo lights, the MAX_LIGHTS nearest to the camera (ubo.inverseView) when there are more.
+        // Runs on the main thread while the frame packet is built
+        static void update(const std::vector<RenderObject>& objects, GlobalUbo& ubo);
+        // Blended back to front, lights at the same distance are all drawn
         void render(FrameInfo& frameInfo);
     
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(const RenderTarget& renderTarget);
 
         EngineDevice& engineDevice;
         std::unique_ptr<Pipeline> ptr_Pipeline;
         VkPipelineLayout pipelineLayout;
+        RenderQueue renderQueue{}; // render thread only
 
     };
 
@@ -14,14 +14,19 @@ namespace Cosmos {
 
     struct SimplePushConstantData{
         glm::mat4 modelMatrix{1.f}; // offset inside this tranform matrix
-        glm::mat4 normalMatrix{1.f};
+        glm::mat3x4 normalMatrix{1.f}; // GLSL mat3, std430 pads its columns to vec4
+        uint32_t materialIndex = 0;
     };
+    // within the 128 bytes every device supports
+    static_assert(sizeof(SimplePushConstantData) == 116, "Push constant layout out of sync with the shaders");
 
     SimpleRenderSystem::SimpleRenderSystem(EngineDevice& device, 
-        VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device}
+        const RenderTarget& renderTarget, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout materialSetLayout,
+        bool depthPrepass) 
+        : engineDevice{device}, depthPrepass{depthPrepass}
     {
-        createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipelineLayout(globalSetLayout, materialSetLayout);
+        createPipeline(renderTarget);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem()
@@ -29,14 +34,14 @@ namespace Cosmos {
         vkDestroyPipelineLayout(engineDevice.device(), pipelineLayout, nullptr);
     }
 
-    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout materialSetLayout)
     {
         VkPushConstantRange pushConstantRange{};
         pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
         pushConstantRange.offset = 0;
         pushConstantRange.size = sizeof(SimplePushConstantData);
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, materialSetLayout};
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -49,46 +54,126 @@ namespace Cosmos {
             throw std::runtime_error("failed to create pipeline layout!");
         }
     }
-    void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+    void SimpleRenderSystem::createPipeline(const RenderTarget& renderTarget)
     {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
         PipelineConfigInfo pipelineConfig{};
         Pipeline::defaultPipelineConfigInfo(pipelineConfig);
 
-        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.renderTarget = renderTarget;
         pipelineConfig.pipelineLayout = pipelineLayout;
+
+        if(depthPrepass)
+        {
+            // same vertex buffers, only the position attribute is read
+            PipelineConfigInfo depthConfig{};
+            Pipeline::defaultPipelineConfigInfo(depthConfig);
+            Pipeline::disableColorWrites(depthConfig);
+            depthConfig.renderTarget = renderTarget;
+            depthConfig.pipelineLayout = pipelineLayout;
+            depthConfig.attributeDescriptions.resize(1);
+            depthPipeline = std::make_unique<Pipeline>(
+                engineDevice,
+                "../shaders/depth_only.vert.spv",
+                "",
+                depthConfig);
+
+            depthConfig.bindindDescriptions = Model::CompactVertex::getBindingDescriptions();
+            depthConfig.attributeDescriptions = Model::CompactVertex::getAttributeDescriptions();
+            depthConfig.attributeDescriptions.resize(1);
+            depthCompactPipeline = std::make_unique<Pipeline>(
+                engineDevice,
+                "../shaders/depth_only_compact.vert.spv",
+                "",
+                depthConfig);
+
+            // the prepass already wrote the nearest depth, shading passes only where it matches
+            Pipeline::enableDepthEqualTest(pipelineConfig);
+        }
+
         ptr_Pipeline = std::make_unique<Pipeline>(
             engineDevice, 
             "../shaders/simple_shader.vert.spv",
             "../shaders/simple_shader.frag.spv", 
             pipelineConfig);
+
+        pipelineConfig.bindindDescriptions = Model::CompactVertex::getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = Model::CompactVertex::getAttributeDescriptions();
+        compactPipeline = std::make_unique<Pipeline>(
+            engineDevice,
+            "../shaders/simple_shader_compact.vert.spv",
+            "../shaders/simple_shader.frag.spv",
+            pipelineConfig);
     }
 
     void SimpleRenderSystem::renderGameObjects(
-        FrameInfo& frameInfo)
+        FrameInfo& frameInfo, MeshletCullSystem* meshletCulling)
         // VkCommandBuffer commandBuffer, std::vector<GameObject> &gameObjects, const Camera& camera)
     {
-        ptr_Pipeline->bind(frameInfo.commandBuffer);
-
+        // bound once for all draws of both passes, materials are selected by index
+        VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, frameInfo.materialDescriptorSet};
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS, 
             pipelineLayout,
             0, 
-            1,
-            &frameInfo.globalDescriptorSet,
+            2,
+            descriptorSets,
             0, 
             nullptr);
-        // kv - key value pair
-        for(auto& kv : frameInfo.gameObjects)
+
+        sortDraws(frameInfo);
+        if(depthPrepass)
+        {
+            // front to back only holds per model, without the prepass overlapping surfaces are still lit
+            drawObjects(frameInfo, meshletCulling, *depthPipeline, *depthCompactPipeline);
+        }
+        drawObjects(frameInfo, meshletCulling, *ptr_Pipeline, *compactPipeline);
+    }
+
+    void SimpleRenderSystem::sortDraws(const FrameInfo& frameInfo)
+    {
+        // the material is a push constant index into the bindless set, switching it costs nothing: the
+        // material field stays 0 so the instances of a model sort together and share their buffer binds
+        renderQueue.clear();
+        meshIds.clear();
+        const glm::vec3 cameraPosition = frameInfo.camera.getPosition();
+        for(uint32_t i = 0; i < static_cast<uint32_t>(frameInfo.objects.size()); i++)
         {
-            auto& obj = kv.second;
+            const auto& obj = frameInfo.objects[i];
             if(obj.model == nullptr) continue;
-            
+
+            const uint32_t mesh = meshIds.emplace(obj.model.get(), static_cast<uint32_t>(meshIds.size())).first->second;
+            const glm::vec3 offset = obj.position - cameraPosition;
+            renderQueue.add(RenderQueue::Pass::Opaque, static_cast<uint32_t>(obj.model->getVertexFormat()),
+                0, mesh, glm::dot(offset, offset), i);
+        }
+        renderQueue.sort();
+    }
+
+    void SimpleRenderSystem::drawObjects(
+        FrameInfo& frameInfo, MeshletCullSystem* meshletCulling, Pipeline& standard, Pipeline& compact)
+    {
+        standard.bind(frameInfo.commandBuffer);
+        Model::VertexFormat boundFormat = Model::VertexFormat::Standard;
+        const Model* boundModel = nullptr;
+
+        for(const auto& draw : renderQueue.getDraws())
+        {
+            const auto& obj = frameInfo.objects[draw.item];
+
+            // both pipelines share the layout, the descriptor sets stay bound
+            if(obj.model->getVertexFormat() != boundFormat) {
+                boundFormat = obj.model->getVertexFormat();
+                auto& pipeline = boundFormat == Model::VertexFormat::Compact ? compact : standard;
+                pipeline.bind(frameInfo.commandBuffer);
+            }
+
             SimplePushConstantData push{};
-            push.modelMatrix =  obj.transform.mat4();
-            push.normalMatrix = obj.transform.normalMatrix();
+            push.modelMatrix =  obj.modelMatrix * obj.model->getDequantizeMatrix();
+            push.normalMatrix = glm::mat3x4(obj.normalMatrix);
+            push.materialIndex = obj.materialIndex;
 
             vkCmdPushConstants(frameInfo.commandBuffer, 
                 pipelineLayout, 
@@ -97,8 +182,43 @@ namespace Cosmos {
                 sizeof(SimplePushConstantData),
                 &push);
             
-            obj.model->bind(frameInfo.commandBuffer);
-            obj.model->draw(frameInfo.commandBuffer);
+            const uint32_t lod = selectLod(obj, frameInfo);
+            if(lod == 0 && meshletCulling && meshletCulling->drawCulled(frameInfo, obj))
+            {
+                boundModel = nullptr; // the compacted index buffer is bound now
+                continue;
+            }
+
+            // instances of a model are sorted together and share the vertex and index buffer bind
+            if(obj.model.get() != boundModel) {
+                obj.model->bind(frameInfo.commandBuffer);
+                boundModel = obj.model.get();
+            }
+            obj.model->draw(frameInfo.commandBuffer, lod);
+        }
+    }
+
+    // Coarsest LOD whose simplification error projects to at most lodErrorThreshold pixels
+    uint32_t SimpleRenderSystem::selectLod(const RenderObject& obj, const FrameInfo& frameInfo) const
+    {
+        const auto& model = *obj.model;
+        if(model.getLodCount() <= 1)
+            return 0;
+
+        const float maxScale = obj.maxScale;
+        const glm::vec3 center = glm::vec3(obj.modelMatrix * glm::vec4(model.getBoundingCenter(), 1.f));
+        // distance to the nearest point of the bounding sphere
+        const float distance = glm::length(center - frameInfo.camera.getPosition()) - model.getBoundingRadius() * maxScale;
+        if(distance <= 0.f)
+            return 0;
+
+        // projection[1][1] = 1 / tan(fovy / 2)
+        const float pixelsPerUnit = glm::abs(frameInfo.camera.getProjection()[1][1]) * .5f * frameInfo.extent.height / distance;
+        uint32_t lod = 0;
+        for(uint32_t level = 1; level < model.getLodCount(); level++) {
+            if(model.getLodError(level) * maxScale * pixelsPerUnit > lodErrorThreshold) break;
+            lod = level;
         }
+        return lod;
     }
 }
\ No newline at end of file
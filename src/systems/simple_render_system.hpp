@@ -1,19 +1,24 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include "pipeline.hpp"
+#include "render_queue.hpp"
 #include "engine_device.hpp"
 #include "game_object.hpp"
 #include "camera.hpp"
 #include "frame_info.hpp"
+#include "meshlet_cull_system.hpp"
 
 namespace Cosmos {
 
     class SimpleRenderSystem
     {
     public:
-        SimpleRenderSystem(EngineDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        // depthPrepass: renderGameObjects lays down depth first, then shades only the nearest surface of each pixel
+        SimpleRenderSystem(EngineDevice& device, const RenderTarget& renderTarget, VkDescriptorSetLayout globalSetLayout,
+            VkDescriptorSetLayout materialSetLayout, bool depthPrepass = false);
         ~SimpleRenderSystem();
 
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
@@ -21,15 +26,34 @@ namespace Cosmos {
 
         void run();
 
-        void renderGameObjects(FrameInfo& frameInfo);
+        // Draws sorted by vertex format and model, nearer instances of a model first.
+        // Objects culled by meshletCulling this frame are drawn from its compacted indices at LOD 0.
+        // Expects a cleared depth buffer with the depth prepass, both passes draw inside the same render pass
+        void renderGameObjects(FrameInfo& frameInfo, MeshletCullSystem* meshletCulling = nullptr);
+
+        // largest LOD error allowed on screen, in pixels
+        void setLodErrorThreshold(float pixels) { lodErrorThreshold = pixels; }
     
     private:
-        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout materialSetLayout);
+        void createPipeline(const RenderTarget& renderTarget);
+        void sortDraws(const FrameInfo& frameInfo);
+        // Same objects, LODs and transforms with either pair of pipelines, the depth EQUAL test relies on it
+        void drawObjects(FrameInfo& frameInfo, MeshletCullSystem* meshletCulling, Pipeline& standard, Pipeline& compact);
+        uint32_t selectLod(const RenderObject& obj, const FrameInfo& frameInfo) const;
 
         EngineDevice& engineDevice;
         std::unique_ptr<Pipeline> ptr_Pipeline;
+        std::unique_ptr<Pipeline> compactPipeline; // Model::VertexFormat::Compact
+        const bool depthPrepass;
+        std::unique_ptr<Pipeline> depthPipeline; // position only, no fragment shader, with depthPrepass
+        std::unique_ptr<Pipeline> depthCompactPipeline;
         VkPipelineLayout pipelineLayout;
+        float lodErrorThreshold = 1.f;
+
+        // render thread only, kept to reuse the storage
+        RenderQueue renderQueue{};
+        std::unordered_map<const Model*, uint32_t> meshIds{}; // mesh field of the sort keys, this frame only
 
     };
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine_device.hpp"
+
+namespace Cosmos {
+
+    class Texture {
+    public:
+
+        struct Builder {
+            std::vector<uint8_t> pixels{}; // tightly packed RGBA8
+            uint32_t width = 0;
+            uint32_t height = 0;
+            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+            bool generateMipmaps = true;
+
+            // Supports uncompressed/RLE truecolor .tga and binary .ppm
+            void loadImage(const std::string& filepath);
+        };
+
+        Texture(EngineDevice& device, const Texture::Builder& builder);
+        ~Texture();
+
+        Texture(const Texture&) = delete;
+        Texture& operator=(const Texture&) = delete;
+
+        static std::unique_ptr<Texture> createTextureFromFile(EngineDevice& device, const std::string& filepath);
+
+        VkImage getImage() const { return image; }
+        VkImageView getImageView() const { return imageView; }
+        VkFormat getFormat() const { return format; }
+        uint32_t getWidth() const { return width; }
+        uint32_t getHeight() const { return height; }
+        uint32_t getMipLevels() const { return mipLevels; }
+
+        VkDescriptorImageInfo descriptorInfo(VkSampler sampler) const;
+
+        static uint32_t calculateMipLevels(uint32_t width, uint32_t height);
+
+    private:
+        void createImage(const Texture::Builder& builder);
+        void uploadPixels(const Texture::Builder& builder);
+        void recordMipmapGeneration(VkCommandBuffer commandBuffer);
+        void createImageView();
+
+        EngineDevice& engineDevice;
+
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels = 1;
+    };
+}
@@ -0,0 +1,404 @@
+#include "texture_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    namespace TextureCompression {
+
+        namespace {
+
+            float srgbToLinear(uint8_t value)
+            {
+                float c = value / 255.f;
+                return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            uint8_t linearToSrgb(float c)
+            {
+                c = std::min(std::max(c, 0.f), 1.f);
+                float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+                return static_cast<uint8_t>(std::lround(s * 255.f));
+            }
+
+            uint8_t toByte(float value)
+            {
+                return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.f), 255.f)));
+            }
+
+            // Mean and dominant direction of the block colors (power iteration on the covariance)
+            void principalAxis(const float (*texels)[4], int channels, float* mean, float* axis)
+            {
+                for(int c = 0; c < 4; c++) {
+                    mean[c] = 0.f;
+                    axis[c] = 0.f;
+                }
+                for(int i = 0; i < 16; i++) {
+                    for(int c = 0; c < channels; c++) mean[c] += texels[i][c] / 16.f;
+                }
+
+                float covariance[4][4] = {};
+                for(int i = 0; i < 16; i++) {
+                    for(int a = 0; a < channels; a++) {
+                        for(int b = 0; b < channels; b++) {
+                            covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+                        }
+                    }
+                }
+
+                // start from the bounding box diagonal, converges in a few iterations
+                float minValue[4], maxValue[4];
+                for(int c = 0; c < channels; c++) {
+                    minValue[c] = std::numeric_limits<float>::max();
+                    maxValue[c] = std::numeric_limits<float>::lowest();
+                    for(int i = 0; i < 16; i++) {
+                        minValue[c] = std::min(minValue[c], texels[i][c]);
+                        maxValue[c] = std::max(maxValue[c], texels[i][c]);
+                    }
+                    axis[c] = maxValue[c] - minValue[c];
+                }
+
+                for(int iteration = 0; iteration < 8; iteration++) {
+                    float next[4] = {};
+                    for(int a = 0; a < channels; a++) {
+                        for(int b = 0; b < channels; b++) next[a] += covariance[a][b] * axis[b];
+                    }
+                    float length = 0.f;
+                    for(int c = 0; c < channels; c++) length += next[c] * next[c];
+                    length = std::sqrt(length);
+                    if(length < 1e-6f) break;
+                    for(int c = 0; c < channels; c++) axis[c] = next[c] / length;
+                }
+
+                float length = 0.f;
+                for(int c = 0; c < channels; c++) length += axis[c] * axis[c];
+                length = std::sqrt(length);
+                if(length > 1e-6f) {
+                    for(int c = 0; c < channels; c++) axis[c] /= length;
+                }
+            }
+
+            // Range fit: project onto the principal axis and take the extremes as endpoints
+            void fitEndpoints(const float (*texels)[4], int channels, float* low, float* high)
+            {
+                float mean[4], axis[4];
+                principalAxis(texels, channels, mean, axis);
+
+                float minT = std::numeric_limits<float>::max();
+                float maxT = std::numeric_limits<float>::lowest();
+                for(int i = 0; i < 16; i++) {
+                    float t = 0.f;
+                    for(int c = 0; c < channels; c++) t += (texels[i][c] - mean[c]) * axis[c];
+                    minT = std::min(minT, t);
+                    maxT = std::max(maxT, t);
+                }
+                for(int c = 0; c < 4; c++) {
+                    low[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * minT, 0.f), 255.f) : 0.f;
+                    high[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * maxT, 0.f), 255.f) : 0.f;
+                }
+            }
+
+            uint16_t packRgb565(const float* color)
+            {
+                uint16_t r = static_cast<uint16_t>(std::lround(color[0] * 31.f / 255.f));
+                uint16_t g = static_cast<uint16_t>(std::lround(color[1] * 63.f / 255.f));
+                uint16_t b = static_cast<uint16_t>(std::lround(color[2] * 31.f / 255.f));
+                return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+            }
+
+            void unpackRgb565(uint16_t packed, int* color)
+            {
+                int r = (packed >> 11) & 31;
+                int g = (packed >> 5) & 63;
+                int b = packed & 31;
+                color[0] = (r << 3) | (r >> 2);
+                color[1] = (g << 2) | (g >> 4);
+                color[2] = (b << 3) | (b >> 2);
+            }
+
+            class BitWriter {
+            public:
+                BitWriter(uint8_t* out, size_t byteCount) : out{out} { std::fill(out, out + byteCount, 0); }
+
+                void write(uint32_t value, int bits)
+                {
+                    for(int b = 0; b < bits; b++, position++) {
+                        if((value >> b) & 1u) out[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+                    }
+                }
+
+            private:
+                uint8_t* out;
+                uint32_t position = 0;
+            };
+
+            void gatherBlock(const ImageData& image, uint32_t blockX, uint32_t blockY, uint8_t* block)
+            {
+                for(uint32_t y = 0; y < 4; y++) {
+                    for(uint32_t x = 0; x < 4; x++) {
+                        // clamp to the edge for partial blocks
+                        uint32_t sx = std::min(blockX * 4 + x, image.width - 1);
+                        uint32_t sy = std::min(blockY * 4 + y, image.height - 1);
+                        const uint8_t* src = &image.pixels[(static_cast<size_t>(sy) * image.width + sx) * 4];
+                        std::copy(src, src + 4, block + (y * 4 + x) * 4);
+                    }
+                }
+            }
+        }
+
+        std::vector<ImageData> generateMipChain(const ImageData& source, bool srgb, bool normalMap)
+        {
+            std::vector<ImageData> chain{source};
+            while(chain.back().width > 1 || chain.back().height > 1)
+            {
+                const ImageData& src = chain.back();
+                ImageData dst{};
+                dst.width = std::max(src.width / 2, 1u);
+                dst.height = std::max(src.height / 2, 1u);
+                dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * 4);
+
+                for(uint32_t y = 0; y < dst.height; y++) {
+                    for(uint32_t x = 0; x < dst.width; x++) {
+                        const uint32_t xs[2] = {std::min(x * 2, src.width - 1), std::min(x * 2 + 1, src.width - 1)};
+                        const uint32_t ys[2] = {std::min(y * 2, src.height - 1), std::min(y * 2 + 1, src.height - 1)};
+
+                        float sum[4] = {};
+                        for(uint32_t sy : ys) {
+                            for(uint32_t sx : xs) {
+                                const uint8_t* texel = &src.pixels[(static_cast<size_t>(sy) * src.width + sx) * 4];
+                                for(int c = 0; c < 3; c++) {
+                                    if(srgb) sum[c] += srgbToLinear(texel[c]);
+                                    else if(normalMap) sum[c] += texel[c] / 127.5f - 1.f;
+                                    else sum[c] += texel[c];
+                                }
+                                sum[3] += texel[3];
+                            }
+                        }
+
+                        uint8_t* out = &dst.pixels[(static_cast<size_t>(y) * dst.width + x) * 4];
+                        if(normalMap) {
+                            float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                            if(length < 1e-6f) {
+                                sum[0] = sum[1] = 0.f;
+                                sum[2] = length = 1.f;
+                            }
+                            for(int c = 0; c < 3; c++) out[c] = toByte((sum[c] / length + 1.f) * 127.5f);
+                        } else {
+                            for(int c = 0; c < 3; c++) out[c] = srgb ? linearToSrgb(sum[c] / 4.f) : toByte(sum[c] / 4.f);
+                        }
+                        out[3] = toByte(sum[3] / 4.f);
+                    }
+                }
+                chain.push_back(std::move(dst));
+            }
+            return chain;
+        }
+
+        std::vector<uint8_t> compressImage(const ImageData& image, CookedTextureFormat format)
+        {
+            if(!isBlockCompressed(format)) {
+                return image.pixels;
+            }
+
+            const uint32_t blocksX = (image.width + 3) / 4;
+            const uint32_t blocksY = (image.height + 3) / 4;
+            const uint32_t blockSize = getBlockSize(format);
+            std::vector<uint8_t> compressed(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+            uint8_t block[16 * 4];
+            for(uint32_t by = 0; by < blocksY; by++) {
+                for(uint32_t bx = 0; bx < blocksX; bx++) {
+                    gatherBlock(image, bx, by, block);
+                    uint8_t* out = &compressed[(static_cast<size_t>(by) * blocksX + bx) * blockSize];
+                    switch(format) {
+                        case CookedTextureFormat::BC1_UNORM:
+                        case CookedTextureFormat::BC1_SRGB:
+                            encodeBlockBC1(block, out);
+                            break;
+                        case CookedTextureFormat::BC5_UNORM:
+                            encodeBlockBC5(block, out);
+                            break;
+                        case CookedTextureFormat::BC7_UNORM:
+                        case CookedTextureFormat::BC7_SRGB:
+                            encodeBlockBC7(block, out);
+                            break;
+                        default:
+                            throw std::runtime_error("unsupported block compression format!");
+                    }
+                }
+            }
+            return compressed;
+        }
+
+        void encodeBlockBC1(const uint8_t* block, uint8_t* out)
+        {
+            float texels[16][4];
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) texels[i][c] = c < 3 ? block[i * 4 + c] : 0.f;
+            }
+
+            float low[4], high[4];
+            fitEndpoints(texels, 3, low, high);
+
+            uint16_t color0 = packRgb565(high);
+            uint16_t color1 = packRgb565(low);
+            // color0 > color1 selects the opaque four color mode
+            if(color0 < color1) std::swap(color0, color1);
+
+            int palette[4][3];
+            unpackRgb565(color0, palette[0]);
+            unpackRgb565(color1, palette[1]);
+            for(int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            uint32_t indices = 0;
+            if(color0 != color1) {
+                for(int i = 0; i < 16; i++) {
+                    int bestIndex = 0;
+                    int bestError = std::numeric_limits<int>::max();
+                    for(int p = 0; p < 4; p++) {
+                        int error = 0;
+                        for(int c = 0; c < 3; c++) {
+                            int d = block[i * 4 + c] - palette[p][c];
+                            error += d * d;
+                        }
+                        if(error < bestError) {
+                            bestError = error;
+                            bestIndex = p;
+                        }
+                    }
+                    indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+                }
+            }
+
+            out[0] = color0 & 0xff;
+            out[1] = color0 >> 8;
+            out[2] = color1 & 0xff;
+            out[3] = color1 >> 8;
+            for(int b = 0; b < 4; b++) out[4 + b] = (indices >> (8 * b)) & 0xff;
+        }
+
+        void encodeBlockBC4(const uint8_t* block, int channel, uint8_t* out)
+        {
+            int minValue = 255;
+            int maxValue = 0;
+            for(int i = 0; i < 16; i++) {
+                minValue = std::min<int>(minValue, block[i * 4 + channel]);
+                maxValue = std::max<int>(maxValue, block[i * 4 + channel]);
+            }
+
+            // red0 > red1 selects the eight value mode
+            out[0] = static_cast<uint8_t>(maxValue);
+            out[1] = static_cast<uint8_t>(minValue);
+            uint64_t indices = 0;
+            if(maxValue != minValue) {
+                int palette[8];
+                palette[0] = maxValue;
+                palette[1] = minValue;
+                for(int p = 2; p < 8; p++) palette[p] = ((8 - p) * maxValue + (p - 1) * minValue) / 7;
+
+                for(int i = 0; i < 16; i++) {
+                    int value = block[i * 4 + channel];
+                    int bestIndex = 0;
+                    for(int p = 1; p < 8; p++) {
+                        if(std::abs(palette[p] - value) < std::abs(palette[bestIndex] - value)) bestIndex = p;
+                    }
+                    indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+                }
+            }
+            for(int b = 0; b < 6; b++) out[2 + b] = (indices >> (8 * b)) & 0xff;
+        }
+
+        void encodeBlockBC5(const uint8_t* block, uint8_t* out)
+        {
+            encodeBlockBC4(block, 0, out);
+            encodeBlockBC4(block, 1, out + 8);
+        }
+
+        // BC7 mode 6: one subset, RGBA endpoints with 7 bits + unique p-bit, 4 bit indices.
+        // Not as good as a full mode search, but handles alpha and smooth gradients well.
+        void encodeBlockBC7(const uint8_t* block, uint8_t* out)
+        {
+            static const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+            float texels[16][4];
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) texels[i][c] = block[i * 4 + c];
+            }
+
+            float endpoints[2][4];
+            fitEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+            // quantize to 7 bits per channel, pick the p-bit with the lower error
+            int quantized[2][4];
+            int pbits[2];
+            int expanded[2][4];
+            for(int e = 0; e < 2; e++) {
+                float bestError = std::numeric_limits<float>::max();
+                for(int p = 0; p < 2; p++) {
+                    float error = 0.f;
+                    int q[4];
+                    for(int c = 0; c < 4; c++) {
+                        q[c] = std::min(std::max(static_cast<int>(std::lround((endpoints[e][c] - p) / 2.f)), 0), 127);
+                        float d = static_cast<float>((q[c] << 1) | p) - endpoints[e][c];
+                        error += d * d;
+                    }
+                    if(error < bestError) {
+                        bestError = error;
+                        pbits[e] = p;
+                        for(int c = 0; c < 4; c++) quantized[e][c] = q[c];
+                    }
+                }
+                for(int c = 0; c < 4; c++) expanded[e][c] = (quantized[e][c] << 1) | pbits[e];
+            }
+
+            int palette[16][4];
+            for(int w = 0; w < 16; w++) {
+                for(int c = 0; c < 4; c++) {
+                    palette[w][c] = (expanded[0][c] * (64 - weights[w]) + expanded[1][c] * weights[w] + 32) >> 6;
+                }
+            }
+
+            int indices[16];
+            for(int i = 0; i < 16; i++) {
+                int bestIndex = 0;
+                int bestError = std::numeric_limits<int>::max();
+                for(int w = 0; w < 16; w++) {
+                    int error = 0;
+                    for(int c = 0; c < 4; c++) {
+                        int d = block[i * 4 + c] - palette[w][c];
+                        error += d * d;
+                    }
+                    if(error < bestError) {
+                        bestError = error;
+                        bestIndex = w;
+                    }
+                }
+                indices[i] = bestIndex;
+            }
+
+            // the anchor index is stored without its top bit, so it must be < 8
+            if(indices[0] & 8) {
+                for(int c = 0; c < 4; c++) std::swap(quantized[0][c], quantized[1][c]);
+                std::swap(pbits[0], pbits[1]);
+                for(int i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+            }
+
+            BitWriter writer{out, 16};
+            writer.write(1u << 6, 7); // mode 6
+            for(int c = 0; c < 4; c++) {
+                writer.write(quantized[0][c], 7);
+                writer.write(quantized[1][c], 7);
+            }
+            writer.write(pbits[0], 1);
+            writer.write(pbits[1], 1);
+            writer.write(indices[0], 3);
+            for(int i = 1; i < 16; i++) writer.write(indices[i], 4);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "cooked_texture.hpp"
+#include "image_loader.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Cosmos {
+
+    // Offline texture cooking: mip generation and BCn block encoding (CPU only)
+    namespace TextureCompression {
+
+        // Box filtered mip chain down to 1x1, level 0 is the source image.
+        // srgb: filter in linear space. normalMap: renormalize the xyz vector stored in rgb.
+        std::vector<ImageData> generateMipChain(const ImageData& source, bool srgb, bool normalMap);
+
+        // Encodes RGBA8 pixels into the given format (rows padded to whole 4x4 blocks)
+        std::vector<uint8_t> compressImage(const ImageData& image, CookedTextureFormat format);
+
+        // Single 4x4 block encoders, block is 16 RGBA8 texels in row order
+        void encodeBlockBC1(const uint8_t* block, uint8_t* out);  // 8 bytes, rgb
+        void encodeBlockBC4(const uint8_t* block, int channel, uint8_t* out); // 8 bytes, one channel
+        void encodeBlockBC5(const uint8_t* block, uint8_t* out);  // 16 bytes, rg
+        void encodeBlockBC7(const uint8_t* block, uint8_t* out);  // 16 bytes, rgba (mode 6)
+    }
+}
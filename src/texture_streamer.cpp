@@ -0,0 +1,457 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace Cosmos {
+
+    namespace {
+
+        constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+        VkDeviceSize alignStaging(VkDeviceSize size)
+        {
+            return (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        }
+    }
+
+    TextureStreamer::TextureStreamer(EngineDevice& device, MaterialSystem& materialSystem, uint32_t framesInFlight,
+        const Settings& settings)
+        : engineDevice{device}, materialSystem{materialSystem}, settings{settings}
+    {
+        stagingBuffers.resize(framesInFlight);
+        for(auto& stagingBuffer : stagingBuffers) {
+            stagingBuffer = std::make_unique<Buffer>(
+                engineDevice,
+                settings.stagingBufferSize,
+                1,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            stagingBuffer->map();
+        }
+
+        worker = std::thread(&TextureStreamer::workerLoop, this);
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            stopWorker = true;
+        }
+        queueCondition.notify_all();
+        worker.join();
+
+        for(auto& texture : textures) {
+            retireResidentImage(texture.resident);
+        }
+    }
+
+    VkFormat TextureStreamer::toVkFormat(CookedTextureFormat format) const
+    {
+        if(isBlockCompressed(format) && !engineDevice.supportsTextureCompressionBC()) {
+            throw std::runtime_error("device does not support BC textures, cook them with --format rgba8!");
+        }
+        switch(format) {
+            case CookedTextureFormat::RGBA8_UNORM: return VK_FORMAT_R8G8B8A8_UNORM;
+            case CookedTextureFormat::RGBA8_SRGB: return VK_FORMAT_R8G8B8A8_SRGB;
+            case CookedTextureFormat::BC1_UNORM: return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            case CookedTextureFormat::BC1_SRGB: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            case CookedTextureFormat::BC5_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+            case CookedTextureFormat::BC7_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
+            case CookedTextureFormat::BC7_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
+        }
+        throw std::runtime_error("unknown cooked texture format!");
+    }
+
+    std::vector<uint32_t> TextureStreamer::loadTextures(const std::vector<std::string>& filepaths)
+    {
+        const size_t first = textures.size();
+        VkDeviceSize stagingSize = 0;
+        for(const auto& filepath : filepaths)
+        {
+            StreamedTexture texture{};
+            texture.file = std::make_unique<CookedTextureFile>(filepath);
+            texture.format = toVkFormat(texture.file->getHeader().format);
+
+            // smallest mip tail that stays below initialMaxDimension
+            const uint32_t mipCount = texture.file->getMipCount();
+            texture.baseMip = 0;
+            while(texture.baseMip + 1 < mipCount) {
+                const auto& level = texture.file->getLevel(texture.baseMip);
+                if(std::max(level.width, level.height) <= settings.initialMaxDimension) break;
+                texture.baseMip++;
+            }
+            stagingSize += alignStaging(texture.file->getLevelsSize(texture.baseMip, mipCount - texture.baseMip));
+
+            texture.bindlessIndex = materialSystem.reserveTextureSlot();
+            bindlessToTexture[texture.bindlessIndex] = static_cast<uint32_t>(textures.size());
+            textures.push_back(std::move(texture));
+        }
+
+        std::vector<uint32_t> indices;
+        if(stagingSize == 0) {
+            return indices;
+        }
+
+        // every tail goes through one staging buffer and one submission
+        Buffer stagingBuffer{
+            engineDevice,
+            stagingSize,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+        stagingBuffer.map();
+        auto* mapped = static_cast<uint8_t*>(stagingBuffer.getMappedMemory());
+
+        VkCommandBuffer commandBuffer = engineDevice.beginSingleTimeCommands();
+        VkDeviceSize stagingOffset = 0;
+        for(size_t i = first; i < textures.size(); i++)
+        {
+            auto& texture = textures[i];
+            const uint32_t levelCount = texture.file->getMipCount() - texture.baseMip;
+            VkDeviceSize written = texture.file->readLevels(texture.baseMip, levelCount, mapped + stagingOffset);
+            recordResidentChange(commandBuffer, texture, texture.baseMip, stagingBuffer.getBuffer(), stagingOffset);
+            stagingOffset += alignStaging(written);
+            indices.push_back(texture.bindlessIndex);
+        }
+        engineDevice.endSingleTimeCommands(commandBuffer);
+
+        return indices;
+    }
+
+    void TextureStreamer::requestResolution(uint32_t textureIndex, float screenPixels)
+    {
+        auto it = bindlessToTexture.find(textureIndex);
+        if(it == bindlessToTexture.end()) return;
+        auto& texture = textures[it->second];
+        texture.requestedPixels = std::max(texture.requestedPixels, screenPixels);
+    }
+
+    uint32_t TextureStreamer::desiredMip(const StreamedTexture& texture) const
+    {
+        if(texture.requestedPixels <= 0.f) {
+            return texture.baseMip;
+        }
+        const auto& header = texture.file->getHeader();
+        const float size = static_cast<float>(std::max(header.width, header.height));
+        // one texel per pixel
+        const float mip = std::floor(std::log2(size / texture.requestedPixels));
+        return static_cast<uint32_t>(std::min(std::max(mip, 0.f), static_cast<float>(texture.baseMip)));
+    }
+
+    void TextureStreamer::update(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        uploadFinishedLoads(commandBuffer, frameIndex);
+        requestLoads(commandBuffer);
+
+        // requests are per frame
+        for(auto& texture : textures) {
+            texture.requestedPixels = 0.f;
+        }
+    }
+
+    void TextureStreamer::uploadFinishedLoads(VkCommandBuffer commandBuffer, int frameIndex)
+    {
+        std::deque<LoadResult> finished;
+        {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            finished.swap(loadResults);
+        }
+
+        auto& stagingBuffer = *stagingBuffers[frameIndex];
+        auto* mapped = static_cast<uint8_t*>(stagingBuffer.getMappedMemory());
+        VkDeviceSize stagingOffset = 0;
+        while(!finished.empty())
+        {
+            auto& result = finished.front();
+            if(result.data.empty()) {
+                // read failed, the texture stays marked as loading so it is not retried every frame
+                loadingBytes -= result.estimatedBytes;
+                finished.pop_front();
+                continue;
+            }
+            const VkDeviceSize size = alignStaging(result.data.size());
+            if(stagingOffset + size > stagingBuffer.getBufferSize()) {
+                break; // out of upload budget this frame, the rest goes next frame
+            }
+            std::memcpy(mapped + stagingOffset, result.data.data(), result.data.size());
+
+            auto& texture = textures[result.texture];
+            recordResidentChange(commandBuffer, texture, result.firstMip, stagingBuffer.getBuffer(), stagingOffset);
+            texture.loading = false;
+            loadingBytes -= result.estimatedBytes;
+            stagingOffset += size;
+            finished.pop_front();
+        }
+
+        if(!finished.empty()) {
+            std::lock_guard<std::mutex> lock{queueMutex};
+            while(!finished.empty()) {
+                loadResults.push_front(std::move(finished.back()));
+                finished.pop_back();
+            }
+        }
+    }
+
+    void TextureStreamer::requestLoads(VkCommandBuffer commandBuffer)
+    {
+        std::vector<uint32_t> wanted;
+        std::vector<uint32_t> trimmable;
+        for(uint32_t i = 0; i < textures.size(); i++) {
+            const auto& texture = textures[i];
+            if(texture.loading) continue;
+            const uint32_t mip = desiredMip(texture);
+            if(mip < texture.resident.firstMip) wanted.push_back(i);
+            else if(mip > texture.resident.firstMip) trimmable.push_back(i);
+        }
+        if(wanted.empty()) return;
+
+        // biggest on screen first, smallest on screen are evicted first
+        std::sort(wanted.begin(), wanted.end(), [&](uint32_t a, uint32_t b) {
+            return textures[a].requestedPixels > textures[b].requestedPixels;
+        });
+        std::sort(trimmable.begin(), trimmable.end(), [&](uint32_t a, uint32_t b) {
+            return textures[a].requestedPixels < textures[b].requestedPixels;
+        });
+
+        size_t nextTrim = 0;
+        std::vector<LoadRequest> requests;
+        for(uint32_t index : wanted)
+        {
+            auto& texture = textures[index];
+            const uint32_t target = desiredMip(texture);
+            const uint32_t current = texture.resident.firstMip;
+
+            // step up as far as one frame's staging buffer allows
+            uint32_t firstMip = current;
+            while(firstMip > target &&
+                alignStaging(texture.file->getLevelsSize(firstMip - 1, current - firstMip + 1)) <= settings.stagingBufferSize) {
+                firstMip--;
+            }
+            if(firstMip == current) continue;
+
+            // estimate, the real size is known once the image exists
+            const VkDeviceSize extraBytes = texture.file->getLevelsSize(firstMip, current - firstMip);
+            while(residentBytes + loadingBytes + extraBytes > settings.memoryBudget && nextTrim < trimmable.size()) {
+                auto& victim = textures[trimmable[nextTrim++]];
+                recordResidentChange(commandBuffer, victim, desiredMip(victim), VK_NULL_HANDLE, 0);
+            }
+            if(residentBytes + loadingBytes + extraBytes > settings.memoryBudget) break;
+
+            texture.loading = true;
+            loadingBytes += extraBytes;
+            requests.push_back({index, texture.file.get(), firstMip, current - firstMip});
+        }
+
+        if(!requests.empty()) {
+            {
+                std::lock_guard<std::mutex> lock{queueMutex};
+                loadRequests.insert(loadRequests.end(), requests.begin(), requests.end());
+            }
+            queueCondition.notify_one();
+        }
+    }
+
+    void TextureStreamer::workerLoop()
+    {
+        while(true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock{queueMutex};
+                queueCondition.wait(lock, [this] { return stopWorker || !loadRequests.empty(); });
+                if(stopWorker) return;
+                request = loadRequests.front();
+                loadRequests.pop_front();
+            }
+
+            LoadResult result{};
+            result.texture = request.texture;
+            result.firstMip = request.firstMip;
+            result.estimatedBytes = request.file->getLevelsSize(request.firstMip, request.mipCount);
+            result.data.resize(result.estimatedBytes);
+            try {
+                request.file->readLevels(request.firstMip, request.mipCount, result.data.data());
+            } catch (const std::exception& e) {
+                // keep the resolution we have
+                std::cerr << e.what() << std::endl;
+                result.data.clear();
+            }
+
+            std::lock_guard<std::mutex> lock{queueMutex};
+            loadResults.push_back(std::move(result));
+        }
+    }
+
+    TextureStreamer::ResidentImage TextureStreamer::createResidentImage(const StreamedTexture& texture, uint32_t firstMip)
+    {
+        const auto& level = texture.file->getLevel(firstMip);
+        ResidentImage resident{};
+        resident.firstMip = firstMip;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = level.width;
+        imageInfo.extent.height = level.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = texture.file->getMipCount() - firstMip;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = texture.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        engineDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, resident.image, resident.memory);
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(engineDevice.device(), resident.image, &memRequirements);
+        resident.bytes = memRequirements.size;
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = resident.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = texture.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        if(vkCreateImageView(engineDevice.device(), &viewInfo, nullptr, &resident.view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create streamed texture image view!");
+        }
+        return resident;
+    }
+
+    void TextureStreamer::retireResidentImage(ResidentImage& image)
+    {
+        if(image.image == VK_NULL_HANDLE) return;
+        engineDevice.retire([device = engineDevice.device(), retired = image]() {
+            vkDestroyImageView(device, retired.view, nullptr);
+            vkDestroyImage(device, retired.image, nullptr);
+            vkFreeMemory(device, retired.memory, nullptr);
+        });
+        image = ResidentImage{};
+    }
+
+    void TextureStreamer::recordResidentChange(
+        VkCommandBuffer commandBuffer,
+        StreamedTexture& texture,
+        uint32_t firstMip,
+        VkBuffer stagingBuffer,
+        VkDeviceSize stagingOffset)
+    {
+        ResidentImage previous = texture.resident;
+        ResidentImage next = createResidentImage(texture, firstMip);
+        const uint32_t mipCount = texture.file->getMipCount();
+        // file levels [firstMip, stagedEnd) are in the staging buffer, [stagedEnd, mipCount) in the previous image
+        const uint32_t stagedEnd = previous.image != VK_NULL_HANDLE ? std::max(previous.firstMip, firstMip) : mipCount;
+        assert((stagedEnd == firstMip || stagingBuffer != VK_NULL_HANDLE) && "Missing mip data for streamed texture");
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        barrier.image = next.image;
+        barrier.subresourceRange.levelCount = mipCount - firstMip;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        std::vector<VkBufferImageCopy> bufferCopies;
+        VkDeviceSize offset = stagingOffset;
+        for(uint32_t mip = firstMip; mip < stagedEnd; mip++) {
+            const auto& level = texture.file->getLevel(mip);
+            VkBufferImageCopy region{};
+            region.bufferOffset = offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = mip - firstMip;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {level.width, level.height, 1};
+            bufferCopies.push_back(region);
+            offset += level.size;
+        }
+        if(!bufferCopies.empty()) {
+            vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, next.image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(bufferCopies.size()), bufferCopies.data());
+        }
+
+        if(previous.image != VK_NULL_HANDLE)
+        {
+            // frames in flight still sample the previous image, hand it back in the layout they expect
+            barrier.image = previous.image;
+            barrier.subresourceRange.levelCount = mipCount - previous.firstMip;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+
+            std::vector<VkImageCopy> imageCopies;
+            for(uint32_t mip = stagedEnd; mip < mipCount; mip++) {
+                const auto& level = texture.file->getLevel(mip);
+                VkImageCopy region{};
+                region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - previous.firstMip, 0, 1};
+                region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - firstMip, 0, 1};
+                region.srcOffset = {0, 0, 0};
+                region.dstOffset = {0, 0, 0};
+                region.extent = {level.width, level.height, 1};
+                imageCopies.push_back(region);
+            }
+            vkCmdCopyImage(commandBuffer,
+                previous.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                next.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(imageCopies.size()), imageCopies.data());
+
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+
+            residentBytes -= previous.bytes;
+            // the copy above and earlier frames still read it
+            retireResidentImage(previous);
+        }
+
+        barrier.image = next.image;
+        barrier.subresourceRange.levelCount = mipCount - firstMip;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        residentBytes += next.bytes;
+        texture.resident = next;
+        materialSystem.setTextureView(texture.bindlessIndex, next.view);
+    }
+}
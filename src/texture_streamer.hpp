@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "engine_device.hpp"
+#include "buffer.hpp"
+#include "cooked_texture.hpp"
+#include "material_system.hpp"
+
+namespace Cosmos {
+
+    /*
+    Streams cooked (.ctex) textures into the bindless texture array.
+    loadTextures uploads only the small tail of every mip chain in one batched submission,
+    so big texture sets load fast and start out cheap. Every frame the renderer reports how
+    large a texture appears on screen; missing higher mips are read on a worker thread and
+    their upload is recorded into the frame's command buffer, bounded by a per frame staging buffer.
+    A texture changing resolution gets a new image (the mips it already had are copied on the GPU),
+    the old image is destroyed once no frame in flight can reference it. When over the memory
+    budget, textures that appear small drop their top mips again.
+    */
+    class TextureStreamer {
+    public:
+        struct Settings {
+            VkDeviceSize stagingBufferSize = 16 * 1024 * 1024; // per frame in flight, caps uploads per frame
+            uint32_t initialMaxDimension = 64;                 // resident after loading, never evicted
+            VkDeviceSize memoryBudget = 512ull * 1024 * 1024;  // device memory for all streamed images
+        };
+
+        TextureStreamer(EngineDevice& device, MaterialSystem& materialSystem, uint32_t framesInFlight,
+            const Settings& settings = Settings{});
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Returns the bindless texture index of every file
+        std::vector<uint32_t> loadTextures(const std::vector<std::string>& filepaths);
+        uint32_t loadTexture(const std::string& filepath) { return loadTextures({filepath})[0]; }
+
+        // Largest on screen dimension in pixels, call every frame the texture is visible
+        void requestResolution(uint32_t textureIndex, float screenPixels);
+
+        // Records this frame's uploads, call outside a render pass and before MaterialSystem::beginFrame
+        void update(VkCommandBuffer commandBuffer, int frameIndex);
+
+        bool isStreamed(uint32_t textureIndex) const { return bindlessToTexture.count(textureIndex) != 0; }
+        VkDeviceSize getResidentBytes() const { return residentBytes; }
+
+    private:
+        struct ResidentImage {
+            VkImage image = VK_NULL_HANDLE;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            uint32_t firstMip = 0; // file level stored in image level 0
+            VkDeviceSize bytes = 0;
+        };
+
+        struct StreamedTexture {
+            std::unique_ptr<CookedTextureFile> file;
+            VkFormat format;
+            uint32_t bindlessIndex;
+            uint32_t baseMip; // first level of the always resident tail
+            ResidentImage resident{};
+            float requestedPixels = 0.f;
+            bool loading = false;
+        };
+
+        struct LoadRequest {
+            uint32_t texture;
+            const CookedTextureFile* file;
+            uint32_t firstMip;
+            uint32_t mipCount;
+        };
+
+        struct LoadResult {
+            uint32_t texture;
+            uint32_t firstMip;
+            VkDeviceSize estimatedBytes;
+            std::vector<uint8_t> data;
+        };
+
+        VkFormat toVkFormat(CookedTextureFormat format) const;
+        uint32_t desiredMip(const StreamedTexture& texture) const;
+        ResidentImage createResidentImage(const StreamedTexture& texture, uint32_t firstMip);
+        void retireResidentImage(ResidentImage& image);
+        // Replaces the texture's image by one starting at firstMip. Levels above the current image
+        // come from the staging buffer, the rest is copied from the current image.
+        void recordResidentChange(
+            VkCommandBuffer commandBuffer,
+            StreamedTexture& texture,
+            uint32_t firstMip,
+            VkBuffer stagingBuffer,
+            VkDeviceSize stagingOffset);
+        void uploadFinishedLoads(VkCommandBuffer commandBuffer, int frameIndex);
+        void requestLoads(VkCommandBuffer commandBuffer);
+        void workerLoop();
+
+        EngineDevice& engineDevice;
+        MaterialSystem& materialSystem;
+        Settings settings;
+
+        std::vector<StreamedTexture> textures;
+        std::unordered_map<uint32_t, uint32_t> bindlessToTexture;
+        std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+        VkDeviceSize residentBytes = 0;
+        VkDeviceSize loadingBytes = 0;
+
+        std::thread worker;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        std::deque<LoadRequest> loadRequests;
+        std::deque<LoadResult> loadResults;
+        bool stopWorker = false;
+    };
+}
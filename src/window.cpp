@@ -41,6 +41,10 @@ namespace Cosmos {
         glfwPollEvents();
     }
 
+    void Window::waitEvents() {
+        glfwWaitEvents();
+    }
+
     void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
     {
         if(glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS) {
@@ -3,6 +3,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <string>
+#include <atomic>
 
 namespace Cosmos {
     
@@ -17,6 +18,7 @@ namespace Cosmos {
 
         bool shouldClose();
         void pollEvents();
+        void waitEvents();
         
         void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
         
@@ -31,9 +33,10 @@ namespace Cosmos {
         void initWindow();
         
 
-        int WIDTH = 800;
-        int HEIGHT = 600;
-        bool framebufferResized = false; // flag to see if window resized
+        // written by the event callbacks on the main thread, read by the render thread
+        std::atomic<int> WIDTH{800};
+        std::atomic<int> HEIGHT{600};
+        std::atomic<bool> framebufferResized{false}; // flag to see if window resized
 
         std::string windowName;
         GLFWwindow* window;
@@ -0,0 +1,197 @@
+#include "world_partition.hpp"
+
+#include "scene_loader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace Cosmos {
+
+    WorldPartition::WorldPartition(const std::string& scenePath, AssetManager& assetManager,
+        GameObject::Map& gameObjects) : WorldPartition{scenePath, assetManager, gameObjects, Settings{}} {}
+
+    WorldPartition::WorldPartition(const std::string& scenePath, AssetManager& assetManager,
+        GameObject::Map& gameObjects, const Settings& settings)
+        : scene{SceneFile::load(scenePath)}, assetManager{assetManager}, gameObjects{gameObjects}, settings{settings}
+    {
+        if(settings.cellSize <= 0.f || settings.unloadRadius < settings.loadRadius) {
+            throw std::invalid_argument("world partition needs a positive cell size and unloadRadius >= loadRadius");
+        }
+
+        for(uint32_t i = 0; i < scene.entities.size(); i++) {
+            const SceneEntity& entity = scene.entities[i];
+            const auto x = static_cast<int32_t>(std::floor(entity.translation[0] / settings.cellSize));
+            const auto z = static_cast<int32_t>(std::floor(entity.translation[2] / settings.cellSize));
+            Cell& cell = cells[getCellKey(x, z)];
+            cell.x = x;
+            cell.z = z;
+            cell.entities.push_back(i);
+            if(entity.model != SceneEntity::NO_MODEL) cell.models.push_back(entity.model);
+        }
+        for(auto& kv : cells) {
+            auto& models = kv.second.models;
+            std::sort(models.begin(), models.end());
+            models.erase(std::unique(models.begin(), models.end()), models.end());
+        }
+    }
+
+    WorldPartition::~WorldPartition()
+    {
+        // the loads reference the asset manager
+        for(auto& kv : cells) {
+            if(kv.second.state == CellState::Loading) kv.second.pendingModels.wait();
+        }
+    }
+
+    void WorldPartition::update(const glm::vec3& viewerPosition)
+    {
+        std::vector<std::pair<float, Cell*>> wanted;
+        std::vector<std::pair<float, Cell*>> outsideLoadRadius;
+        uint32_t loading = 0;
+        for(auto& kv : cells) {
+            Cell& cell = kv.second;
+            const float distance = getDistance(cell, viewerPosition);
+            switch(cell.state) {
+                case CellState::Loading:
+                    if(cell.pendingModels.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                        loading++;
+                    } else if(distance <= settings.unloadRadius) {
+                        finishLoad(cell);
+                    } else {
+                        // the viewer left before it finished, the models go back to the asset cache
+                        cell.pendingModels = {};
+                        cell.state = CellState::Unloaded;
+                    }
+                    break;
+                case CellState::Loaded:
+                    if(distance > settings.unloadRadius) {
+                        unload(cell);
+                    } else if(distance > settings.loadRadius) {
+                        outsideLoadRadius.emplace_back(distance, &cell);
+                    }
+                    break;
+                case CellState::Unloaded:
+                    if(distance <= settings.loadRadius) wanted.emplace_back(distance, &cell);
+                    break;
+            }
+        }
+
+        // over budget: give up the farthest cells the viewer is not about to need
+        std::sort(outsideLoadRadius.begin(), outsideLoadRadius.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+        for(auto& [distance, cell] : outsideLoadRadius) {
+            if(loadedBytes <= settings.memoryBudget) break;
+            unload(*cell);
+        }
+
+        std::sort(wanted.begin(), wanted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for(auto& [distance, cell] : wanted) {
+            if(loading >= settings.maxConcurrentLoads || loadedBytes >= settings.memoryBudget) break;
+            startLoad(*cell);
+            loading++;
+        }
+    }
+
+    void WorldPartition::loadAround(const glm::vec3& viewerPosition)
+    {
+        update(viewerPosition);
+        while(getPendingCellCount() > 0) {
+            for(auto& kv : cells) {
+                if(kv.second.state == CellState::Loading) kv.second.pendingModels.wait();
+            }
+            update(viewerPosition);
+        }
+    }
+
+    size_t WorldPartition::getLoadedCellCount() const
+    {
+        return std::count_if(cells.begin(), cells.end(),
+            [](const auto& kv) { return kv.second.state == CellState::Loaded; });
+    }
+
+    size_t WorldPartition::getPendingCellCount() const
+    {
+        return std::count_if(cells.begin(), cells.end(),
+            [](const auto& kv) { return kv.second.state == CellState::Loading; });
+    }
+
+    void WorldPartition::startLoad(Cell& cell)
+    {
+        std::vector<std::pair<std::string, Model::Builder>> requests;
+        requests.reserve(cell.models.size());
+        for(uint32_t model : cell.models) {
+            requests.emplace_back(scene.models[model].path, getImportSettings(scene.models[model]));
+        }
+
+        // even the content hashing of a new path reads the file, keep all of it off the render thread
+        AssetManager& assets = assetManager;
+        cell.pendingModels = std::async(std::launch::async, [&assets, requests = std::move(requests)]() {
+            std::vector<std::shared_future<std::shared_ptr<Model>>> futures;
+            futures.reserve(requests.size());
+            for(const auto& [path, importSettings] : requests) {
+                futures.push_back(assets.loadModelAsync(path, importSettings));
+            }
+            std::vector<std::shared_ptr<Model>> models;
+            models.reserve(futures.size());
+            for(auto& future : futures) models.push_back(future.get());
+            return models;
+        });
+        cell.state = CellState::Loading;
+    }
+
+    void WorldPartition::finishLoad(Cell& cell)
+    {
+        cell.state = CellState::Loaded;
+        std::vector<std::shared_ptr<Model>> models;
+        try {
+            models = cell.pendingModels.get();
+        } catch(const std::exception& e) {
+            // stays empty until the viewer leaves and comes back
+            std::cerr << "World cell (" << cell.x << ", " << cell.z << ") failed to load: " << e.what() << "\n";
+            return;
+        }
+
+        cell.bytes = 0;
+        for(const auto& model : models) cell.bytes += model->getDeviceMemorySize();
+        loadedBytes += cell.bytes;
+
+        cell.gameObjects.reserve(cell.entities.size());
+        for(uint32_t index : cell.entities) {
+            const SceneEntity& entity = scene.entities[index];
+            GameObject gameObject = instantiateEntity(entity, settings.materialCount);
+            if(entity.model != SceneEntity::NO_MODEL) {
+                auto it = std::lower_bound(cell.models.begin(), cell.models.end(), entity.model);
+                gameObject.model = models[it - cell.models.begin()];
+            }
+            cell.gameObjects.push_back(gameObject.getId());
+            gameObjects.emplace(gameObject.getId(), std::move(gameObject));
+        }
+    }
+
+    void WorldPartition::unload(Cell& cell)
+    {
+        for(GameObject::id_t id : cell.gameObjects) gameObjects.erase(id);
+        cell.gameObjects.clear();
+        loadedBytes -= cell.bytes;
+        cell.bytes = 0;
+        cell.state = CellState::Unloaded;
+    }
+
+    uint64_t WorldPartition::getCellKey(int32_t x, int32_t z)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+
+    float WorldPartition::getDistance(const Cell& cell, const glm::vec3& viewerPosition) const
+    {
+        const float minX = cell.x * settings.cellSize;
+        const float minZ = cell.z * settings.cellSize;
+        const float dx = std::max({minX - viewerPosition.x, 0.f, viewerPosition.x - (minX + settings.cellSize)});
+        const float dz = std::max({minZ - viewerPosition.z, 0.f, viewerPosition.z - (minZ + settings.cellSize)});
+        return std::sqrt(dx * dx + dz * dz);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "asset_manager.hpp"
+#include "game_object.hpp"
+#include "scene_file.hpp"
+
+namespace Cosmos {
+
+    /*
+    Streams a scene in square cells on the XZ plane around the viewer. Entities belong to the cell
+    containing their translation. Cells closer than loadRadius are loaded nearest first, their models
+    import on worker threads and the game objects are only added once every model is uploaded, so the
+    render loop never waits. Cells are removed again beyond unloadRadius (> loadRadius, the gap keeps
+    cells on a border from reloading every frame). Above the memory budget no new cells are started
+    and cells outside loadRadius are dropped farthest first.
+    Removed models stay in the AssetManager, which destroys them once no frame uses them.
+    */
+    class WorldPartition {
+    public:
+        struct Settings {
+            float cellSize = 32.f;
+            float loadRadius = 64.f;
+            float unloadRadius = 96.f;
+            uint32_t maxConcurrentLoads = 2; // cells importing at the same time
+            // device memory of the models of loaded cells, a model used by several cells counts for each.
+            // Sizes are known once a cell finished, so cells in flight can overshoot it
+            VkDeviceSize memoryBudget = 1024ull * 1024 * 1024;
+            // MaterialSystem::getMaterialCount(), entities using other materials get material 0
+            uint32_t materialCount = 1;
+        };
+
+        WorldPartition(const std::string& scenePath, AssetManager& assetManager, GameObject::Map& gameObjects);
+        WorldPartition(const std::string& scenePath, AssetManager& assetManager, GameObject::Map& gameObjects,
+            const Settings& settings);
+        ~WorldPartition();
+
+        WorldPartition(const WorldPartition&) = delete;
+        WorldPartition& operator=(const WorldPartition&) = delete;
+
+        // Once per frame with the viewer position, never blocks
+        void update(const glm::vec3& viewerPosition);
+        // Loads everything within loadRadius and waits for it, for the first frame
+        void loadAround(const glm::vec3& viewerPosition);
+
+        size_t getCellCount() const { return cells.size(); }
+        size_t getLoadedCellCount() const;
+        size_t getPendingCellCount() const;
+        VkDeviceSize getLoadedBytes() const { return loadedBytes; }
+
+    private:
+        enum class CellState { Unloaded, Loading, Loaded };
+
+        struct Cell {
+            int32_t x = 0;
+            int32_t z = 0;
+            std::vector<uint32_t> entities{}; // into scene.entities
+            std::vector<uint32_t> models{};   // distinct scene.models the entities use
+            CellState state = CellState::Unloaded;
+            std::future<std::vector<std::shared_ptr<Model>>> pendingModels{}; // same order as models
+            std::vector<GameObject::id_t> gameObjects{};
+            VkDeviceSize bytes = 0;
+        };
+
+        static uint64_t getCellKey(int32_t x, int32_t z);
+        // distance from the viewer to the nearest point of the cell
+        float getDistance(const Cell& cell, const glm::vec3& viewerPosition) const;
+
+        void startLoad(Cell& cell);
+        void finishLoad(Cell& cell);
+        void unload(Cell& cell);
+
+        SceneFile scene;
+        AssetManager& assetManager;
+        GameObject::Map& gameObjects;
+        Settings settings;
+        std::unordered_map<uint64_t, Cell> cells;
+        VkDeviceSize loadedBytes = 0;
+    };
+}
@@ -0,0 +1,116 @@
+// Asset packer: every cooked asset below a directory -> one .pak archive, entries named by their relative path.
+// usage: AssetPacker <output.pak> <root> [--store] [--ext .obj,.spv,.ctex,.cscene]
+
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::vector<std::string> splitExtensions(const std::string& list)
+    {
+        std::vector<std::string> extensions;
+        size_t begin = 0;
+        while(begin <= list.size()) {
+            size_t end = std::min(list.find(',', begin), list.size());
+            if(end > begin) extensions.push_back(list.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return extensions;
+    }
+
+    std::vector<char> readWholeFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open()) {
+            throw std::runtime_error("failed to open file: " + path.string());
+        }
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: AssetPacker <output.pak> <root> [--store] [--ext .obj,.spv,.ctex,.cscene]\n"
+                  << "  --store  no LZ4 compression, every entry is mapped in place\n"
+                  << "  --ext    file extensions to pack (default .obj,.spv,.ctex,.cscene)\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        namespace fs = std::filesystem;
+        const std::string output = argv[1];
+        const fs::path root = argv[2];
+        bool compress = true;
+        std::vector<std::string> extensions{".obj", ".spv", ".ctex", ".cscene"};
+
+        for(int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            if(arg == "--store") {
+                compress = false;
+            } else if(arg == "--ext" && i + 1 < argc) {
+                extensions = splitExtensions(argv[++i]);
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+
+        // sorted so the same inputs always give the same archive
+        std::vector<std::string> names;
+        for(const auto& item : fs::recursive_directory_iterator(root)) {
+            if(!item.is_regular_file()) continue;
+            const std::string extension = item.path().extension().string();
+            if(std::find(extensions.begin(), extensions.end(), extension) == extensions.end()) continue;
+            names.push_back(item.path().lexically_relative(root).generic_string());
+        }
+        std::sort(names.begin(), names.end());
+        if(names.empty()) {
+            throw std::runtime_error("no assets found below " + root.string());
+        }
+
+        std::vector<std::vector<char>> data(names.size());
+        uint64_t sourceBytes = 0;
+        for(size_t i = 0; i < names.size(); i++) {
+            data[i] = readWholeFile(root / names[i]);
+            sourceBytes += data[i].size();
+        }
+
+        Cosmos::AssetArchive::write(output, names, data, compress);
+
+        // read back, checks the table and every compressed entry
+        Cosmos::AssetArchive archive{output};
+        uint32_t compressedCount = 0;
+        for(size_t i = 0; i < names.size(); i++) {
+            const Cosmos::ArchiveEntry* entry = archive.find(names[i]);
+            if(entry == nullptr) {
+                throw std::runtime_error("entry missing after packing: " + names[i]);
+            }
+            const Cosmos::AssetData asset = archive.read(*entry);
+            if(!std::equal(data[i].begin(), data[i].end(), asset.data(), asset.data() + asset.size())) {
+                throw std::runtime_error("entry differs after packing: " + names[i]);
+            }
+            compressedCount += entry->compression == Cosmos::ArchiveCompression::LZ4;
+        }
+
+        std::cout << output << ": " << names.size() << " assets (" << compressedCount << " LZ4), "
+                  << sourceBytes / 1024 << " KiB -> " << fs::file_size(output) / 1024 << " KiB\n";
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
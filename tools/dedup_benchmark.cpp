@@ -0,0 +1,209 @@
+// Vertex deduplication benchmark: std::unordered_map (count + operator[], the former import path)
+// against DedupTable, on the triangle corners of an OBJ file or of a generated grid.
+// usage: DedupBenchmark [model.obj] [--grid N] [--repeat N]
+
+#include "dedup_table.hpp"
+#include "engine_utils.hpp"
+#include "obj_parser.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    // same layout as Model::Vertex without glm
+    struct BenchVertex {
+        float position[3];
+        float color[3];
+        float normal[3];
+        float uv[2];
+
+        bool operator==(const BenchVertex& other) const {
+            return std::memcmp(this, &other, sizeof(BenchVertex)) == 0;
+        }
+    };
+    static_assert(sizeof(BenchVertex) == 44, "BenchVertex must not contain padding");
+
+    struct CornerHash {
+        size_t operator()(const Cosmos::ObjParser::Corner& corner) const {
+            size_t seed = 0;
+            Cosmos::hashCombine(seed, corner.position, corner.texcoord, corner.normal);
+            return seed;
+        }
+    };
+
+    // what std::hash<glm::vec3> and friends amount to: hashCombine over every component
+    struct VertexHash {
+        size_t operator()(const BenchVertex& v) const {
+            size_t seed = 0;
+            Cosmos::hashCombine(seed, v.position[0], v.position[1], v.position[2], v.color[0], v.color[1], v.color[2],
+                v.normal[0], v.normal[1], v.normal[2], v.uv[0], v.uv[1]);
+            return seed;
+        }
+    };
+
+    struct Result {
+        double milliseconds = 0.0;
+        size_t uniqueCount = 0;
+    };
+
+    template<typename Function>
+    Result measure(int repeat, const Function& function)
+    {
+        Result best{};
+        best.milliseconds = 1e30;
+        for(int i = 0; i < repeat; i++) {
+            auto start = std::chrono::steady_clock::now();
+            size_t uniqueCount = function();
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best.milliseconds = std::min(best.milliseconds, elapsed);
+            best.uniqueCount = uniqueCount;
+        }
+        return best;
+    }
+
+    template<typename Key, typename Hash>
+    size_t dedupUnorderedMap(const std::vector<Key>& keys, std::vector<uint32_t>& indices)
+    {
+        std::unordered_map<Key, uint32_t, Hash> unique{};
+        indices.clear();
+        uint32_t next = 0;
+        for(const auto& key : keys) {
+            if(unique.count(key) == 0) {
+                unique[key] = next++;
+            }
+            indices.push_back(unique[key]);
+        }
+        return unique.size();
+    }
+
+    template<typename Key>
+    size_t dedupTable(const std::vector<Key>& keys, std::vector<uint32_t>& indices)
+    {
+        Cosmos::DedupTable<Key> unique{keys.size()};
+        indices.clear();
+        uint32_t next = 0;
+        for(const auto& key : keys) {
+            bool inserted = false;
+            indices.push_back(unique.findOrInsert(key, next, inserted));
+            next += inserted;
+        }
+        return unique.size();
+    }
+
+    void printRow(const std::string& name, const Result& result, double baseline)
+    {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+                  << std::setprecision(2) << result.milliseconds << " ms  " << std::setw(6) << std::setprecision(2)
+                  << baseline / result.milliseconds << "x  (" << result.uniqueCount << " unique)\n";
+    }
+
+    template<typename Key, typename Hash>
+    void runCase(const std::string& title, const std::vector<Key>& keys, int repeat)
+    {
+        std::vector<uint32_t> mapIndices, tableIndices;
+        mapIndices.reserve(keys.size());
+        tableIndices.reserve(keys.size());
+        Result map = measure(repeat, [&]() { return dedupUnorderedMap<Key, Hash>(keys, mapIndices); });
+        Result table = measure(repeat, [&]() { return dedupTable<Key>(keys, tableIndices); });
+        if(map.uniqueCount != table.uniqueCount || mapIndices != tableIndices) {
+            throw std::runtime_error("DedupTable result differs from std::unordered_map");
+        }
+
+        std::cout << title << ", " << keys.size() << " corners, " << sizeof(Key) << " byte keys\n";
+        printRow("std::unordered_map", map, map.milliseconds);
+        printRow("DedupTable", table, map.milliseconds);
+    }
+
+    // N x N quads, every vertex shared by up to six triangles like a typical closed mesh
+    void generateGrid(uint32_t size, std::vector<Cosmos::ObjParser::Corner>& corners, std::vector<BenchVertex>& vertices)
+    {
+        auto vertexAt = [size](uint32_t x, uint32_t y) {
+            BenchVertex v{};
+            v.position[0] = static_cast<float>(x);
+            v.position[1] = static_cast<float>(y);
+            v.color[0] = v.color[1] = v.color[2] = 1.f;
+            v.normal[2] = 1.f;
+            v.uv[0] = static_cast<float>(x) / size;
+            v.uv[1] = static_cast<float>(y) / size;
+            return v;
+        };
+        for(uint32_t y = 0; y < size; y++) {
+            for(uint32_t x = 0; x < size; x++) {
+                const uint32_t quad[4][2] = {{x, y}, {x + 1, y}, {x, y + 1}, {x + 1, y + 1}};
+                for(uint32_t k : {0u, 1u, 2u, 1u, 3u, 2u}) {
+                    const uint32_t index = quad[k][1] * (size + 1) + quad[k][0];
+                    corners.push_back({index, index, 0});
+                    vertices.push_back(vertexAt(quad[k][0], quad[k][1]));
+                }
+            }
+        }
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: DedupBenchmark [model.obj] [--grid N] [--repeat N]\n"
+                  << "  without a model a grid of N x N quads is generated (default 1000)\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::string modelPath;
+        uint32_t gridSize = 1000;
+        int repeat = 5;
+        for(int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if(arg == "--grid" && i + 1 < argc) {
+                gridSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if(arg == "--repeat" && i + 1 < argc) {
+                repeat = std::max(1, std::stoi(argv[++i]));
+            } else if(!arg.empty() && arg[0] != '-' && modelPath.empty()) {
+                modelPath = arg;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+
+        std::vector<Cosmos::ObjParser::Corner> corners;
+        std::vector<BenchVertex> vertices;
+        if(modelPath.empty()) {
+            generateGrid(gridSize, corners, vertices);
+            modelPath = "grid " + std::to_string(gridSize) + "x" + std::to_string(gridSize);
+        } else {
+            Cosmos::ObjParser parser{modelPath};
+            parser.parse([&](const Cosmos::ObjParser::Corner* batch, size_t count) {
+                const auto& attributes = parser.getAttributes();
+                for(size_t i = 0; i < count; i++) {
+                    const auto& corner = batch[i];
+                    BenchVertex v{};
+                    std::memcpy(v.position, &attributes.positions[3 * corner.position], sizeof(v.position));
+                    std::memcpy(v.color, &attributes.colors[3 * corner.position], sizeof(v.color));
+                    if(corner.normal != Cosmos::ObjParser::NO_INDEX)
+                        std::memcpy(v.normal, &attributes.normals[3 * corner.normal], sizeof(v.normal));
+                    if(corner.texcoord != Cosmos::ObjParser::NO_INDEX)
+                        std::memcpy(v.uv, &attributes.texcoords[2 * corner.texcoord], sizeof(v.uv));
+                    corners.push_back(corner);
+                    vertices.push_back(v);
+                }
+            });
+        }
+
+        std::cout << modelPath << ", best of " << repeat << "\n";
+        runCase<Cosmos::ObjParser::Corner, CornerHash>("index triples (Model::Builder::loadModel)", corners, repeat);
+        runCase<BenchVertex, VertexHash>("full vertices", vertices, repeat);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
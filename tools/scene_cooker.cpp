@@ -0,0 +1,36 @@
+// Scene cooker: text scene (.scene) -> binary scene (.cscene), loaded with one copy per table.
+// usage: SceneCooker <input.scene> <output.cscene>
+
+#include "scene_file.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        std::cerr << "usage: SceneCooker <input.scene> <output.cscene>\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const std::string input = argv[1];
+        const std::string output = argv[2];
+        const Cosmos::SceneFile scene = Cosmos::SceneFile::load(input);
+        scene.writeBinary(output);
+
+        // read back so a broken file is caught here and not at load time
+        const Cosmos::SceneFile cooked = Cosmos::SceneFile::load(output);
+        if(cooked.models.size() != scene.models.size() || cooked.entities.size() != scene.entities.size()) {
+            throw std::runtime_error("cooked scene differs from " + input);
+        }
+
+        std::cout << input << " -> " << output << ": " << scene.models.size() << " models, "
+                  << scene.entities.size() << " entities\n";
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
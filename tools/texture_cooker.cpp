@@ -0,0 +1,90 @@
+// Offline texture cooker: source image (.tga/.ppm) -> .ctex with a precomputed, block compressed mip chain.
+// usage: TextureCooker <input> <output.ctex> [--format bc1|bc5|bc7|rgba8] [--linear] [--normal]
+
+#include "cooked_texture.hpp"
+#include "image_loader.hpp"
+#include "texture_compression.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+    Cosmos::CookedTextureFormat parseFormat(const std::string& name, bool srgb)
+    {
+        using Cosmos::CookedTextureFormat;
+        if(name == "bc1") return srgb ? CookedTextureFormat::BC1_SRGB : CookedTextureFormat::BC1_UNORM;
+        if(name == "bc5") return CookedTextureFormat::BC5_UNORM;
+        if(name == "bc7") return srgb ? CookedTextureFormat::BC7_SRGB : CookedTextureFormat::BC7_UNORM;
+        if(name == "rgba8") return srgb ? CookedTextureFormat::RGBA8_SRGB : CookedTextureFormat::RGBA8_UNORM;
+        throw std::runtime_error("unknown format: " + name);
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: TextureCooker <input> <output.ctex> [--format bc1|bc5|bc7|rgba8] [--linear] [--normal]\n"
+                  << "  --linear  data is not color, skip sRGB handling\n"
+                  << "  --normal  tangent space normal map, implies --linear and defaults to bc5\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const std::string input = argv[1];
+        const std::string output = argv[2];
+        std::string formatName;
+        bool srgb = true;
+        bool normalMap = false;
+
+        for(int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            if(arg == "--format" && i + 1 < argc) {
+                formatName = argv[++i];
+            } else if(arg == "--linear") {
+                srgb = false;
+            } else if(arg == "--normal") {
+                normalMap = true;
+                srgb = false;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        if(formatName.empty()) {
+            formatName = normalMap ? "bc5" : "bc7";
+        }
+        const auto format = parseFormat(formatName, srgb);
+
+        const auto source = Cosmos::loadImageFile(input);
+        const auto mips = Cosmos::TextureCompression::generateMipChain(source, srgb, normalMap);
+
+        std::vector<Cosmos::CookedTextureLevel> levels(mips.size());
+        std::vector<std::vector<uint8_t>> levelData(mips.size());
+        uint64_t sourceBytes = 0;
+        uint64_t cookedBytes = 0;
+        for(size_t mip = 0; mip < mips.size(); mip++) {
+            levels[mip].width = mips[mip].width;
+            levels[mip].height = mips[mip].height;
+            levelData[mip] = Cosmos::TextureCompression::compressImage(mips[mip], format);
+            sourceBytes += mips[mip].pixels.size();
+            cookedBytes += levelData[mip].size();
+        }
+
+        Cosmos::CookedTextureFile::write(output, format, levels, levelData);
+
+        std::cout << input << " -> " << output << ": " << source.width << "x" << source.height
+                  << ", " << mips.size() << " mips, " << formatName << ", "
+                  << sourceBytes / 1024 << " KiB -> " << cookedBytes / 1024 << " KiB" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}